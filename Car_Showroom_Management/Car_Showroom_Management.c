@@ -1,11 +1,32 @@
+#define _GNU_SOURCE  // accept4
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <math.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <stdatomic.h>
+#include <fcntl.h>
 #define MAX_SHOWROOMS 3
 #define MAX_STRING 100
 #define B_PLUS_ORDER 5  // Order of B+ tree
+#define ROLLUP_DAYS 366   // Daily sales buckets kept per rollup
+#define ROLLUP_MONTHS 24  // Calendar-month sales buckets kept per rollup
+#define SECONDS_PER_DAY 86400
+#define FORECAST_MONTHS 12  // Trailing 30-day windows fed to the forecasting models
+#define FORECAST_ALPHA 0.5  // Exponential smoothing factor
+#define MAX_WORKER_THREADS 16  // Upper bound on report threads
 
 // Enums for car types
 typedef enum {
@@ -27,12 +48,45 @@ typedef enum {
     LOAN
 } PaymentType;
 
-// Car structure
+// Money is held as a whole number of paise so sums and comparisons are exact.
+// Amounts are entered and shown in lakhs (EMIs in rupees).
+typedef int64_t Money;
+#define PAISE_PER_RUPEE 100LL
+#define PAISE_PER_LAKH 10000000LL
+#define LAKH_DIGITS 7             // Decimal places of a lakh amount that are whole paise
+#define RUPEE_DIGITS 2
+
+// Bump allocator for strings that live as long as the program
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;
+    size_t bytesUsed;
+} StringArena;
+
+// Interned strings: each distinct string is stored once and referred to by a 32-bit id
+typedef struct {
+    const char** strings;      // Id -> string (id 0 is the empty string)
+    uint32_t numStrings;
+    uint32_t stringCapacity;
+    uint32_t* slots;           // Open-addressing hash table of ids (0 = empty slot)
+    uint32_t numSlots;
+} StringDictionary;
+
+StringArena stringArena;
+StringDictionary stringDictionary;
+
+// Car structure: the fields of a car being added. Stored cars live in carColumns.
 typedef struct Car {
     char VIN[20];              // Vehicle Identification Number (primary key)
-    char name[MAX_STRING];     // Name of car
-    char color[MAX_STRING];    // Color of car
-    double price;              // Price in lakhs
+    uint32_t nameId;           // Name of car (string dictionary id)
+    uint32_t colorId;          // Color of car (string dictionary id)
+    Money price;               // Price
     FuelType fuelType;         // Fuel type
     CarType carType;           // Type of car (Hatchback, Sedan, SUV)
     bool isSold;               // Whether car is sold or not
@@ -41,27 +95,44 @@ typedef struct Car {
 
 // Customer structure
 typedef struct Customer {
-    char name[MAX_STRING];           // Name of customer
+    const char* name;                // Name of customer (stored in the string arena)
     char mobileNo[15];               // Mobile number
-    char address[MAX_STRING];        // Address
+    const char* address;             // Address (stored in the string arena)
     char VIN[20];                    // VIN of sold car
     char registrationNo[20];         // Car registration number
     PaymentType paymentType;         // Payment type (Cash/Loan)
     int emiMonths;                   // EMI duration in months (if applicable)
-    double downPayment;              // Down payment (if loan)
-    double loanAmount;               // Loan amount (if loan)
-    double emiAmount;                // Monthly EMI amount (if loan)
+    Money downPayment;               // Down payment (if loan)
+    Money loanAmount;                // Loan amount (if loan)
+    Money emiAmount;                 // Monthly EMI amount (if loan)
+    time_t saleTime;                 // When the car was sold (0 if unknown)
 } Customer;
 
+// Sales aggregated into one bucket
+typedef struct {
+    Money amount;                     // Sales value
+    int cars;                         // Number of cars sold
+} SalesBucket;
+
+// Ring buffers of daily and monthly sales buckets. Recording a sale rolls the
+// rings forward to the sale's day/month, clearing buckets that fell out of range.
+typedef struct {
+    SalesBucket days[ROLLUP_DAYS];    // Indexed by day number % ROLLUP_DAYS
+    SalesBucket months[ROLLUP_MONTHS];// Indexed by month number % ROLLUP_MONTHS
+    long newestDay;                   // Day number (UTC days since epoch) of the newest daily bucket
+    int newestMonth;                  // year * 12 + month of the newest monthly bucket
+} SalesRollup;
+
 // Sales Person structure
 typedef struct SalesPerson {
     int id;                           // Sales person ID
     char name[MAX_STRING];            // Name of sales person
-    double salesTarget;               // Monthly sales target (50 lakhs)
-    double salesAchieved;             // Sales achieved so far
-    double commission;                // Commission earned (2% of sales achieved)
+    Money salesTarget;                // Monthly sales target (50 lakhs)
+    Money salesAchieved;              // Sales achieved so far
+    Money commission;                 // Commission earned (2% of sales achieved)
     int numSales;                     // Number of cars sold
     bool extraIncentive;              // Additional 1% incentive for top performer
+    SalesRollup sales;                // Rolling daily/monthly sales
 } SalesPerson;
 
 // Showroom structure
@@ -72,13 +143,8 @@ typedef struct Showroom {
     int numTotalCars;                 // Total number of cars
     int numAvailableCars;             // Number of available cars
     int numSoldCars;                  // Number of sold cars
-    double totalSales;                // Total sales in rupees
-    double lastMonthSales;            // Sales for last month
-    double twoMonthsAgoSales;         // Sales for two months ago
-    double threeMonthsAgoSales;       // Sales for three months ago
-    int lastMonthCars;                // Number of cars sold last month
-    int twoMonthsAgoCars;             // Number of cars sold two months ago
-    int threeMonthsAgoCars;           // Number of cars sold three months ago
+    Money totalSales;                 // Total sales
+    SalesRollup sales;                // Rolling daily/monthly sales
 } Showroom;
 
 // Node structure for B+ Tree
@@ -90,15 +156,130 @@ typedef struct BPlusTreeNode {
     struct BPlusTreeNode* children[B_PLUS_ORDER]; // Children pointers
     struct BPlusTreeNode* next;           // Next leaf node (for leaf nodes only)
     int order;
+    uint8_t availableMask;                // Leaf: bit i set while data[i] is an unsold car
+    uint8_t tombstoneMask;                // Leaf: bit i set once keys[i] has been lazily deleted
+    int availableCount;                   // Unsold cars in the leaves under this node
 } BPlusTreeNode;
 
+// Bloom filter over a tree's keys: a lookup whose bits are not all set is a guaranteed
+// miss and skips the descent. Deleted keys leave their bits behind until a rebuild.
+#define BLOOM_BITS_PER_KEY 10
+#define BLOOM_HASHES 7
+#define BLOOM_MIN_KEYS 1024
+
+// Lazy deletion marks leaf slots dead instead of rebalancing. A leaf whose slots are
+// mostly dead is purged in place; leaves may drain down to minLiveKeys live keys, and
+// below that wait for the next compaction.
+#define LAZY_MIN_LIVE_KEYS 1
+
+typedef struct {
+    uint64_t* bits;
+    uint32_t numBits;          // Power of two
+    int capacity;              // Keys the filter is sized for
+    int keys;                  // Keys added since the last rebuild
+    int deletions;             // Keys removed since the last rebuild
+    // Bumped by concurrent lookups under the server's read lock, hence atomic
+    atomic_long rejected;      // Lookups answered by the filter alone
+    atomic_long falsePositives; // Lookups the filter let through that found nothing
+} BloomFilter;
+
 // B+ Tree structure
 typedef struct BPlusTree {
     BPlusTreeNode* root;
-    int type; // 1 - Car, 2 - Customer, 3 - SalesPerson, 4 - Showroom
+    int type; // 1 - Car, 2 - Customer, 3 - SalesPerson, 4 - Showroom, 5 - Sale
     int order;
+    int numKeys;               // Live keys in the leaves
+    BloomFilter* bloom;        // Optional, NULL when the tree has no filter
+    bool lazyDeletes;          // Deletes leave tombstones (see lazyDeleteKey)
+    int minLiveKeys;           // Underflow threshold for lazily deleted leaves
+    int tombstones;            // Dead slots awaiting compaction
+    int underflowLeaves;       // Leaves that fell below minLiveKeys since the last compaction
 } BPlusTree;
 
+// Shape of one or more B+ trees, accumulated by measureTree
+typedef struct {
+    int trees;
+    int height;                // Tallest tree, in levels
+    long nodes;
+    long leaves;
+    long slots;                // Keys held by all nodes, separators and tombstones included
+    long liveKeys;
+    long tombstones;
+    int minKeys;               // Fewest keys in a non-root node, -1 if every tree is a single node
+    size_t nodeBytes;
+    size_t recordBytes;        // Records the leaves point to; a record shared by trees counts in each
+    long keyLengths[20];       // Live leaf keys by length
+} TreeShape;
+
+#define MAX_MEASURED_INDEXES (8 + MAX_SHOWROOMS)
+
+typedef struct {
+    char name[40];
+    TreeShape shape;
+} IndexShape;
+
+// Hot-path counters and latency histograms. Each thread owns a block it updates without
+// locked instructions; readers sum the blocks. Build with -DNO_METRICS to compile them out.
+typedef enum {
+    COUNTER_NODE_VISITS,
+    COUNTER_KEY_COMPARISONS,
+    COUNTER_SPLITS,
+    COUNTER_MERGES,
+    COUNTER_BORROWS,
+    NUM_COUNTERS
+} Counter;
+
+typedef enum {
+    TIMER_SELL_CAR,
+    TIMER_ADD_CAR,
+    TIMER_LOAD_SHOWROOMS,
+    TIMER_LOAD_CARS,
+    TIMER_LOAD_SALESPERSONS,
+    TIMER_LOAD_CUSTOMERS,
+    TIMER_LOAD_ROLLUPS,
+    TIMER_LOAD_SALES_LOG,
+    TIMER_SAVE_ALL,
+    TIMER_SAVE_SHOWROOMS,
+    TIMER_SAVE_CARS,
+    TIMER_SAVE_SALESPERSONS,
+    TIMER_SAVE_CUSTOMERS,
+    TIMER_SAVE_ROLLUPS,
+    NUM_TIMERS
+} Timer;
+
+#define METRIC_BUCKETS 40      // Bucket b counts durations below 2^b ns; the last one holds the rest
+
+typedef struct ThreadMetrics {
+    _Atomic uint64_t counters[NUM_COUNTERS];
+    _Atomic uint64_t calls[NUM_TIMERS];
+    _Atomic uint64_t totalNs[NUM_TIMERS];
+    _Atomic uint64_t maxNs[NUM_TIMERS];
+    _Atomic uint64_t buckets[NUM_TIMERS][METRIC_BUCKETS];
+    struct ThreadMetrics* next;
+} ThreadMetrics;
+
+typedef struct {
+    Timer timer;
+    uint64_t startNs;
+} ScopeTimer;
+
+#ifdef NO_METRICS
+#define COUNT_EVENT(counter, n) ((void)0)
+#define TIME_SCOPE(timer) ((void)0)
+#else
+#define COUNT_EVENT(counter, n) metricsCount(counter, n)
+// Times the rest of the enclosing block, whichever way it is left
+#define TIME_SCOPE(timer) \
+    __attribute__((cleanup(metricsStopTimer))) ScopeTimer scopeTimer = {timer, monotonicNs()}
+#endif
+
+// One insert in a batch; key must stay valid until the batch call returns
+typedef struct {
+    const char* key;
+    void* data;
+    bool available;            // Leaf status bit (see insertWithStatus)
+} BatchEntry;
+
 // Structure to hold per-salesperson customer trees
 typedef struct {
     char salesPersonId[50];  // Salesperson ID (e.g., "1_101")
@@ -106,29 +287,495 @@ typedef struct {
 } SalesPersonCustomerTree;
 
 typedef struct {
-    Car* car;
+    int row;                   // Car row
     int showroomId;
 } ShowroomCar;
 
 // Global data structures
 BPlusTree* carTree;           // Tree for all cars
-BPlusTree* availableCarTree;  // Tree for available cars
-BPlusTree* soldCarTree;       // Tree for sold cars
+BPlusTree* availableCarTree;  // Tree for available cars (NULL in single-index mode)
+BPlusTree* soldCarTree;       // Tree for sold cars (NULL in single-index mode)
+bool singleCarIndex = false;  // Keep only carTree and track sold state in its leaves
+int lazyDeleteThreshold = -1; // --lazy-delete N: availableCarTree leaves drain to N live keys (-1 = eager)
+bool batchMode = false;       // --batch FILE: no per-operation output, saves deferred to commits
+atomic_bool snapshotHold = false; // A follower is loading the data files; commits leave them alone
+time_t saleTimeOverride = 0;  // --generate: backdates sales instead of stamping them now
 SalesPersonCustomerTree* salesPersonCustomerTrees = NULL; // Array of customer trees
 int numSalesPersonTrees = 0;  // Number of salesperson customer trees
 BPlusTree* salesPersonTrees[MAX_SHOWROOMS] = {NULL}; // Array of trees, one per showroom
 BPlusTree* showroomTree;      // Tree for showrooms
+BPlusTree* customerVinTree;   // Customers by VIN of the car they bought
+
+// Compressed bitmap over car row ids (roaring-style: one container per 65536 rows,
+// stored as a sorted array while sparse and as a plain bitset once dense)
+#define BITMAP_ARRAY_MAX 4096
+#define BITMAP_WORDS 1024
+
+typedef struct {
+    uint16_t key;          // High 16 bits of the row ids in this container
+    int cardinality;       // Number of row ids set
+    int capacity;          // Allocated slots in array
+    uint16_t* array;       // Sorted low 16 bits (array container)
+    uint64_t* words;       // 65536-bit set (bitset container), NULL for array containers
+} BitmapContainer;
+
+typedef struct {
+    BitmapContainer* containers; // Sorted by key
+    int numContainers;
+    int capacity;
+} RoaringBitmap;
+
+// Attribute query used by the inventory search (-1 / 0 mean "any")
+typedef struct {
+    int showroomId;            // 0 for all showrooms
+    int fuelType;              // -1 for any fuel type
+    int carType;               // -1 for any car type
+    Money minPrice;            // Lower price bound
+    Money maxPrice;            // Upper price bound
+    bool includeSold;          // Also return sold cars
+} CarQuery;
+
+// Secondary indexes over the car inventory
+BPlusTree* carPriceTree;       // Secondary tree keyed by zero-padded price
+RoaringBitmap fuelTypeBitmaps[HYBRID + 1];
+RoaringBitmap carTypeBitmaps[SUV + 1];
+RoaringBitmap showroomBitmaps[MAX_SHOWROOMS];
+RoaringBitmap soldCarBitmap;
+
+// The car inventory, one array per field indexed by row id. Rows are never removed.
+// The car trees, the price tree and the name index hold carRef(row) where other
+// trees hold a record pointer.
+typedef struct {
+    char (*VIN)[20];
+    uint32_t* nameId;          // String dictionary ids
+    uint32_t* colorId;
+    Money* price;
+    int* showroomId;
+    uint8_t* fuelType;
+    uint8_t* carType;
+    uint8_t* isSold;
+    int numRows;
+    int capacity;
+} CarColumns;
+
+CarColumns carColumns;
+
+// Trie over lower-cased names for prefix and approximate (edit distance) search
+typedef struct TrieNode {
+    char ch;                          // Character on the edge into this node
+    struct TrieNode* firstChild;      // Children sorted by ch
+    struct TrieNode* nextSibling;
+    void** postings;                  // Records whose full name ends at this node
+    int numPostings;
+    int capacity;
+} TrieNode;
+
+typedef struct {
+    TrieNode* root;
+    int numEntries;
+} TextIndex;
+
+TextIndex carNameIndex;       // Car model name -> carRef(row)
+TextIndex customerNameIndex;  // Customer name -> Customer*
+
+// Per-model rolling sales
+typedef struct {
+    uint32_t modelId;          // Car name (string dictionary id)
+    SalesRollup sales;
+} ModelSalesRollup;
+
+ModelSalesRollup* modelRollups = NULL;
+int numModelRollups = 0;
+
+// One row of the append-only sales log
+typedef struct {
+    long sequence;             // Position in the log
+    time_t timestamp;          // When the sale happened
+    char VIN[20];              // Car sold
+    int salesPersonId;         // Sales person who sold it
+    int showroomId;            // Showroom the sale belongs to
+    Money price;               // Sale price
+    PaymentType paymentType;   // Cash or loan
+} SaleRecord;
+
+SaleRecord** salesLog = NULL; // Sales in the order they were logged
+int numSaleRecords = 0;
+int saleRecordCapacity = 0;
+BPlusTree* salesTimeTree;     // Sales keyed by timestamp + sequence
+
+// Sales history and model outputs for a batch of showrooms, laid out so that every
+// model runs as a loop over contiguous per-showroom values
+typedef struct {
+    int numShowrooms;
+    Showroom** showrooms;      // Showroom for each column
+    double* history;           // Lakhs, FORECAST_MONTHS rows, oldest first: history[m * numShowrooms + s]
+    int* cars;                 // Cars sold, same layout as history
+    double* weightedMean;      // 50/30/20 weighted mean of the last three windows
+    double* smoothed;          // Exponentially smoothed level
+    double* trend;             // Least-squares linear trend extrapolated one window ahead
+} ForecastBatch;
+
+// Loan products offered on a sale. Rates are held in basis points (850 = 8.50%) so
+// each rate maps to exactly one factor table.
+#define NUM_LOAN_PRODUCTS 3
+#define LOAN_MAX_MONTHS 120   // Longest tenure the factor tables cover
+
+typedef struct {
+    int months;
+    int rateBasisPoints;
+} LoanProduct;
+
+LoanProduct loanProducts[NUM_LOAN_PRODUCTS] = {{36, 850}, {60, 875}, {84, 900}};
+
+// Per-rate tables built once: growth[n] = (1+r)^n and annuity[n] = r(1+r)^n / ((1+r)^n - 1),
+// the EMI per paisa of principal, so a quote is a lookup and a multiply
+typedef struct {
+    int rateBasisPoints;
+    double growth[LOAN_MAX_MONTHS + 1];
+    double annuity[LOAN_MAX_MONTHS + 1];
+} LoanRateTable;
+
+LoanRateTable** loanRateTables = NULL;
+int numLoanRateTables = 0;
+int loanRateTableCapacity = 0;
+
+// Quotes priced together; each field is its own array so the pricing loops run over contiguous values
+typedef struct {
+    int count;
+    int capacity;
+    Money* principal;
+    int* months;
+    int* rateBasisPoints;
+    double* factor;            // Annuity factor gathered from the rate table
+    Money* emi;
+    Money* totalInterest;
+} LoanQuoteBatch;
+
+typedef struct {
+    int month;
+    Money payment;
+    Money interest;
+    Money principal;           // Principal repaid this month
+    Money balance;             // Outstanding after the payment
+} AmortizationRow;
+
+// Sale transactions. Changes to existing trees and records go through the undo log
+// and are reversed on rollback. The new customer and the append-only structures
+// (customer trees, name index, rollups, sales log) are written only
+// at commit, once nothing can fail.
+typedef enum {
+    UNDO_FIELD,                // Restore saved bytes at address
+    UNDO_TREE_INSERT,          // Remove key from tree
+    UNDO_TREE_DELETE,          // Put key back into tree
+    UNDO_AVAILABILITY,         // Restore key's leaf status bit
+    UNDO_CAR_SOLD              // Clear the sold flag of a car row
+} UndoKind;
+
+typedef struct {
+    UndoKind kind;
+    BPlusTree* tree;
+    char key[20];
+    void* data;                // Value of a deleted key
+    bool available;            // Previous status bit
+    void* address;             // Field entries
+    size_t size;
+    int row;                   // Car row of UNDO_CAR_SOLD
+    unsigned char saved[sizeof(Money)];
+} UndoEntry;
+
+// A validated sale waiting for commit
+typedef struct {
+    Customer* customer;        // Not yet in any index
+    int carRow;
+    Money price;               // Price the car was staged at
+    SalesPerson* salesPerson;
+    Showroom* showroom;        // NULL if the showroom record is missing
+    BPlusTree* customerTree;
+    int showroomId;
+} PendingSale;
+
+typedef struct {
+    UndoEntry* undo;
+    int numUndo;
+    int undoCapacity;
+    PendingSale* sales;
+    int numSales;
+    int salesCapacity;
+    bool failed;               // A sale was rejected; the transaction can only roll back
+} SaleTransaction;
+
+// Commands accepted in a --batch script
+typedef enum {
+    BATCH_ADD_CAR,
+    BATCH_ADD_SALESPERSON,
+    BATCH_SELL,
+    BATCH_FIND_CAR,
+    BATCH_SEARCH_CARS,
+    BATCH_SALES_RANGE,
+    BATCH_TREE_STATS,
+    BATCH_METRICS,
+    BATCH_BEGIN,
+    BATCH_END,
+    BATCH_COMMIT,
+    NUM_BATCH_COMMANDS
+} BatchCommand;
+
+const char* batchCommandNames[NUM_BATCH_COMMANDS] = {
+    "add-car", "add-salesperson", "sell", "find-car", "search-cars", "sales-range", "tree-stats", "metrics", "begin", "end", "commit"
+};
+
+typedef enum {
+    BATCH_DONE,
+    BATCH_REJECTED,            // Well formed, but the operation refused it
+    BATCH_INVALID
+} BatchResult;
+
+// Records returned for a command, one comma-separated line each
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    int records;
+} ReplyBuffer;
+
+typedef struct {
+    long executed[NUM_BATCH_COMMANDS];
+    long failed[NUM_BATCH_COMMANDS];
+    long invalidLines;
+    long matches;              // Rows returned by find-car and search-cars
+    int commits;
+    int deferredCommits;       // Commits that left the files alone while a follower loaded them
+    double commitMs;           // Time spent saving the data files (queueing them with the writer thread)
+    int firstUnloggedSale;     // First salesLog entry not yet in sales_log.txt
+    bool groupOpen;            // Inside a begin/end group
+    SaleTransaction group;     // Sales of the open group
+} BatchStats;
+
+// Fixed-size worker pool used to run report scans in parallel
+typedef void (*TaskFunction)(void* arg);
+
+typedef struct {
+    TaskFunction function;
+    void* arg;
+} Task;
+
+typedef struct {
+    pthread_t threads[MAX_WORKER_THREADS];
+    int numThreads;
+    Task* queue;               // Circular task queue
+    int head;
+    int count;
+    int capacity;
+    int pending;               // Tasks submitted but not yet finished
+    bool shutdown;
+    pthread_mutex_t lock;
+    pthread_cond_t hasWork;
+    pthread_cond_t allDone;
+} ThreadPool;
+
+// A contiguous run of leaves [firstLeaf, endLeaf) covering one key range of a tree
+typedef struct {
+    BPlusTreeNode* firstLeaf;
+    BPlusTreeNode* endLeaf;    // NULL for the last range
+    char lowKey[20];           // Separator bounding the range from below ("" for the first range)
+} TreeRange;
+
+// Scans the leaves of one range into a per-range partial result
+typedef void (*LeafRangeScan)(BPlusTreeNode* firstLeaf, BPlusTreeNode* endLeaf, void* partial);
+
+typedef struct {
+    LeafRangeScan scan;
+    BPlusTreeNode* firstLeaf;
+    BPlusTreeNode* endLeaf;
+    void* partial;
+} RangeScanTask;
+
+// Growable array of record pointers used for partial report results
+typedef struct {
+    void** items;
+    int count;
+    int capacity;
+} PointerList;
+
+ThreadPool* reportPool = NULL;
+int reportThreads = 1;        // Ranges each tree is split into for parallel reports
+
+// Socket server: one epoll thread moves bytes, a worker pool runs the commands
+#define SERVER_MAX_EVENTS 64
+#define SERVER_LINE_MAX 1024
+#define LOADGEN_MAX_CLIENTS 64
+
+typedef struct ServerConnection {
+    int fd;
+    uint32_t events;           // epoll interest currently registered (0 = not registered)
+    char input[SERVER_LINE_MAX * 4];
+    size_t inputLength;
+    char request[SERVER_LINE_MAX];  // Line handed to a worker
+    ReplyBuffer records;       // Worker scratch for the records of one reply
+    ReplyBuffer output;        // Reply being sent
+    size_t outputSent;
+    bool busy;                 // A worker owns request, records and output
+    bool closing;              // Peer went away while a worker was busy
+    int command;               // Last command run, -1 if unrecognized
+    BatchResult result;
+    struct Server* server;
+    struct ServerConnection* prev;
+    struct ServerConnection* next;
+    struct ServerConnection* nextDone;
+} ServerConnection;
+
+typedef struct Server {
+    int listenFd;
+    int epollFd;
+    int wakeFd;                // eventfd the workers signal when replies are ready
+    ThreadPool* pool;
+    pthread_rwlock_t dataLock; // Shared for queries, exclusive for updates
+    BatchStats stats;          // Guarded by dataLock held exclusively
+    int commitEvery;
+    long sinceCommit;
+    pthread_mutex_t doneLock;
+    ServerConnection* doneList;
+    ServerConnection* connections;
+    long accepted;
+    long executed[NUM_BATCH_COMMANDS];
+    long failed[NUM_BATCH_COMMANDS];
+    long invalid;
+} Server;
+
+typedef struct {
+    const char* socketPath;
+    int clientId;
+    int requests;
+    int completed;
+    long errors;
+    long misses;               // Lookups of VINs never added, answered ERR as expected
+    long records;
+    uint64_t* latencies;       // Nanoseconds per completed request
+} LoadClient;
+
+#define IO_RING_SIZE 64
+
+// A file write handed to the writer thread
+typedef struct {
+    char fileName[64];
+    bool append;               // Append instead of replacing the file
+    char* data;                // Owned by the job
+    size_t length;
+    long sequence;             // Submission number of the oldest content merged into this job
+} IoJob;
+
+// Data files are serialised in memory by the caller and written by one background
+// thread, so saving never waits on the disk. Jobs queue in a bounded ring; a caller
+// only blocks when the ring is full.
+typedef struct {
+    IoJob ring[IO_RING_SIZE];
+    int head;                  // Oldest queued job
+    int count;
+    long submitted;            // Jobs submitted so far (the last sequence number)
+    bool inFlight;             // The writer holds a job outside the ring
+    long inFlightSequence;
+    bool running;
+    bool stopping;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t hasWork;
+    pthread_cond_t progress;   // A job left the ring or finished writing
+    long files;                // Jobs written
+    long bytes;
+    double writeMs;            // Time the writer spent in open/write/rename
+    long superseded;           // Rewrites replaced by a newer one before being written
+    long fullWaits;            // Times a caller found the ring full
+} IoWriter;
+
+// An output file from ioOpen: the real file without the writer thread, an in-memory
+// stream handed to the writer on ioClose with it
+typedef struct {
+    FILE* fp;
+    char fileName[64];
+    bool append;
+    bool buffered;
+    char* data;
+    size_t length;
+} IoFile;
+
+#define REPLICATION_MAX_FOLLOWERS 8
+#define REPLICATION_HEARTBEAT_MS 1000
+#define REPLICATION_LOAD_TIMEOUT_MS 60000  // How long a new follower may take to load the snapshot
+
+// Primary side of log shipping. Every mutation is appended to pending as one line and
+// a sender thread ships the lines to the followers, so a sale never waits on a replica.
+typedef struct {
+    int listenFd;
+    int followers[REPLICATION_MAX_FOLLOWERS];
+    int numFollowers;
+    pthread_mutex_t lock;
+    pthread_cond_t hasData;
+    ReplyBuffer pending;       // Lines not yet shipped
+    long sequence;             // Last sequence number assigned
+    bool stopping;
+    pthread_t thread;
+    struct Server* server;     // Its dataLock and stats take the snapshot for a new follower
+    int loadingFd;             // A new follower still loading the snapshot, or -1
+    int64_t loadingDeadlineNs; // Dropped if it has not loaded by then
+    ReplyBuffer loadingBacklog; // Records after its snapshot, sent once it has loaded
+    long shipped;              // Records shipped (once per record, not per follower)
+    int snapshots;             // Followers that joined
+} ReplicationLog;
+
+// Follower side: the applier thread replays the primary's log into this process
+typedef struct {
+    FILE* in;
+    int fd;
+    const char* primaryPath;
+    pthread_t thread;
+    pthread_mutex_t lock;      // Guards the fields below
+    long applied;              // Sequence number of the last applied record
+    long primarySequence;      // Newest sequence number the primary has reported
+    int64_t appliedTimeNs;     // Primary clock when the last applied record was published
+    long rejected;             // Records this replica could not apply
+    bool connected;
+} Replica;
+
+// Change-data-capture feed: one JSON object per line, numbered in commit order.
+// Consumers keep their position in <feed>.offsets.
+#define CDC_FLUSH_BYTES (16 * 1024)
+#define MAX_CDC_CONSUMERS 64
+
+typedef struct {
+    int fd;                    // Opened with O_APPEND
+    char path[256];
+    pthread_mutex_t lock;
+    ReplyBuffer pending;       // Events not yet written
+    long sequence;             // Last sequence number handed out
+    long events;               // Events emitted by this process
+    long writes;
+} CdcLog;
 
 // Function prototypes
+char* arenaStrdup(StringArena* arena, const char* str);
+uint32_t internString(const char* str);
+const char* stringById(uint32_t id);
+const char* carName(int row);
+const char* carColor(int row);
+const char* customerName(const Customer* customer);
+bool parseMoney(const char* text, int digits, Money* amount);
+void formatMoney(Money amount, int digits, char* buffer);
+double moneyToLakhs(Money amount);
 BPlusTree* createBPlusTree(int type);
+bool pointerListAppend(PointerList* list, void* item);
 BPlusTreeNode* createBPlusTreeNode(bool isLeaf);
 int findKeyPosition(BPlusTreeNode* node, char* key);
 void insertIntoBPlusTree(BPlusTree* tree, char* key, void* data);
 void* searchInBPlusTree(BPlusTree* tree, char* key);
-void splitChild(BPlusTreeNode* parent, int index, BPlusTreeNode* child);
-void insertNonFull(BPlusTreeNode* node, char* key, void* data);
+void splitChild(BPlusTreeNode* parent, int index, BPlusTreeNode* child, const char* key);
+void insertNonFull(BPlusTreeNode* node, char* key, void* data, bool available);
+void insertWithStatus(BPlusTree* tree, char* key, void* data, bool available);
 void deleteFromBPlusTree(BPlusTree* tree, char* key);
+bool reviveLazyKey(BPlusTree* tree, const char* key, void* data, bool available);
+void batchInsertIntoBPlusTree(BPlusTree* tree, BatchEntry* entries, int n);
+int batchDeleteFromBPlusTree(BPlusTree* tree, const char** keys, int n);
 void printBPlusTree(BPlusTree* tree);
+void displayIndexStatistics();
 BPlusTree* getCustomerTreeForSalesPerson(char* salesPersonId);
 char* carTypeToString(CarType type);
 char* fuelTypeToString(FuelType type);
@@ -137,12 +784,12 @@ CarType stringToCarType(const char* str);
 FuelType stringToFuelType(const char* str);
 PaymentType stringToPaymentType(const char* str);
 double calculateEMI(double principal, double rate, int time);
-void displayCarDetails(Car* car);
+void displayCarDetails(int row);
 void displayCustomerDetails(Customer* customer);
 void displaySalesPersonDetails(SalesPerson* person);
 void displayShowroomDetails(Showroom* showroom);
 void mergeShowroomTrees(BPlusTree* mergedTree, BPlusTree* showroom1, BPlusTree* showroom2, BPlusTree* showroom3);
-void searchSalesPersonByRange(BPlusTree* tree, double minSales, double maxSales);
+void searchSalesPersonByRange(BPlusTree* tree, Money minSales, Money maxSales);
 void saveCarsToFile();
 void loadCarsFromFile();
 void saveCustomersToFile();
@@ -151,12 +798,254 @@ void saveSalesPersonsToFile();
 void loadSalesPersonsFromFile();
 void saveShowroomsToFile();
 void loadShowroomsFromFile();
-void addCar(int showroomId, Car* car);
-void addSalesPerson(int showroomId, SalesPerson* person);
+void saveAllToFiles();
+bool addCar(int showroomId, Car* car);
+bool addSalesPerson(int showroomId, SalesPerson* person);
 void mergeAndSortShowroomsByVIN(const char* outputName);
 void displayAllCarsShowroomWise();
+void displayAvailableCars();
 void displayAllSalesPersonsShowroomWise();
 void displayCustomersForSalesPerson(int showroomId, int salesPersonId);
+BPlusTreeNode* findLeafForKey(BPlusTree* tree, const char* key);
+ThreadPool* threadPoolCreate(int numThreads);
+void threadPoolSubmit(ThreadPool* pool, TaskFunction function, void* arg);
+void threadPoolWait(ThreadPool* pool);
+void threadPoolDestroy(ThreadPool* pool);
+int partitionBPlusTree(BPlusTree* tree, int maxParts, TreeRange* ranges);
+int parallelScanTrees(BPlusTree** trees, int numTrees, LeafRangeScan scan, size_t partialSize, void** partials);
+bool pointerListAppend(PointerList* list, void* item);
+void bitmapAdd(RoaringBitmap* bitmap, uint32_t value);
+bool bitmapContains(const RoaringBitmap* bitmap, uint32_t value);
+void bitmapAnd(RoaringBitmap* result, const RoaringBitmap* a, const RoaringBitmap* b);
+void bitmapFree(RoaringBitmap* bitmap);
+void* carRef(int row);
+int carRow(const void* ref);
+int findCarRow(const char* VIN);
+int assignCarRow(const Car* car);
+int registerCarRow(const Car* car);
+void markCarRowSold(int row);
+int appendCarColumns(const Car* car);
+void freeCarColumns();
+int searchCarsByAttributes(const CarQuery* query, int** results);
+void textIndexInsert(TextIndex* index, const char* text, void* record);
+int textIndexPrefixSearch(TextIndex* index, const char* prefix, void*** results, int maxResults);
+int textIndexFuzzySearch(TextIndex* index, const char* query, int maxDistance, void*** results, int maxResults);
+void textIndexFree(TextIndex* index);
+long dayNumber(time_t t);
+int monthNumber(time_t t);
+void formatDate(time_t t, char* buffer, size_t size);
+void rollupRecord(SalesRollup* rollup, time_t when, Money amount, int cars);
+SalesBucket rollupWindow(const SalesRollup* rollup, time_t now, int fromDaysAgo, int toDaysAgo);
+SalesRollup* getModelRollup(uint32_t modelId);
+void saveSalesRollupsToFile();
+FILE* ioOpen(IoFile* file, const char* fileName, const char* mode);
+void ioClose(IoFile* file);
+void ioFlush();
+void printIoStatistics();
+void publishMutation(const char* format, ...);
+const char* replicationField(const char* text, char* out, size_t size);
+bool startReplication(Server* server, const char* socketPath);
+void cdcCarEvent(const char* op, int row);
+void cdcCustomerEvent(const char* op, const Customer* customer);
+void cdcLoanRequoteEvent(const Customer* customer, int rateBasisPoints, Money quotedEmi);
+void cdcSalesPersonEvent(const char* op, int showroomId, const SalesPerson* person);
+void cdcShowroomEvent(const Showroom* showroom);
+void cdcFlush();
+uint64_t monotonicNs();
+void metricsCount(Counter counter, uint64_t n);
+void metricsStopTimer(ScopeTimer* scope);
+void displayMetrics();
+void replyMetrics(ReplyBuffer* reply);
+void stopReplication(const char* socketPath);
+bool loadSalesRollupsFromFile();
+SaleRecord* appendSaleRecord(time_t timestamp, const char* VIN, int showroomId, int salesPersonId,
+                             Money price, PaymentType paymentType);
+bool loadSalesLogFromFile();
+void displaySalesBetweenDates(time_t from, time_t to);
+ForecastBatch* buildForecastBatch(Showroom** showrooms, int numShowrooms, time_t now);
+void runForecastModels(ForecastBatch* batch);
+void freeForecastBatch(ForecastBatch* batch);
+LoanRateTable* getLoanRateTable(int rateBasisPoints);
+LoanProduct* findLoanProduct(int months);
+Money quoteEMI(Money principal, int months, int rateBasisPoints);
+
+// String arena and dictionary
+char* arenaStrdup(StringArena* arena, const char* str) {
+    size_t length = strlen(str) + 1;
+    if (arena->head == NULL || arena->head->size - arena->head->used < length) {
+        size_t size = length > 65536 ? length : 65536;
+        ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + size);
+        if (block == NULL) {
+            fprintf(stderr, "Memory allocation failed for string arena\n");
+            exit(EXIT_FAILURE);
+        }
+        block->next = arena->head;
+        block->used = 0;
+        block->size = size;
+        arena->head = block;
+    }
+    char* copy = arena->head->data + arena->head->used;
+    memcpy(copy, str, length);
+    arena->head->used += length;
+    arena->bytesUsed += length;
+    return copy;
+}
+
+void freeStringArena(StringArena* arena) {
+    while (arena->head != NULL) {
+        ArenaBlock* next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+    arena->bytesUsed = 0;
+}
+
+uint32_t hashString(const char* str) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (const unsigned char* p = (const unsigned char*)str; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+void growStringDictionary(StringDictionary* dict) {
+    uint32_t numSlots = dict->numSlots == 0 ? 1024 : dict->numSlots * 2;
+    uint32_t* slots = (uint32_t*)calloc(numSlots, sizeof(uint32_t));
+    if (slots == NULL) {
+        fprintf(stderr, "Memory allocation failed for string dictionary\n");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t id = 1; id < dict->numStrings; id++) {
+        uint32_t slot = hashString(dict->strings[id]) & (numSlots - 1);
+        while (slots[slot] != 0) slot = (slot + 1) & (numSlots - 1);
+        slots[slot] = id;
+    }
+    free(dict->slots);
+    dict->slots = slots;
+    dict->numSlots = numSlots;
+}
+
+// Returns the id of str, adding it to the dictionary the first time it is seen
+uint32_t internString(const char* str) {
+    StringDictionary* dict = &stringDictionary;
+    if (str == NULL || str[0] == '\0') {
+        return 0;
+    }
+    if (dict->numStrings == 0) {
+        dict->stringCapacity = 1024;
+        dict->strings = (const char**)malloc(dict->stringCapacity * sizeof(char*));
+        if (dict->strings == NULL) {
+            fprintf(stderr, "Memory allocation failed for string dictionary\n");
+            exit(EXIT_FAILURE);
+        }
+        dict->strings[0] = "";
+        dict->numStrings = 1;
+    }
+    if ((dict->numStrings + 1) * 2 > dict->numSlots) {
+        growStringDictionary(dict);
+    }
+    uint32_t slot = hashString(str) & (dict->numSlots - 1);
+    while (dict->slots[slot] != 0) {
+        if (strcmp(dict->strings[dict->slots[slot]], str) == 0) {
+            return dict->slots[slot];
+        }
+        slot = (slot + 1) & (dict->numSlots - 1);
+    }
+    if (dict->numStrings == dict->stringCapacity) {
+        const char** temp = (const char**)realloc(dict->strings, dict->stringCapacity * 2 * sizeof(char*));
+        if (temp == NULL) {
+            fprintf(stderr, "Memory allocation failed for string dictionary\n");
+            exit(EXIT_FAILURE);
+        }
+        dict->strings = temp;
+        dict->stringCapacity *= 2;
+    }
+    uint32_t id = dict->numStrings++;
+    dict->strings[id] = arenaStrdup(&stringArena, str);
+    dict->slots[slot] = id;
+    return id;
+}
+
+const char* stringById(uint32_t id) {
+    return id < stringDictionary.numStrings ? stringDictionary.strings[id] : "";
+}
+
+const char* carName(int row) {
+    return stringById(carColumns.nameId[row]);
+}
+
+const char* carColor(int row) {
+    return stringById(carColumns.colorId[row]);
+}
+
+const char* customerName(const Customer* customer) {
+    return customer->name ? customer->name : "";
+}
+
+// Money
+// Parses a decimal amount with up to `digits` places (LAKH_DIGITS or RUPEE_DIGITS)
+// exactly into paise; no floating point is involved. Only whitespace may follow the number.
+bool parseMoney(const char* text, int digits, Money* amount) {
+    const char* p = text;
+    while (isspace((unsigned char)*p)) p++;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    if (!isdigit((unsigned char)*p) && !(*p == '.' && isdigit((unsigned char)p[1]))) {
+        return false;
+    }
+    Money whole = 0, fraction = 0;
+    for (; isdigit((unsigned char)*p); p++) {
+        if (whole > (INT64_MAX / 10 - 9) / PAISE_PER_LAKH) return false;
+        whole = whole * 10 + (*p - '0');
+    }
+    int places = 0;
+    if (*p == '.') {
+        for (p++; isdigit((unsigned char)*p); p++) {
+            if (places < digits) {
+                fraction = fraction * 10 + (*p - '0');
+                places++;
+            }
+        }
+    }
+    while (isspace((unsigned char)*p)) p++;
+    if (*p != '\0') {
+        return false;
+    }
+    for (; places < digits; places++) {
+        fraction *= 10;
+    }
+    Money unit = digits == LAKH_DIGITS ? PAISE_PER_LAKH : PAISE_PER_RUPEE;
+    *amount = whole * unit + fraction;
+    if (negative) *amount = -*amount;
+    return true;
+}
+
+// Writes amount in lakhs or rupees with as many decimals as needed to be exact (at least two)
+void formatMoney(Money amount, int digits, char* buffer) {
+    Money unit = digits == LAKH_DIGITS ? PAISE_PER_LAKH : PAISE_PER_RUPEE;
+    unsigned long long magnitude = amount < 0 ? 0ULL - (unsigned long long)amount : (unsigned long long)amount;
+    unsigned long long fraction = magnitude % (unsigned long long)unit;
+    int places = digits;
+    while (places > 2 && fraction % 10 == 0) {
+        fraction /= 10;
+        places--;
+    }
+    sprintf(buffer, "%s%llu.%0*llu", amount < 0 ? "-" : "", magnitude / (unsigned long long)unit, places, fraction);
+}
+
+double moneyToLakhs(Money amount) {
+    return (double)amount / PAISE_PER_LAKH;
+}
+
+double moneyToRupees(Money amount) {
+    return (double)amount / PAISE_PER_RUPEE;
+}
+
+// Reads one amount in lakhs from stdin
+bool scanLakhs(Money* amount) {
+    char text[32];
+    return scanf("%31s", text) == 1 && parseMoney(text, LAKH_DIGITS, amount);
+}
 
 // B+ Tree operations
 BPlusTree* createBPlusTree(int type) {
@@ -168,9 +1057,105 @@ BPlusTree* createBPlusTree(int type) {
     tree->root = NULL;
     tree->type = type;
     tree->order = B_PLUS_ORDER;
+    tree->numKeys = 0;
+    tree->bloom = NULL;
+    tree->lazyDeletes = false;
+    tree->minLiveKeys = LAZY_MIN_LIVE_KEYS;
+    tree->tombstones = 0;
+    tree->underflowLeaves = 0;
     return tree;
 }
 
+// Two independent halves of a 64-bit FNV-1a hash; probe i is h1 + i * h2
+void bloomHashes(const char* key, uint32_t* h1, uint32_t* h2) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char* p = (const unsigned char*)key; *p; p++) {
+        hash = (hash ^ *p) * 1099511628211ULL;
+    }
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 32;
+    *h1 = (uint32_t)hash;
+    *h2 = (uint32_t)(hash >> 32) | 1u;
+}
+
+void bloomAdd(BloomFilter* bloom, const char* key) {
+    uint32_t h1, h2;
+    bloomHashes(key, &h1, &h2);
+    uint32_t mask = bloom->numBits - 1;
+    for (int i = 0; i < BLOOM_HASHES; i++) {
+        uint32_t bit = (h1 + (uint32_t)i * h2) & mask;
+        bloom->bits[bit >> 6] |= 1ULL << (bit & 63);
+    }
+    bloom->keys++;
+}
+
+bool bloomMayContain(const BloomFilter* bloom, const char* key) {
+    uint32_t h1, h2;
+    bloomHashes(key, &h1, &h2);
+    uint32_t mask = bloom->numBits - 1;
+    for (int i = 0; i < BLOOM_HASHES; i++) {
+        uint32_t bit = (h1 + (uint32_t)i * h2) & mask;
+        if (!(bloom->bits[bit >> 6] & (1ULL << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sizes a fresh filter for twice the tree's current keys and re-adds them from the leaf chain
+void rebuildBloomFilter(BPlusTree* tree) {
+    BPlusTreeNode* first = tree->root;
+    while (first && !first->isLeaf) first = first->children[0];
+    int count = 0;
+    for (BPlusTreeNode* leaf = first; leaf != NULL; leaf = leaf->next) {
+        count += leaf->numKeys;
+    }
+    int capacity = count * 2 > BLOOM_MIN_KEYS ? count * 2 : BLOOM_MIN_KEYS;
+    uint32_t numBits = 64;
+    while (numBits < (uint32_t)capacity * BLOOM_BITS_PER_KEY) numBits <<= 1;
+
+    BloomFilter* bloom = tree->bloom;
+    uint64_t* bits = (uint64_t*)calloc(numBits / 64, sizeof(uint64_t));
+    if (bits == NULL) {
+        fprintf(stderr, "Memory allocation failed for Bloom filter\n");
+        exit(EXIT_FAILURE);
+    }
+    free(bloom->bits);
+    bloom->bits = bits;
+    bloom->numBits = numBits;
+    bloom->capacity = capacity;
+    bloom->keys = 0;
+    bloom->deletions = 0;
+    for (BPlusTreeNode* leaf = first; leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->numKeys; i++) {
+            bloomAdd(bloom, leaf->keys[i]);
+        }
+    }
+}
+
+void enableBloomFilter(BPlusTree* tree) {
+    if (tree->bloom != NULL) return;
+    tree->bloom = (BloomFilter*)calloc(1, sizeof(BloomFilter));
+    if (tree->bloom == NULL) {
+        fprintf(stderr, "Memory allocation failed for Bloom filter\n");
+        exit(EXIT_FAILURE);
+    }
+    rebuildBloomFilter(tree);
+}
+
+void freeBloomFilter(BPlusTree* tree) {
+    if (tree == NULL || tree->bloom == NULL) return;
+    free(tree->bloom->bits);
+    free(tree->bloom);
+    tree->bloom = NULL;
+}
+
+// Probability a missing key passes the filter: (1 - e^(-k * n / m))^k
+double bloomExpectedFalsePositiveRate(const BloomFilter* bloom) {
+    return pow(1.0 - exp(-(double)BLOOM_HASHES * bloom->keys / bloom->numBits), BLOOM_HASHES);
+}
+
 BPlusTreeNode* createBPlusTreeNode(bool isLeaf) {
     BPlusTreeNode* node = (BPlusTreeNode*)malloc(sizeof(BPlusTreeNode));
     if (node == NULL) {
@@ -181,6 +1166,9 @@ BPlusTreeNode* createBPlusTreeNode(bool isLeaf) {
     node->numKeys = 0;
     node->next = NULL;
     node->order = B_PLUS_ORDER;
+    node->availableMask = 0;
+    node->tombstoneMask = 0;
+    node->availableCount = 0;
     for (int i = 0; i < B_PLUS_ORDER - 1; i++) {
         strcpy(node->keys[i], "");
         node->data[i] = NULL;
@@ -199,28 +1187,67 @@ int findKeyPosition(BPlusTreeNode* node, char* key) {
     return i;
 }
 
-void splitChild(BPlusTreeNode* parent, int index, BPlusTreeNode* child) {
+int countBits(unsigned int mask) {
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1) {
+        count++;
+    }
+    return count;
+}
+
+void recountAvailable(BPlusTreeNode* node) {
+    if (node->isLeaf) {
+        node->availableCount = countBits(node->availableMask);
+        return;
+    }
+    node->availableCount = 0;
+    for (int i = 0; i <= node->numKeys; i++) {
+        if (node->children[i] != NULL) {
+            node->availableCount += node->children[i]->availableCount;
+        }
+    }
+}
+
+// Splits the full child ahead of inserting key. The left half keeps keys[0..mid-1]. A leaf
+// copies its last kept key up as the separator (B+ leaves hold every key); an internal node
+// moves keys[mid] up and keeps children[0..mid], and the new node takes the rest. When key
+// goes past the end of the last leaf (VIN-ordered loads, ascending sale times) the leaf stays
+// full and key starts the new one, so appends leave full leaves behind.
+void splitChild(BPlusTreeNode* parent, int index, BPlusTreeNode* child, const char* key) {
+    COUNT_EVENT(COUNTER_SPLITS, 1);
     BPlusTreeNode* newNode = createBPlusTreeNode(child->isLeaf);
     int mid = (B_PLUS_ORDER - 1) / 2;
+    if (child->isLeaf && child->next == NULL && strcmp(key, child->keys[child->numKeys - 1]) > 0) {
+        mid = child->numKeys;
+    }
 
-    for (int i = 0; i < mid; i++) {
-        strcpy(newNode->keys[i], child->keys[i + mid]);
-        newNode->data[i] = child->data[i + mid];
+    int first = child->isLeaf ? mid : mid + 1;
+    int moved = child->numKeys - first;
+    for (int i = 0; i < moved; i++) {
+        strcpy(newNode->keys[i], child->keys[first + i]);
+        newNode->data[i] = child->data[first + i];
     }
 
     if (!child->isLeaf) {
-        for (int i = 0; i <= mid; i++) {
-            newNode->children[i] = child->children[i + mid];
+        for (int i = 0; i <= moved; i++) {
+            newNode->children[i] = child->children[first + i];
+            child->children[first + i] = NULL;
         }
     }
 
-    newNode->numKeys = mid;
+    newNode->numKeys = moved;
     child->numKeys = mid;
 
     if (child->isLeaf) {
         newNode->next = child->next;
         child->next = newNode;
+        newNode->availableMask = (uint8_t)(child->availableMask >> mid);
+        child->availableMask &= (uint8_t)((1u << mid) - 1);
+        newNode->tombstoneMask = (uint8_t)(child->tombstoneMask >> mid);
+        child->tombstoneMask &= (uint8_t)((1u << mid) - 1);
     }
+    recountAvailable(child);
+    recountAvailable(newNode);
 
     for (int i = parent->numKeys; i > index; i--) {
         strcpy(parent->keys[i], parent->keys[i - 1]);
@@ -228,45 +1255,72 @@ void splitChild(BPlusTreeNode* parent, int index, BPlusTreeNode* child) {
         parent->children[i + 1] = parent->children[i];
     }
 
-    strcpy(parent->keys[index], child->keys[mid - 1]);
-    parent->data[index] = child->data[mid - 1];
+    int separator = child->isLeaf ? mid - 1 : mid;
+    strcpy(parent->keys[index], child->keys[separator]);
+    parent->data[index] = child->data[separator];
     parent->children[index + 1] = newNode;
     parent->numKeys++;
 }
 
-void insertNonFull(BPlusTreeNode* node, char* key, void* data) {
+void insertNonFull(BPlusTreeNode* node, char* key, void* data, bool available) {
     int i = node->numKeys - 1;
 
+    if (available) {
+        node->availableCount++;
+    }
+    COUNT_EVENT(COUNTER_NODE_VISITS, 1);
     if (node->isLeaf) {
         while (i >= 0 && strcmp(node->keys[i], key) > 0) {
             strcpy(node->keys[i + 1], node->keys[i]);
             node->data[i + 1] = node->data[i];
             i--;
         }
+        COUNT_EVENT(COUNTER_KEY_COMPARISONS, node->numKeys - i - (i < 0));
         strcpy(node->keys[i + 1], key);
         node->data[i + 1] = data;
         node->numKeys++;
+        unsigned int below = (1u << (i + 1)) - 1;
+        node->availableMask = (uint8_t)((node->availableMask & below) | ((node->availableMask & ~below) << 1) |
+                                        (available ? 1u << (i + 1) : 0));
+        node->tombstoneMask = (uint8_t)((node->tombstoneMask & below) | ((node->tombstoneMask & ~below) << 1));
     } else {
-        while (i >= 0 && strcmp(node->keys[i], key) > 0) {
+        // A key equal to a separator belongs to the left child, as in searchInBPlusTree;
+        // this matters when a deleted key whose separator survived is inserted again
+        while (i >= 0 && strcmp(node->keys[i], key) >= 0) {
             i--;
         }
+        COUNT_EVENT(COUNTER_KEY_COMPARISONS, node->numKeys - i - (i < 0));
         i++;
         if (node->children[i]->numKeys == B_PLUS_ORDER - 1) {
-            splitChild(node, i, node->children[i]);
+            splitChild(node, i, node->children[i], key);
             if (strcmp(key, node->keys[i]) > 0) {
                 i++;
             }
         }
-        insertNonFull(node->children[i], key, data);
+        insertNonFull(node->children[i], key, data, available);
     }
 }
 
-void insertIntoBPlusTree(BPlusTree* tree, char* key, void* data) {
+// Inserts key and flags the entry as an available car in the leaf status bits
+void insertWithStatus(BPlusTree* tree, char* key, void* data, bool available) {
+    // A key deleted lazily takes its dead slot back instead of sitting beside it
+    if (tree->lazyDeletes && reviveLazyKey(tree, key, data, available)) {
+        return;
+    }
+    if (tree->bloom != NULL) {
+        if (tree->bloom->keys >= tree->bloom->capacity) {
+            rebuildBloomFilter(tree);
+        }
+        bloomAdd(tree->bloom, key);
+    }
+    tree->numKeys++;
     if (tree->root == NULL) {
         tree->root = createBPlusTreeNode(true);
         strcpy(tree->root->keys[0], key);
         tree->root->data[0] = data;
         tree->root->numKeys = 1;
+        tree->root->availableMask = available ? 1 : 0;
+        tree->root->availableCount = available ? 1 : 0;
         return;
     }
 
@@ -274,14 +1328,74 @@ void insertIntoBPlusTree(BPlusTree* tree, char* key, void* data) {
         BPlusTreeNode* newRoot = createBPlusTreeNode(false);
         newRoot->children[0] = tree->root;
         tree->root = newRoot;
-        splitChild(newRoot, 0, newRoot->children[0]);
+        splitChild(newRoot, 0, newRoot->children[0], key);
+        recountAvailable(newRoot);
         int i = 0;
         if (strcmp(newRoot->keys[0], key) < 0) {
             i++;
         }
-        insertNonFull(newRoot->children[i], key, data);
+        if (available) {
+            newRoot->availableCount++;
+        }
+        insertNonFull(newRoot->children[i], key, data, available);
     } else {
-        insertNonFull(tree->root, key, data);
+        insertNonFull(tree->root, key, data, available);
+    }
+}
+
+void insertIntoBPlusTree(BPlusTree* tree, char* key, void* data) {
+    insertWithStatus(tree, key, data, false);
+}
+
+// Flips the status bit of key's leaf entry and fixes the counts on the path to it
+void setAvailability(BPlusTree* tree, const char* key, bool available) {
+    BPlusTreeNode* path[64];
+    int depth = 0;
+    BPlusTreeNode* current = tree->root;
+    if (current == NULL) {
+        return;
+    }
+    while (!current->isLeaf && depth < 63) {
+        path[depth++] = current;
+        int i = 0;
+        while (i < current->numKeys && strcmp(key, current->keys[i]) > 0) {
+            i++;
+        }
+        current = current->children[i];
+    }
+    for (int i = 0; i < current->numKeys; i++) {
+        if (strcmp(current->keys[i], key) != 0) {
+            continue;
+        }
+        bool wasAvailable = (current->availableMask >> i) & 1u;
+        if (wasAvailable == available) {
+            return;
+        }
+        int delta = available ? 1 : -1;
+        current->availableMask ^= (uint8_t)(1u << i);
+        current->availableCount += delta;
+        for (int d = 0; d < depth; d++) {
+            path[d]->availableCount += delta;
+        }
+        return;
+    }
+}
+
+// Visits unsold cars in VIN order, skipping subtrees whose cars are all sold
+void collectAvailableCars(BPlusTreeNode* node, PointerList* list) {
+    if (node == NULL || node->availableCount == 0) {
+        return;
+    }
+    if (node->isLeaf) {
+        for (int i = 0; i < node->numKeys; i++) {
+            if ((node->availableMask >> i) & 1u) {
+                pointerListAppend(list, node->data[i]);
+            }
+        }
+        return;
+    }
+    for (int i = 0; i <= node->numKeys; i++) {
+        collectAvailableCars(node->children[i], list);
     }
 }
 
@@ -289,25 +1403,291 @@ void* searchInBPlusTree(BPlusTree* tree, char* key) {
     if (tree->root == NULL) {
         return NULL;
     }
+    if (tree->bloom != NULL && !bloomMayContain(tree->bloom, key)) {
+        atomic_fetch_add_explicit(&tree->bloom->rejected, 1, memory_order_relaxed);
+        return NULL;
+    }
 
     BPlusTreeNode* current = tree->root;
+    uint64_t visits = 1, comparisons = 0;
     while (!current->isLeaf) {
         int i = 0;
         while (i < current->numKeys && strcmp(key, current->keys[i]) > 0) {
             i++;
         }
+        comparisons += i + (i < current->numKeys);
+        visits++;
         current = current->children[i];
     }
 
     for (int i = 0; i < current->numKeys; i++) {
-        if (strcmp(current->keys[i], key) == 0) {
+        if (strcmp(current->keys[i], key) == 0 && !((current->tombstoneMask >> i) & 1u)) {
+            COUNT_EVENT(COUNTER_NODE_VISITS, visits);
+            COUNT_EVENT(COUNTER_KEY_COMPARISONS, comparisons + i + 1);
             return current->data[i];
         }
     }
+    COUNT_EVENT(COUNTER_NODE_VISITS, visits);
+    COUNT_EVENT(COUNTER_KEY_COMPARISONS, comparisons + current->numKeys);
+    if (tree->bloom != NULL) {
+        atomic_fetch_add_explicit(&tree->bloom->falsePositives, 1, memory_order_relaxed);
+    }
     return NULL;
 }
 
-// Helper function to get or create a customer tree for a salesperson
+// Leftmost leaf that can hold keys >= key; walk ->next from here for range scans
+BPlusTreeNode* findLeafForKey(BPlusTree* tree, const char* key) {
+    BPlusTreeNode* current = tree->root;
+    if (current == NULL) {
+        return NULL;
+    }
+    while (!current->isLeaf) {
+        int i = 0;
+        while (i < current->numKeys && strcmp(key, current->keys[i]) > 0) {
+            i++;
+        }
+        current = current->children[i];
+    }
+    return current;
+}
+
+// Thread pool
+void* threadPoolWorker(void* arg) {
+    ThreadPool* pool = (ThreadPool*)arg;
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (pool->count == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->hasWork, &pool->lock);
+        }
+        if (pool->count == 0 && pool->shutdown) {
+            break;
+        }
+        Task task = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        pthread_mutex_unlock(&pool->lock);
+
+        task.function(task.arg);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->pending--;
+        if (pool->pending == 0) {
+            pthread_cond_broadcast(&pool->allDone);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool* threadPoolCreate(int numThreads) {
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > MAX_WORKER_THREADS) numThreads = MAX_WORKER_THREADS;
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        fprintf(stderr, "Memory allocation failed for ThreadPool\n");
+        exit(EXIT_FAILURE);
+    }
+    pool->capacity = 64;
+    pool->queue = (Task*)malloc(pool->capacity * sizeof(Task));
+    if (pool->queue == NULL) {
+        fprintf(stderr, "Memory allocation failed for ThreadPool\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->hasWork, NULL);
+    pthread_cond_init(&pool->allDone, NULL);
+    for (int i = 0; i < numThreads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, threadPoolWorker, pool) != 0) {
+            break;
+        }
+        pool->numThreads++;
+    }
+    return pool;
+}
+
+void threadPoolSubmit(ThreadPool* pool, TaskFunction function, void* arg) {
+    pthread_mutex_lock(&pool->lock);
+    if (pool->count == pool->capacity) {
+        int newCapacity = pool->capacity * 2;
+        Task* temp = (Task*)malloc(newCapacity * sizeof(Task));
+        if (temp == NULL) {
+            pthread_mutex_unlock(&pool->lock);
+            function(arg);  // Run inline rather than drop the task
+            return;
+        }
+        for (int i = 0; i < pool->count; i++) {
+            temp[i] = pool->queue[(pool->head + i) % pool->capacity];
+        }
+        free(pool->queue);
+        pool->queue = temp;
+        pool->head = 0;
+        pool->capacity = newCapacity;
+    }
+    pool->queue[(pool->head + pool->count) % pool->capacity] = (Task){function, arg};
+    pool->count++;
+    pool->pending++;
+    pthread_cond_signal(&pool->hasWork);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void threadPoolWait(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->allDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void threadPoolDestroy(ThreadPool* pool) {
+    if (pool == NULL) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->hasWork);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->numThreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->hasWork);
+    pthread_cond_destroy(&pool->allDone);
+    free(pool->queue);
+    free(pool);
+}
+
+// Tree partitioning for parallel scans
+BPlusTreeNode* leftmostLeaf(BPlusTreeNode* node) {
+    while (node != NULL && !node->isLeaf) {
+        node = node->children[0];
+    }
+    return node;
+}
+
+// Splits the tree into at most maxParts disjoint leaf ranges. The upper levels are
+// expanded until there are at least maxParts subtrees; neighbouring subtrees are then
+// grouped, so each range boundary is a separator key from an internal node.
+int partitionBPlusTree(BPlusTree* tree, int maxParts, TreeRange* ranges) {
+    if (tree == NULL || tree->root == NULL || maxParts < 1) {
+        return 0;
+    }
+    int capacity = maxParts * B_PLUS_ORDER;
+    BPlusTreeNode** level = (BPlusTreeNode**)malloc(capacity * sizeof(BPlusTreeNode*));
+    BPlusTreeNode** nextLevel = (BPlusTreeNode**)malloc(capacity * sizeof(BPlusTreeNode*));
+    char (*lowKeys)[20] = malloc(capacity * sizeof(*lowKeys));
+    char (*nextLowKeys)[20] = malloc(capacity * sizeof(*nextLowKeys));
+    if (!level || !nextLevel || !lowKeys || !nextLowKeys) {
+        free(level);
+        free(nextLevel);
+        free(lowKeys);
+        free(nextLowKeys);
+        ranges[0].firstLeaf = leftmostLeaf(tree->root);
+        ranges[0].endLeaf = NULL;
+        ranges[0].lowKey[0] = '\0';
+        return 1;
+    }
+
+    int count = 1;
+    level[0] = tree->root;
+    lowKeys[0][0] = '\0';
+    while (count < maxParts && !level[0]->isLeaf) {
+        int nextCount = 0;
+        for (int i = 0; i < count; i++) {
+            for (int j = 0; j <= level[i]->numKeys; j++) {
+                nextLevel[nextCount] = level[i]->children[j];
+                strcpy(nextLowKeys[nextCount], j == 0 ? lowKeys[i] : level[i]->keys[j - 1]);
+                nextCount++;
+            }
+        }
+        BPlusTreeNode** swapNodes = level;
+        level = nextLevel;
+        nextLevel = swapNodes;
+        char (*swapKeys)[20] = lowKeys;
+        lowKeys = nextLowKeys;
+        nextLowKeys = swapKeys;
+        count = nextCount;
+    }
+
+    int parts = count < maxParts ? count : maxParts;
+    for (int p = 0; p < parts; p++) {
+        int first = (int)((long)p * count / parts);
+        ranges[p].firstLeaf = leftmostLeaf(level[first]);
+        strcpy(ranges[p].lowKey, lowKeys[first]);
+    }
+    for (int p = 0; p < parts; p++) {
+        ranges[p].endLeaf = p + 1 < parts ? ranges[p + 1].firstLeaf : NULL;
+    }
+
+    free(level);
+    free(nextLevel);
+    free(lowKeys);
+    free(nextLowKeys);
+    return parts;
+}
+
+void runRangeScanTask(void* arg) {
+    RangeScanTask* task = (RangeScanTask*)arg;
+    task->scan(task->firstLeaf, task->endLeaf, task->partial);
+}
+
+// Splits every tree into reportThreads ranges and scans all ranges on the report pool.
+// *partials receives one zeroed partial of partialSize bytes per range, in tree then
+// key order; returns the number of partials. The caller merges and frees them.
+int parallelScanTrees(BPlusTree** trees, int numTrees, LeafRangeScan scan, size_t partialSize, void** partials) {
+    int maxParts = reportThreads > 0 ? reportThreads : 1;
+    TreeRange* ranges = (TreeRange*)malloc((size_t)(numTrees > 0 ? numTrees : 1) * maxParts * sizeof(TreeRange));
+    if (ranges == NULL) {
+        *partials = NULL;
+        return 0;
+    }
+    int numRanges = 0;
+    for (int t = 0; t < numTrees; t++) {
+        numRanges += partitionBPlusTree(trees[t], maxParts, ranges + numRanges);
+    }
+
+    *partials = calloc(numRanges > 0 ? numRanges : 1, partialSize);
+    RangeScanTask* tasks = (RangeScanTask*)malloc((numRanges > 0 ? numRanges : 1) * sizeof(RangeScanTask));
+    if (*partials == NULL || tasks == NULL) {
+        free(*partials);
+        *partials = NULL;
+        free(tasks);
+        free(ranges);
+        return 0;
+    }
+    for (int r = 0; r < numRanges; r++) {
+        tasks[r].scan = scan;
+        tasks[r].firstLeaf = ranges[r].firstLeaf;
+        tasks[r].endLeaf = ranges[r].endLeaf;
+        tasks[r].partial = (char*)*partials + (size_t)r * partialSize;
+    }
+    if (numRanges == 1 || reportPool == NULL) {
+        for (int r = 0; r < numRanges; r++) {
+            runRangeScanTask(&tasks[r]);
+        }
+    } else {
+        for (int r = 0; r < numRanges; r++) {
+            threadPoolSubmit(reportPool, runRangeScanTask, &tasks[r]);
+        }
+        threadPoolWait(reportPool);
+    }
+    free(tasks);
+    free(ranges);
+    return numRanges;
+}
+
+bool pointerListAppend(PointerList* list, void* item) {
+    if (list->count == list->capacity) {
+        int newCapacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        void** temp = (void**)realloc(list->items, newCapacity * sizeof(void*));
+        if (temp == NULL) {
+            return false;
+        }
+        list->items = temp;
+        list->capacity = newCapacity;
+    }
+    list->items[list->count++] = item;
+    return true;
+}
+
+// Helper function to get or create a customer tree for a salesperson
 BPlusTree* getCustomerTreeForSalesPerson(char* salesPersonId) {
     for (int i = 0; i < numSalesPersonTrees; i++) {
         if (strcmp(salesPersonCustomerTrees[i].salesPersonId, salesPersonId) == 0) {
@@ -323,6 +1703,7 @@ BPlusTree* getCustomerTreeForSalesPerson(char* salesPersonId) {
     salesPersonCustomerTrees = temp;
     strcpy(salesPersonCustomerTrees[numSalesPersonTrees].salesPersonId, salesPersonId);
     salesPersonCustomerTrees[numSalesPersonTrees].customerTree = createBPlusTree(2);
+    enableBloomFilter(salesPersonCustomerTrees[numSalesPersonTrees].customerTree);
     numSalesPersonTrees++;
     return salesPersonCustomerTrees[numSalesPersonTrees - 1].customerTree;
 }
@@ -379,24 +1760,28 @@ PaymentType stringToPaymentType(const char* str) {
 }
 
 double calculateEMI(double principal, double rate, int time) {
+    if (time >= 1 && time <= LOAN_MAX_MONTHS) {
+        LoanRateTable* table = getLoanRateTable((int)lround(rate * 100));
+        if (table != NULL) return principal * table->annuity[time];
+    }
     double r = rate / (12 * 100);
-    double emi = principal * r * pow(1 + r, time) / (pow(1 + r, time) - 1);
-    return emi;
+    double growth = pow(1 + r, time);
+    return principal * r * growth / (growth - 1);
 }
 
-void displayCarDetails(Car* car) {
-    if (car == NULL) {
+void displayCarDetails(int row) {
+    if (row < 0) {
         printf("Car not found.\n");
         return;
     }
-    printf("VIN: %s\n", car->VIN);
-    printf("Name: %s\n", car->name);
-    printf("Color: %s\n", car->color);
-    printf("Price: %.2f lakhs\n", car->price);
-    printf("Fuel Type: %s\n", fuelTypeToString(car->fuelType));
-    printf("Car Type: %s\n", carTypeToString(car->carType));
-    printf("Status: %s\n", car->isSold ? "Sold" : "Available");
-    printf("Showroom ID: %d\n", car->showroomId);
+    printf("VIN: %s\n", carColumns.VIN[row]);
+    printf("Name: %s\n", carName(row));
+    printf("Color: %s\n", carColor(row));
+    printf("Price: %.2f lakhs\n", moneyToLakhs(carColumns.price[row]));
+    printf("Fuel Type: %s\n", fuelTypeToString((FuelType)carColumns.fuelType[row]));
+    printf("Car Type: %s\n", carTypeToString((CarType)carColumns.carType[row]));
+    printf("Status: %s\n", carColumns.isSold[row] ? "Sold" : "Available");
+    printf("Showroom ID: %d\n", carColumns.showroomId[row]);
 }
 
 void displayCustomerDetails(Customer* customer) {
@@ -404,17 +1789,17 @@ void displayCustomerDetails(Customer* customer) {
         printf("Customer not found.\n");
         return;
     }
-    printf("Name: %s\n", customer->name);
+    printf("Name: %s\n", customerName(customer));
     printf("Mobile: %s\n", customer->mobileNo);
-    printf("Address: %s\n", customer->address);
+    printf("Address: %s\n", customer->address ? customer->address : "");
     printf("Car VIN: %s\n", customer->VIN);
     printf("Registration No: %s\n", customer->registrationNo);
     printf("Payment Type: %s\n", paymentTypeToString(customer->paymentType));
     if (customer->paymentType == LOAN) {
         printf("EMI Months: %d\n", customer->emiMonths);
-        printf("Down Payment: %.2f lakhs\n", customer->downPayment);
-        printf("Loan Amount: %.2f lakhs\n", customer->loanAmount);
-        printf("EMI Amount: %.2f rupees\n", customer->emiAmount);
+        printf("Down Payment: %.2f lakhs\n", moneyToLakhs(customer->downPayment));
+        printf("Loan Amount: %.2f lakhs\n", moneyToLakhs(customer->loanAmount));
+        printf("EMI Amount: %.2f rupees\n", moneyToRupees(customer->emiAmount));
     }
 }
 
@@ -425,13 +1810,15 @@ void displaySalesPersonDetails(SalesPerson* person) {
     }
     printf("ID: %d\n", person->id);
     printf("Name: %s\n", person->name);
-    printf("Sales Target: %.2f lakhs\n", person->salesTarget);
-    printf("Sales Achieved: %.2f lakhs\n", person->salesAchieved);
-    printf("Commission (2%%): %.2f lakhs\n", person->commission);
+    printf("Sales Target: %.2f lakhs\n", moneyToLakhs(person->salesTarget));
+    printf("Sales Achieved: %.2f lakhs\n", moneyToLakhs(person->salesAchieved));
+    printf("Commission (2%%): %.2f lakhs\n", moneyToLakhs(person->commission));
     printf("Number of Sales: %d\n", person->numSales);
+    SalesBucket lastMonth = rollupWindow(&person->sales, time(NULL), 30, 0);
+    printf("Sales in Last 30 Days: %.2f lakhs (%d cars)\n", moneyToLakhs(lastMonth.amount), lastMonth.cars);
     if (person->extraIncentive) {
-        printf("Extra Incentive (1%%): %.2f lakhs\n", 0.01 * person->salesAchieved);
-        printf("Total Commission: %.2f lakhs\n", 0.03 * person->salesAchieved);
+        printf("Extra Incentive (1%%): %.2f lakhs\n", 0.01 * moneyToLakhs(person->salesAchieved));
+        printf("Total Commission: %.2f lakhs\n", 0.03 * moneyToLakhs(person->salesAchieved));
     }
 }
 
@@ -446,8 +1833,9 @@ void displayShowroomDetails(Showroom* showroom) {
     printf("Total Cars: %d\n", showroom->numTotalCars);
     printf("Available Cars: %d\n", showroom->numAvailableCars);
     printf("Sold Cars: %d\n", showroom->numSoldCars);
-    printf("Total Sales: %.2f lakhs\n", showroom->totalSales);
-    printf("Last Month Sales: %.2f lakhs\n", showroom->lastMonthSales);
+    printf("Total Sales: %.2f lakhs\n", moneyToLakhs(showroom->totalSales));
+    SalesBucket lastMonth = rollupWindow(&showroom->sales, time(NULL), 30, 0);
+    printf("Last Month Sales: %.2f lakhs (%d cars)\n", moneyToLakhs(lastMonth.amount), lastMonth.cars);
 }
 
 // A. Merge showroom trees
@@ -473,102 +1861,136 @@ void mergeShowroomTrees(BPlusTree* mergedTree, BPlusTree* showroom1, BPlusTree*
 }
 
 // B. Add a new sales person
-void addSalesPerson(int showroomId, SalesPerson* person) {
+bool addSalesPerson(int showroomId, SalesPerson* person) {
     if (showroomId < 1 || showroomId > MAX_SHOWROOMS || salesPersonTrees[showroomId - 1] == NULL) {
-        printf("Invalid or uninitialized showroom ID %d.\n", showroomId);
-        return;
+        if (!batchMode) printf("Invalid or uninitialized showroom ID %d.\n", showroomId);
+        return false;
     }
 
     SalesPerson* newPerson = (SalesPerson*)malloc(sizeof(SalesPerson));
     if (newPerson == NULL) {
         fprintf(stderr, "Memory allocation failed for SalesPerson\n");
-        return;
+        return false;
     }
     *newPerson = *person;
-    newPerson->salesTarget = 50.0;
-    newPerson->salesAchieved = 0.0;
-    newPerson->commission = 0.0;
+    newPerson->salesTarget = 50 * PAISE_PER_LAKH;
+    newPerson->salesAchieved = 0;
+    newPerson->commission = 0;
     newPerson->numSales = 0;
     newPerson->extraIncentive = false;
+    memset(&newPerson->sales, 0, sizeof(SalesRollup));
 
     char key[20];
     sprintf(key, "%d", person->id);
     insertIntoBPlusTree(salesPersonTrees[showroomId - 1], key, newPerson);
-    printf("Added sales person %s with ID %d to showroom %d.\n", person->name, person->id, showroomId);
-    saveSalesPersonsToFile();
+    char name[2 * MAX_STRING];
+    publishMutation("add-salesperson\t%d\t%d\t%s", showroomId, person->id,
+                    replicationField(person->name, name, sizeof(name)));
+    cdcSalesPersonEvent("insert", showroomId, newPerson);
+    if (!batchMode) {
+        printf("Added sales person %s with ID %d to showroom %d.\n", person->name, person->id, showroomId);
+        saveSalesPersonsToFile();
+    }
+    return true;
 }
 
 // C. Find the most popular car
 typedef struct {
-    char model[MAX_STRING];
+    uint32_t modelId;
     int count;
 } ModelCount;
 
-void countModelSales(BPlusTreeNode* node, ModelCount** counts, int* numModels) {
-    if (node == NULL) return;
-    if (node->isLeaf) {
-        for (int i = 0; i < node->numKeys; i++) {
-            Car* car = (Car*)node->data[i];
-            bool found = false;
-            for (int j = 0; j < *numModels; j++) {
-                if (strcmp((*counts)[j].model, car->name) == 0) {
-                    (*counts)[j].count++;
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                (*numModels)++;
-                *counts = (ModelCount*)realloc(*counts, (*numModels) * sizeof(ModelCount));
-                strcpy((*counts)[(*numModels) - 1].model, car->name);
-                (*counts)[(*numModels) - 1].count = 1;
-            }
+typedef struct {
+    ModelCount* counts;
+    int numModels;
+} ModelCountPartial;
+
+void addModelCount(ModelCountPartial* partial, uint32_t modelId, int count) {
+    for (int j = 0; j < partial->numModels; j++) {
+        if (partial->counts[j].modelId == modelId) {
+            partial->counts[j].count += count;
+            return;
         }
-        countModelSales(node->next, counts, numModels);
-    } else {
-        for (int i = 0; i <= node->numKeys; i++) {
-            countModelSales(node->children[i], counts, numModels);
+    }
+    ModelCount* temp = (ModelCount*)realloc(partial->counts, (partial->numModels + 1) * sizeof(ModelCount));
+    if (temp == NULL) {
+        return;
+    }
+    partial->counts = temp;
+    partial->counts[partial->numModels].modelId = modelId;
+    partial->counts[partial->numModels].count = count;
+    partial->numModels++;
+}
+
+void countModelSales(BPlusTreeNode* firstLeaf, BPlusTreeNode* endLeaf, void* partial) {
+    for (BPlusTreeNode* leaf = firstLeaf; leaf != endLeaf; leaf = leaf->next) {
+        for (int i = 0; i < leaf->numKeys; i++) {
+            addModelCount((ModelCountPartial*)partial, carColumns.nameId[carRow(leaf->data[i])], 1);
+        }
+    }
+}
+
+// Single-index variant over carTree: leaves with no sold cars are skipped on their status bits
+void countModelSalesFromStatus(BPlusTreeNode* firstLeaf, BPlusTreeNode* endLeaf, void* partial) {
+    for (BPlusTreeNode* leaf = firstLeaf; leaf != endLeaf; leaf = leaf->next) {
+        if (leaf->availableCount == leaf->numKeys) {
+            continue;
+        }
+        for (int i = 0; i < leaf->numKeys; i++) {
+            if (!((leaf->availableMask >> i) & 1u)) {
+                addModelCount((ModelCountPartial*)partial, carColumns.nameId[carRow(leaf->data[i])], 1);
+            }
         }
     }
 }
 
-Car* findCarByModel(BPlusTreeNode* node, const char* mostPopularModel) {
-    if (node == NULL) return NULL;
+// Row of the first car of the model in VIN order, -1 if there is none
+int findCarByModel(BPlusTreeNode* node, uint32_t mostPopularModel) {
+    if (node == NULL) return -1;
     if (node->isLeaf) {
         for (int i = 0; i < node->numKeys; i++) {
-            Car* car = (Car*)node->data[i];
-            if (strcmp(car->name, mostPopularModel) == 0) {
-                return car;
+            int row = carRow(node->data[i]);
+            if (carColumns.nameId[row] == mostPopularModel) {
+                return row;
             }
         }
         return findCarByModel(node->next, mostPopularModel);
     } else {
         for (int i = 0; i <= node->numKeys; i++) {
-            Car* car = findCarByModel(node->children[i], mostPopularModel);
-            if (car != NULL) return car;
+            int row = findCarByModel(node->children[i], mostPopularModel);
+            if (row >= 0) return row;
         }
     }
-    return NULL;
+    return -1;
 }
 
-Car* findMostPopularCar() {
-    ModelCount* counts = (ModelCount*)malloc(sizeof(ModelCount));
-    int numModels = 0;
-    countModelSales(soldCarTree->root, &counts, &numModels);
+int findMostPopularCar() {
+    ModelCountPartial* partials;
+    int numPartials = singleCarIndex
+        ? parallelScanTrees(&carTree, 1, countModelSalesFromStatus, sizeof(ModelCountPartial), (void**)&partials)
+        : parallelScanTrees(&soldCarTree, 1, countModelSales, sizeof(ModelCountPartial), (void**)&partials);
+    ModelCountPartial merged = {NULL, 0};
+    for (int p = 0; p < numPartials; p++) {
+        for (int i = 0; i < partials[p].numModels; i++) {
+            addModelCount(&merged, partials[p].counts[i].modelId, partials[p].counts[i].count);
+        }
+        free(partials[p].counts);
+    }
+    free(partials);
 
     int maxCount = 0;
-    char mostPopularModel[MAX_STRING] = "";
-    for (int i = 0; i < numModels; i++) {
-        if (counts[i].count > maxCount) {
-            maxCount = counts[i].count;
-            strcpy(mostPopularModel, counts[i].model);
+    uint32_t mostPopularModel = 0;
+    for (int i = 0; i < merged.numModels; i++) {
+        if (merged.counts[i].count > maxCount) {
+            maxCount = merged.counts[i].count;
+            mostPopularModel = merged.counts[i].modelId;
         }
     }
-    free(counts);
+    free(merged.counts);
 
-    Car* mostPopularCar = findCarByModel(carTree->root, mostPopularModel);
-    if (mostPopularCar != NULL) {
-        printf("The most popular car is %s with %d sales.\n", mostPopularModel, maxCount);
+    int mostPopularCar = maxCount > 0 ? findCarByModel(carTree->root, mostPopularModel) : -1;
+    if (mostPopularCar >= 0) {
+        printf("The most popular car is %s with %d sales.\n", stringById(mostPopularModel), maxCount);
     } else {
         printf("No cars found.\n");
     }
@@ -576,42 +1998,54 @@ Car* findMostPopularCar() {
 }
 
 // D. Find the most successful sales person
-void findHighestSales(BPlusTreeNode* node, SalesPerson** mostSuccessful, double* maxSales) {
-    if (node == NULL) return;
-    if (node->isLeaf) {
-        for (int i = 0; i < node->numKeys; i++) {
-            SalesPerson* person = (SalesPerson*)node->data[i];
-            if (person->salesAchieved > *maxSales) {
-                *maxSales = person->salesAchieved;
-                *mostSuccessful = person;
+typedef struct {
+    SalesPerson* best;
+    Money maxSales;
+} TopSalesPartial;
+
+void findHighestSales(BPlusTreeNode* firstLeaf, BPlusTreeNode* endLeaf, void* partial) {
+    TopSalesPartial* top = (TopSalesPartial*)partial;
+    for (BPlusTreeNode* leaf = firstLeaf; leaf != endLeaf; leaf = leaf->next) {
+        for (int i = 0; i < leaf->numKeys; i++) {
+            SalesPerson* person = (SalesPerson*)leaf->data[i];
+            if (person->salesAchieved > top->maxSales) {
+                top->maxSales = person->salesAchieved;
+                top->best = person;
             }
         }
-        findHighestSales(node->next, mostSuccessful, maxSales);
-    } else {
-        for (int i = 0; i <= node->numKeys; i++) {
-            findHighestSales(node->children[i], mostSuccessful, maxSales);
-        }
     }
 }
 
 SalesPerson* findMostSuccessfulSalesPerson() {
     SalesPerson* mostSuccessful = NULL;
-    double maxSales = 0.0;
+    Money maxSales = 0;
 
+    BPlusTree* trees[MAX_SHOWROOMS];
+    int numTrees = 0;
     for (int i = 0; i < MAX_SHOWROOMS; i++) {
         if (salesPersonTrees[i] != NULL) {
-            findHighestSales(salesPersonTrees[i]->root, &mostSuccessful, &maxSales);
+            trees[numTrees++] = salesPersonTrees[i];
         }
     }
+    TopSalesPartial* partials;
+    int numPartials = parallelScanTrees(trees, numTrees, findHighestSales, sizeof(TopSalesPartial), (void**)&partials);
+    for (int p = 0; p < numPartials; p++) {
+        if (partials[p].best != NULL && partials[p].maxSales > maxSales) {
+            maxSales = partials[p].maxSales;
+            mostSuccessful = partials[p].best;
+        }
+    }
+    free(partials);
 
     if (mostSuccessful != NULL) {
         mostSuccessful->extraIncentive = true;
-        double extraIncentive = 0.01 * mostSuccessful->salesAchieved;
+        double salesLakhs = moneyToLakhs(mostSuccessful->salesAchieved);
+        double extraIncentive = 0.01 * salesLakhs;
         printf("The most successful sales person is %s with sales of %.2f lakhs.\n",
-               mostSuccessful->name, mostSuccessful->salesAchieved);
+               mostSuccessful->name, salesLakhs);
         printf("Awarding an extra incentive of %.2f lakhs (1%% of sales).\n", extraIncentive);
         printf("Total commission: %.2f lakhs (2%% standard) + %.2f lakhs (1%% bonus) = %.2f lakhs.\n",
-               0.02 * mostSuccessful->salesAchieved, extraIncentive, 0.03 * mostSuccessful->salesAchieved);
+               0.02 * salesLakhs, extraIncentive, 0.03 * salesLakhs);
     } else {
         printf("No sales persons found.\n");
     }
@@ -619,100 +2053,282 @@ SalesPerson* findMostSuccessfulSalesPerson() {
 }
 
 // E. Sell a car to a customer
-void sellCar(char* salesPersonId, char* VIN, Customer* customer) {
+UndoEntry* pushUndo(SaleTransaction* txn, UndoKind kind) {
+    if (txn->numUndo == txn->undoCapacity) {
+        int newCapacity = txn->undoCapacity == 0 ? 16 : txn->undoCapacity * 2;
+        UndoEntry* grown = (UndoEntry*)realloc(txn->undo, newCapacity * sizeof(UndoEntry));
+        if (grown == NULL) {
+            fprintf(stderr, "Memory allocation failed for undo log\n");
+            exit(EXIT_FAILURE);
+        }
+        txn->undo = grown;
+        txn->undoCapacity = newCapacity;
+    }
+    UndoEntry* entry = &txn->undo[txn->numUndo++];
+    memset(entry, 0, sizeof(*entry));
+    entry->kind = kind;
+    return entry;
+}
+
+// Call before writing a field of at most sizeof(Money) bytes
+void undoLogField(SaleTransaction* txn, void* address, size_t size) {
+    UndoEntry* entry = pushUndo(txn, UNDO_FIELD);
+    entry->address = address;
+    entry->size = size;
+    memcpy(entry->saved, address, size);
+}
+
+void txnInsert(SaleTransaction* txn, BPlusTree* tree, char* key, void* data) {
+    insertIntoBPlusTree(tree, key, data);
+    UndoEntry* entry = pushUndo(txn, UNDO_TREE_INSERT);
+    entry->tree = tree;
+    strcpy(entry->key, key);
+}
+
+void txnDelete(SaleTransaction* txn, BPlusTree* tree, char* key, void* data) {
+    deleteFromBPlusTree(tree, key);
+    UndoEntry* entry = pushUndo(txn, UNDO_TREE_DELETE);
+    entry->tree = tree;
+    strcpy(entry->key, key);
+    entry->data = data;
+}
+
+void txnMarkCarSold(SaleTransaction* txn, int row) {
+    carColumns.isSold[row] = 1;
+    UndoEntry* entry = pushUndo(txn, UNDO_CAR_SOLD);
+    entry->row = row;
+}
+
+void txnSetAvailability(SaleTransaction* txn, BPlusTree* tree, char* key, bool available) {
+    setAvailability(tree, key, available);
+    UndoEntry* entry = pushUndo(txn, UNDO_AVAILABILITY);
+    entry->tree = tree;
+    strcpy(entry->key, key);
+    entry->available = !available;
+}
+
+void beginSaleTransaction(SaleTransaction* txn) {
+    memset(txn, 0, sizeof(*txn));
+}
+
+void endSaleTransaction(SaleTransaction* txn) {
+    free(txn->undo);
+    free(txn->sales);
+    memset(txn, 0, sizeof(*txn));
+}
+
+// Validates the sale, then applies it inside txn. A rejected sale changes nothing.
+bool stageSale(SaleTransaction* txn, char* salesPersonId, char* VIN, Customer* customer) {
     char showroomIdStr[20], personIdStr[20];
     sscanf(salesPersonId, "%[^_]_%s", showroomIdStr, personIdStr);
     int showroomId = atoi(showroomIdStr);
 
     if (showroomId < 1 || showroomId > MAX_SHOWROOMS || salesPersonTrees[showroomId - 1] == NULL) {
-        printf("Invalid showroom ID in salesPersonId %s.\n", salesPersonId);
-        return;
+        if (!batchMode) printf("Invalid showroom ID in salesPersonId %s.\n", salesPersonId);
+        return false;
     }
 
     SalesPerson* salesPerson = (SalesPerson*)searchInBPlusTree(salesPersonTrees[showroomId - 1], personIdStr);
     if (salesPerson == NULL) {
-        printf("Sales person with ID %s not found in showroom %d.\n", personIdStr, showroomId);
-        return;
+        if (!batchMode) printf("Sales person with ID %s not found in showroom %d.\n", personIdStr, showroomId);
+        return false;
     }
 
-    Car* car = (Car*)searchInBPlusTree(carTree, VIN);
-    if (car == NULL) {
-        printf("Car with VIN %s not found.\n", VIN);
-        return;
+    int row = findCarRow(VIN);
+    if (row < 0) {
+        if (!batchMode) printf("Car with VIN %s not found.\n", VIN);
+        return false;
     }
-    if (car->isSold) {
-        printf("Car with VIN %s is already sold.\n", VIN);
-        return;
+    if (carColumns.isSold[row]) {
+        if (!batchMode) printf("Car with VIN %s is already sold.\n", VIN);
+        return false;
+    }
+    Money price = carColumns.price[row];
+    const LoanProduct* product = NULL;
+    if (customer->paymentType == LOAN) {
+        if (customer->downPayment * 5 < price) {
+            if (!batchMode) {
+                printf("Down payment must be at least 20%% of car price (%.2f lakhs).\n", moneyToLakhs(price) / 5);
+            }
+            return false;
+        }
+        product = findLoanProduct(customer->emiMonths);
+        if (product == NULL) {
+            if (!batchMode) printf("Invalid EMI duration. Please choose 36, 60, or 84 months.\n");
+            return false;
+        }
     }
 
-    car->isSold = true;
-    deleteFromBPlusTree(availableCarTree, VIN);
-    insertIntoBPlusTree(soldCarTree, VIN, car);
+    txnMarkCarSold(txn, row);
+    txnSetAvailability(txn, carTree, VIN, false);
+    if (!singleCarIndex) {
+        txnDelete(txn, availableCarTree, VIN, carRef(row));
+        txnInsert(txn, soldCarTree, VIN, carRef(row));
+    }
+    BPlusTree* customerTree = getCustomerTreeForSalesPerson(salesPersonId);
 
     Customer* newCustomer = (Customer*)malloc(sizeof(Customer));
     if (newCustomer == NULL) {
         fprintf(stderr, "Memory allocation failed for Customer\n");
-        return;
+        exit(EXIT_FAILURE);
     }
     *newCustomer = *customer;
     strcpy(newCustomer->VIN, VIN);
-
-    newCustomer->loanAmount = 0.0;
-    newCustomer->emiAmount = 0.0;
-    newCustomer->downPayment = 0.0;
+    newCustomer->saleTime = saleTimeOverride != 0 ? saleTimeOverride : time(NULL);
+    newCustomer->loanAmount = 0;
+    newCustomer->emiAmount = 0;
+    newCustomer->downPayment = 0;
     newCustomer->emiMonths = 0;
-
-    if (customer->paymentType == LOAN) {
-        if (customer->downPayment < 0.2 * car->price) {
-            printf("Down payment must be at least 20%% of car price (%.2f lakhs).\n", 0.2 * car->price);
-            free(newCustomer);
-            return;
-        }
+    if (product != NULL) {
         newCustomer->downPayment = customer->downPayment;
-        newCustomer->loanAmount = car->price - newCustomer->downPayment;
-        double rate;
-        if (customer->emiMonths == 84) rate = 9.00;
-        else if (customer->emiMonths == 60) rate = 8.75;
-        else if (customer->emiMonths == 36) rate = 8.50;
-        else {
-            printf("Invalid EMI duration. Please choose 36, 60, or 84 months.\n");
-            free(newCustomer);
-            return;
-        }
+        newCustomer->loanAmount = price - newCustomer->downPayment;
         newCustomer->emiMonths = customer->emiMonths;
-        newCustomer->emiAmount = calculateEMI(newCustomer->loanAmount * 100000, rate, newCustomer->emiMonths);
+        newCustomer->emiAmount = quoteEMI(newCustomer->loanAmount, product->months, product->rateBasisPoints);
     }
 
-    BPlusTree* customerTree = getCustomerTreeForSalesPerson(salesPersonId);
-    insertIntoBPlusTree(customerTree, newCustomer->mobileNo, newCustomer);
-
-    salesPerson->salesAchieved += car->price;
+    undoLogField(txn, &salesPerson->salesAchieved, sizeof(salesPerson->salesAchieved));
+    undoLogField(txn, &salesPerson->numSales, sizeof(salesPerson->numSales));
+    undoLogField(txn, &salesPerson->commission, sizeof(salesPerson->commission));
+    salesPerson->salesAchieved += price;
     salesPerson->numSales++;
-    salesPerson->commission = 0.02 * salesPerson->salesAchieved;
-
+    salesPerson->commission = (salesPerson->salesAchieved * 2 + 50) / 100;
     Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
     if (showroom != NULL) {
+        undoLogField(txn, &showroom->numSoldCars, sizeof(showroom->numSoldCars));
+        undoLogField(txn, &showroom->numAvailableCars, sizeof(showroom->numAvailableCars));
+        undoLogField(txn, &showroom->totalSales, sizeof(showroom->totalSales));
         showroom->numSoldCars++;
         showroom->numAvailableCars--;
-        showroom->totalSales += car->price;
-        showroom->lastMonthSales += car->price;  // Update last month's sales
-        showroom->lastMonthCars++;              // Increment car count for last month
+        showroom->totalSales += price;
+    }
+
+    if (txn->numSales == txn->salesCapacity) {
+        int newCapacity = txn->salesCapacity == 0 ? 4 : txn->salesCapacity * 2;
+        PendingSale* grown = (PendingSale*)realloc(txn->sales, newCapacity * sizeof(PendingSale));
+        if (grown == NULL) {
+            fprintf(stderr, "Memory allocation failed for pending sales\n");
+            exit(EXIT_FAILURE);
+        }
+        txn->sales = grown;
+        txn->salesCapacity = newCapacity;
+    }
+    PendingSale* sale = &txn->sales[txn->numSales++];
+    sale->customer = newCustomer;
+    sale->carRow = row;
+    sale->price = price;
+    sale->salesPerson = salesPerson;
+    sale->showroom = showroom;
+    sale->customerTree = customerTree;
+    sale->showroomId = showroomId;
+    return true;
+}
+
+// Reverses the undo log newest first and drops the pending customers
+void rollbackSaleTransaction(SaleTransaction* txn) {
+    for (int i = txn->numUndo - 1; i >= 0; i--) {
+        UndoEntry* entry = &txn->undo[i];
+        switch (entry->kind) {
+            case UNDO_FIELD:
+                memcpy(entry->address, entry->saved, entry->size);
+                break;
+            case UNDO_TREE_INSERT:
+                deleteFromBPlusTree(entry->tree, entry->key);
+                break;
+            case UNDO_TREE_DELETE:
+                insertIntoBPlusTree(entry->tree, entry->key, entry->data);
+                break;
+            case UNDO_AVAILABILITY:
+                setAvailability(entry->tree, entry->key, entry->available);
+                break;
+            case UNDO_CAR_SOLD:
+                carColumns.isSold[entry->row] = 0;
+                break;
+        }
+    }
+    for (int i = 0; i < txn->numSales; i++) {
+        free(txn->sales[i].customer);
+    }
+    txn->numUndo = 0;
+    txn->numSales = 0;
+    txn->failed = false;
+}
+
+// Publishes the pending sales. The pending list is kept for the caller until
+// endSaleTransaction; only the undo log is discarded.
+void commitSaleTransaction(SaleTransaction* txn) {
+    for (int i = 0; i < txn->numSales; i++) {
+        PendingSale* sale = &txn->sales[i];
+        Customer* customer = sale->customer;
+        insertIntoBPlusTree(sale->customerTree, customer->mobileNo, customer);
+        rollupRecord(&sale->salesPerson->sales, customer->saleTime, sale->price, 1);
+        if (sale->showroom != NULL) {
+            rollupRecord(&sale->showroom->sales, customer->saleTime, sale->price, 1);
+        }
+
+        markCarRowSold(sale->carRow);
+        textIndexInsert(&customerNameIndex, customerName(customer), customer);
+        insertIntoBPlusTree(customerVinTree, customer->VIN, customer);
+        SalesRollup* modelRollup = getModelRollup(carColumns.nameId[sale->carRow]);
+        if (modelRollup != NULL) {
+            rollupRecord(modelRollup, customer->saleTime, sale->price, 1);
+        }
+        appendSaleRecord(customer->saleTime, customer->VIN, sale->showroomId, sale->salesPerson->id,
+                         sale->price, customer->paymentType);
+        char loan[48] = "";
+        if (customer->paymentType == LOAN) {
+            char downPayment[32];
+            formatMoney(customer->downPayment, LAKH_DIGITS, downPayment);
+            snprintf(loan, sizeof(loan), "\t%s\t%d", downPayment, customer->emiMonths);
+        }
+        char VIN[40], name[2 * MAX_STRING], mobileNo[32], address[2 * MAX_STRING], registrationNo[40];
+        publishMutation("sell\t%d\t%d\t%s\t%s\t%s\t%s\t%s\t%d%s\t%lld", sale->showroomId, sale->salesPerson->id,
+                        replicationField(customer->VIN, VIN, sizeof(VIN)),
+                        replicationField(customerName(customer), name, sizeof(name)),
+                        replicationField(customer->mobileNo, mobileNo, sizeof(mobileNo)),
+                        replicationField(customer->address ? customer->address : "", address, sizeof(address)),
+                        replicationField(customer->registrationNo, registrationNo, sizeof(registrationNo)),
+                        customer->paymentType, loan, (long long)customer->saleTime);
+        cdcCarEvent("update", sale->carRow);
+        cdcCustomerEvent("insert", customer);
+        cdcSalesPersonEvent("update", sale->showroomId, sale->salesPerson);
+        if (sale->showroom != NULL) {
+            cdcShowroomEvent(sale->showroom);
+        }
+    }
+    txn->numUndo = 0;
+}
+
+// Sells one car in its own transaction
+bool sellCar(char* salesPersonId, char* VIN, Customer* customer) {
+    TIME_SCOPE(TIMER_SELL_CAR);
+    SaleTransaction txn;
+    beginSaleTransaction(&txn);
+    if (!stageSale(&txn, salesPersonId, VIN, customer)) {
+        rollbackSaleTransaction(&txn);
+        endSaleTransaction(&txn);
+        return false;
     }
+    commitSaleTransaction(&txn);
+    Customer* newCustomer = txn.sales[0].customer;
+    Money price = txn.sales[0].price;
+    endSaleTransaction(&txn);
 
-    printf("Car with VIN %s sold to %s for %.2f lakhs.\n", VIN, newCustomer->name, car->price);
+    if (batchMode) {
+        return true;
+    }
+    printf("Car with VIN %s sold to %s for %.2f lakhs.\n", VIN, customerName(newCustomer), moneyToLakhs(price));
     if (newCustomer->paymentType == LOAN) {
         printf("Loan details: Down Payment = %.2f lakhs, Loan Amount = %.2f lakhs, EMI = %.2f rupees for %d months.\n",
-               newCustomer->downPayment, newCustomer->loanAmount, newCustomer->emiAmount, newCustomer->emiMonths);
+               moneyToLakhs(newCustomer->downPayment), moneyToLakhs(newCustomer->loanAmount),
+               moneyToRupees(newCustomer->emiAmount), newCustomer->emiMonths);
     } else {
         printf("Payment: Cash\n");
     }
 
     printf("\nCustomer Details After Sale:\n");
     displayCustomerDetails(newCustomer);
-    saveCarsToFile();
-    saveCustomersToFile();
-    saveSalesPersonsToFile();
-    saveShowroomsToFile();
+    saveAllToFiles();
+    return true;
 }
 
 // F. Predict next month's sales
@@ -725,65 +2341,66 @@ double predictNextMonthSales(int showroomId) {
         return 0.0;
     }
 
-    // Assuming current date is April 8, 2025 (as per your example)
-    double weightedMean = (0.5 * showroom->lastMonthSales) + 
-                         (0.3 * showroom->twoMonthsAgoSales) + 
-                         (0.2 * showroom->threeMonthsAgoSales);
+    // Trailing 30-day windows ending today
+    time_t now = time(NULL);
+    ForecastBatch* batch = buildForecastBatch(&showroom, 1, now);
+    if (batch == NULL) {
+        return 0.0;
+    }
+    runForecastModels(batch);
+    const double* history = batch->history;
+    const int* cars = batch->cars;
+    double weightedMean = batch->weightedMean[0];
+
+    char today[11], back30[11], back60[11], back90[11];
+    formatDate(now, today, sizeof(today));
+    formatDate(now - 30 * SECONDS_PER_DAY, back30, sizeof(back30));
+    formatDate(now - 60 * SECONDS_PER_DAY, back60, sizeof(back60));
+    formatDate(now - 90 * SECONDS_PER_DAY, back90, sizeof(back90));
+    int nextMonth = monthNumber(now) + 1;
 
     printf("Sales for showroom %s:\n", showroom->name);
-    printf("  Last month (2025-03-08 to 2025-04-08): %.2f lakhs (%d cars)\n", 
-           showroom->lastMonthSales, showroom->lastMonthCars);
-    printf("  Two months ago (2025-02-08 to 2025-03-08): %.2f lakhs (%d cars)\n", 
-           showroom->twoMonthsAgoSales, showroom->twoMonthsAgoCars);
-    printf("  Three months ago (2025-01-08 to 2025-02-08): %.2f lakhs (%d cars)\n", 
-           showroom->threeMonthsAgoSales, showroom->threeMonthsAgoCars);
+    printf("  Last month (%s to %s): %.2f lakhs (%d cars)\n", 
+           back30, today, history[FORECAST_MONTHS - 1], cars[FORECAST_MONTHS - 1]);
+    printf("  Two months ago (%s to %s): %.2f lakhs (%d cars)\n", 
+           back60, back30, history[FORECAST_MONTHS - 2], cars[FORECAST_MONTHS - 2]);
+    printf("  Three months ago (%s to %s): %.2f lakhs (%d cars)\n", 
+           back90, back60, history[FORECAST_MONTHS - 3], cars[FORECAST_MONTHS - 3]);
     printf("Weighted Mean (50%% last, 30%% two months, 20%% three months): %.2f lakhs\n", 
            weightedMean);
-    printf("Predicted sales for 2025-05: %.2f lakhs\n", weightedMean);
+    printf("Exponential smoothing (alpha %.1f, %d months): %.2f lakhs\n",
+           FORECAST_ALPHA, FORECAST_MONTHS, batch->smoothed[0]);
+    printf("Linear trend (%d months): %.2f lakhs\n", FORECAST_MONTHS, batch->trend[0]);
+    printf("Predicted sales for %04d-%02d: %.2f lakhs\n", nextMonth / 12, nextMonth % 12 + 1, weightedMean);
 
+    freeForecastBatch(batch);
     return weightedMean;
 }
 // G. Display all information of a car by VIN
-void findCustomerByVIN(BPlusTreeNode* node, char* VIN) {
-    if (node == NULL) return;
-    if (node->isLeaf) {
-        for (int i = 0; i < node->numKeys; i++) {
-            Customer* customer = (Customer*)node->data[i];
-            if (strcmp(customer->VIN, VIN) == 0) {
-                printf("\nCustomer Information:\n");
-                displayCustomerDetails(customer);
-                return;
-            }
-        }
-        findCustomerByVIN(node->next, VIN);
-    } else {
-        for (int i = 0; i <= node->numKeys; i++) {
-            findCustomerByVIN(node->children[i], VIN);
-        }
-    }
-}
-
 void displayCarByVIN(char* VIN) {
-    Car* car = (Car*)searchInBPlusTree(carTree, VIN);
-    if (car == NULL) {
+    int row = findCarRow(VIN);
+    if (row < 0) {
         printf("Car with VIN %s not found.\n", VIN);
         return;
     }
-    displayCarDetails(car);
-    if (car->isSold) {
-        for (int i = 0; i < numSalesPersonTrees; i++) {
-            findCustomerByVIN(salesPersonCustomerTrees[i].customerTree->root, VIN);
+    displayCarDetails(row);
+    if (carColumns.isSold[row]) {
+        Customer* customer = (Customer*)searchInBPlusTree(customerVinTree, VIN);
+        if (customer != NULL) {
+            printf("\nCustomer Information:\n");
+            displayCustomerDetails(customer);
         }
     }
 }
 
 // H. Search sales persons within a sales range
-void searchSalesPersonByRange(BPlusTree* tree, double minSales, double maxSales) {
+void searchSalesPersonByRange(BPlusTree* tree, Money minSales, Money maxSales) {
     if (tree == NULL || tree->root == NULL) {
         printf("No sales persons found in database.\n");
         return;
     }
-    printf("\n--- Sales Persons with Sales Achievement between %.2f and %.2f lakhs ---\n", minSales, maxSales);
+    printf("\n--- Sales Persons with Sales Achievement between %.2f and %.2f lakhs ---\n",
+           moneyToLakhs(minSales), moneyToLakhs(maxSales));
     BPlusTreeNode* current = tree->root;
     while (!current->isLeaf) {
         current = current->children[0];
@@ -794,7 +2411,7 @@ void searchSalesPersonByRange(BPlusTree* tree, double minSales, double maxSales)
             SalesPerson* salesPerson = (SalesPerson*)current->data[i];
             if (salesPerson->salesAchieved >= minSales && salesPerson->salesAchieved <= maxSales) {
                 printf("ID: %d, Name: %s, Sales Achieved: %.2f lakhs\n",
-                       salesPerson->id, salesPerson->name, salesPerson->salesAchieved);
+                       salesPerson->id, salesPerson->name, moneyToLakhs(salesPerson->salesAchieved));
                 found = true;
             }
         }
@@ -806,666 +2423,6054 @@ void searchSalesPersonByRange(BPlusTree* tree, double minSales, double maxSales)
 }
 
 // I. Print customers with EMI in range 36-48 months
-void findCustomersWithEMIInRange(BPlusTreeNode* node, int* count) {
-    if (node == NULL) return;
-    if (node->isLeaf) {
-        for (int i = 0; i < node->numKeys; i++) {
-            Customer* customer = (Customer*)node->data[i];
+void findCustomersWithEMIInRange(BPlusTreeNode* firstLeaf, BPlusTreeNode* endLeaf, void* partial) {
+    for (BPlusTreeNode* leaf = firstLeaf; leaf != endLeaf; leaf = leaf->next) {
+        for (int i = 0; i < leaf->numKeys; i++) {
+            Customer* customer = (Customer*)leaf->data[i];
             if (customer->paymentType == LOAN && customer->emiMonths >= 36 && customer->emiMonths <= 48) {
-                printf("%d. %s - Mobile: %s, EMI: %d months, Amount: %.2f rupees\n",
-                       ++(*count), customer->name, customer->mobileNo, customer->emiMonths, customer->emiAmount);
+                pointerListAppend((PointerList*)partial, customer);
             }
         }
-        findCustomersWithEMIInRange(node->next, count);
-    } else {
-        for (int i = 0; i <= node->numKeys; i++) {
-            findCustomersWithEMIInRange(node->children[i], count);
-        }
     }
 }
 
 void printCustomersWithEMIInRange() {
     printf("Customers with EMI plan between 36 and 48 months:\n");
-    int count = 0;
+    BPlusTree** trees = (BPlusTree**)malloc((numSalesPersonTrees > 0 ? numSalesPersonTrees : 1) * sizeof(BPlusTree*));
+    if (trees == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
     for (int i = 0; i < numSalesPersonTrees; i++) {
-        findCustomersWithEMIInRange(salesPersonCustomerTrees[i].customerTree->root, &count);
+        trees[i] = salesPersonCustomerTrees[i].customerTree;
+    }
+    PointerList* partials;
+    int numPartials = parallelScanTrees(trees, numSalesPersonTrees, findCustomersWithEMIInRange,
+                                        sizeof(PointerList), (void**)&partials);
+    int count = 0;
+    for (int p = 0; p < numPartials; p++) {
+        for (int i = 0; i < partials[p].count; i++) {
+            Customer* customer = (Customer*)partials[p].items[i];
+            printf("%d. %s - Mobile: %s, EMI: %d months, Amount: %.2f rupees\n",
+                   ++count, customerName(customer), customer->mobileNo, customer->emiMonths,
+                   moneyToRupees(customer->emiAmount));
+        }
+        free(partials[p].items);
     }
+    free(partials);
+    free(trees);
     if (count == 0) {
         printf("No customers found with EMI between 36 and 48 months.\n");
     }
 }
 
-// Deletion functions
-int finddeleteKeyPosition(BPlusTreeNode* node, char* key) {
-    int idx = 0;
-    while (idx < node->numKeys && strcmp(key, node->keys[idx]) > 0) {
-        idx++;
+// J. Search cars by price, fuel type and body type
+int bitmapContainerIndex(const RoaringBitmap* bitmap, uint16_t key) {
+    int lo = 0, hi = bitmap->numContainers - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (bitmap->containers[mid].key == key) return mid;
+        if (bitmap->containers[mid].key < key) lo = mid + 1;
+        else hi = mid - 1;
     }
-    return idx;
+    return -(lo + 1);
 }
 
-char* getPredecessor(BPlusTreeNode* node, int idx) {
-    BPlusTreeNode* curr = node->children[idx];
-    while (!curr->isLeaf) {
-        curr = curr->children[curr->numKeys];
+BitmapContainer* bitmapInsertContainer(RoaringBitmap* bitmap, int pos, uint16_t key) {
+    if (bitmap->numContainers == bitmap->capacity) {
+        int newCapacity = bitmap->capacity == 0 ? 4 : bitmap->capacity * 2;
+        BitmapContainer* temp = (BitmapContainer*)realloc(bitmap->containers, newCapacity * sizeof(BitmapContainer));
+        if (temp == NULL) {
+            fprintf(stderr, "Memory allocation failed for bitmap\n");
+            exit(EXIT_FAILURE);
+        }
+        bitmap->containers = temp;
+        bitmap->capacity = newCapacity;
     }
-    return curr->keys[curr->numKeys - 1];
+    memmove(&bitmap->containers[pos + 1], &bitmap->containers[pos],
+            (bitmap->numContainers - pos) * sizeof(BitmapContainer));
+    BitmapContainer* container = &bitmap->containers[pos];
+    container->key = key;
+    container->cardinality = 0;
+    container->capacity = 0;
+    container->array = NULL;
+    container->words = NULL;
+    bitmap->numContainers++;
+    return container;
 }
 
-void removeFromLeaf(BPlusTreeNode* node, int idx) {
-    for (int i = idx + 1; i < node->numKeys; i++) {
-        strcpy(node->keys[i - 1], node->keys[i]);
-        node->data[i - 1] = node->data[i];
+bool containerContains(const BitmapContainer* container, uint16_t low) {
+    if (container->words != NULL) {
+        return (container->words[low >> 6] >> (low & 63)) & 1;
     }
-    node->numKeys--;
+    int lo = 0, hi = container->cardinality - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (container->array[mid] == low) return true;
+        if (container->array[mid] < low) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return false;
 }
 
-void borrowFromPrev(BPlusTreeNode* parent, int idx) {
-    BPlusTreeNode* child = parent->children[idx];
-    BPlusTreeNode* sibling = parent->children[idx - 1];
-    for (int i = child->numKeys - 1; i >= 0; i--) {
-        strcpy(child->keys[i + 1], child->keys[i]);
-        child->data[i + 1] = child->data[i];
-    }
-    if (!child->isLeaf) {
-        for (int i = child->numKeys; i >= 0; i--) {
-            child->children[i + 1] = child->children[i];
-        }
+void containerToBitset(BitmapContainer* container) {
+    uint64_t* words = (uint64_t*)calloc(BITMAP_WORDS, sizeof(uint64_t));
+    if (words == NULL) {
+        fprintf(stderr, "Memory allocation failed for bitmap\n");
+        exit(EXIT_FAILURE);
     }
-    strcpy(child->keys[0], parent->keys[idx - 1]);
-    child->data[0] = parent->data[idx - 1];
-    if (!child->isLeaf) {
-        child->children[0] = sibling->children[sibling->numKeys];
+    for (int i = 0; i < container->cardinality; i++) {
+        words[container->array[i] >> 6] |= 1ULL << (container->array[i] & 63);
     }
-    strcpy(parent->keys[idx - 1], sibling->keys[sibling->numKeys - 1]);
-    parent->data[idx - 1] = sibling->data[sibling->numKeys - 1];
-    child->numKeys++;
-    sibling->numKeys--;
+    free(container->array);
+    container->array = NULL;
+    container->capacity = 0;
+    container->words = words;
 }
 
-void borrowFromNext(BPlusTreeNode* parent, int idx) {
-    BPlusTreeNode* child = parent->children[idx];
-    BPlusTreeNode* sibling = parent->children[idx + 1];
-    strcpy(child->keys[child->numKeys], parent->keys[idx]);
-    child->data[child->numKeys] = parent->data[idx];
-    if (!child->isLeaf) {
-        child->children[child->numKeys + 1] = sibling->children[0];
-    }
-    strcpy(parent->keys[idx], sibling->keys[0]);
-    parent->data[idx] = sibling->data[0];
-    for (int i = 1; i < sibling->numKeys; i++) {
-        strcpy(sibling->keys[i - 1], sibling->keys[i]);
-        sibling->data[i - 1] = sibling->data[i];
+void bitmapAdd(RoaringBitmap* bitmap, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    uint16_t low = (uint16_t)(value & 0xFFFF);
+    int idx = bitmapContainerIndex(bitmap, key);
+    BitmapContainer* container = idx >= 0 ? &bitmap->containers[idx]
+                                          : bitmapInsertContainer(bitmap, -idx - 1, key);
+    if (container->words == NULL && container->cardinality == BITMAP_ARRAY_MAX) {
+        containerToBitset(container);
     }
-    if (!sibling->isLeaf) {
-        for (int i = 1; i <= sibling->numKeys; i++) {
-            sibling->children[i - 1] = sibling->children[i];
+    if (container->words != NULL) {
+        uint64_t mask = 1ULL << (low & 63);
+        if (!(container->words[low >> 6] & mask)) {
+            container->words[low >> 6] |= mask;
+            container->cardinality++;
         }
+        return;
     }
-    child->numKeys++;
-    sibling->numKeys--;
-}
 
-void merge(BPlusTreeNode* parent, int idx) {
-    BPlusTreeNode* child = parent->children[idx];
-    BPlusTreeNode* sibling = parent->children[idx + 1];
-    strcpy(child->keys[child->numKeys], parent->keys[idx]);
-    child->data[child->numKeys] = parent->data[idx];
-    for (int i = 0; i < sibling->numKeys; i++) {
-        strcpy(child->keys[child->numKeys + 1 + i], sibling->keys[i]);
-        child->data[child->numKeys + 1 + i] = sibling->data[i];
+    int pos = 0, hi = container->cardinality;
+    while (pos < hi) {
+        int mid = (pos + hi) / 2;
+        if (container->array[mid] < low) pos = mid + 1;
+        else hi = mid;
     }
-    if (!child->isLeaf) {
-        for (int i = 0; i <= sibling->numKeys; i++) {
-            child->children[child->numKeys + 1 + i] = sibling->children[i];
+    if (pos < container->cardinality && container->array[pos] == low) return;
+    if (container->cardinality == container->capacity) {
+        int newCapacity = container->capacity == 0 ? 8 : container->capacity * 2;
+        uint16_t* temp = (uint16_t*)realloc(container->array, newCapacity * sizeof(uint16_t));
+        if (temp == NULL) {
+            fprintf(stderr, "Memory allocation failed for bitmap\n");
+            exit(EXIT_FAILURE);
         }
+        container->array = temp;
+        container->capacity = newCapacity;
     }
-    for (int i = idx + 1; i < parent->numKeys; i++) {
-        strcpy(parent->keys[i - 1], parent->keys[i]);
-        parent->data[i - 1] = parent->data[i];
-    }
-    for (int i = idx + 2; i <= parent->numKeys; i++) {
-        parent->children[i - 1] = parent->children[i];
-    }
-    child->numKeys += sibling->numKeys + 1;
-    parent->numKeys--;
-    free(sibling);
+    memmove(&container->array[pos + 1], &container->array[pos],
+            (container->cardinality - pos) * sizeof(uint16_t));
+    container->array[pos] = low;
+    container->cardinality++;
 }
 
-void fill(BPlusTreeNode* parent, int idx, int minKeys) {
-    if (idx != 0 && parent->children[idx - 1]->numKeys > minKeys) {
-        borrowFromPrev(parent, idx);
-    } else if (idx != parent->numKeys && parent->children[idx + 1]->numKeys > minKeys) {
-        borrowFromNext(parent, idx);
-    } else {
-        if (idx != parent->numKeys) {
-            merge(parent, idx);
-        } else {
-            merge(parent, idx - 1);
-        }
-    }
+bool bitmapContains(const RoaringBitmap* bitmap, uint32_t value) {
+    int idx = bitmapContainerIndex(bitmap, (uint16_t)(value >> 16));
+    return idx >= 0 && containerContains(&bitmap->containers[idx], (uint16_t)(value & 0xFFFF));
 }
 
-void deleteKeyHelper(BPlusTreeNode* node, char* key, int minKeys) {
-    int idx = finddeleteKeyPosition(node, key);
-    if (idx < node->numKeys && strcmp(node->keys[idx], key) == 0) {
-        if (node->isLeaf) {
-            removeFromLeaf(node, idx);
+// result must be empty; neither input is modified
+void bitmapAnd(RoaringBitmap* result, const RoaringBitmap* a, const RoaringBitmap* b) {
+    int i = 0, j = 0;
+    while (i < a->numContainers && j < b->numContainers) {
+        const BitmapContainer* ca = &a->containers[i];
+        const BitmapContainer* cb = &b->containers[j];
+        if (ca->key < cb->key) { i++; continue; }
+        if (ca->key > cb->key) { j++; continue; }
+
+        BitmapContainer* out = bitmapInsertContainer(result, result->numContainers, ca->key);
+        if (ca->words != NULL && cb->words != NULL) {
+            uint64_t* words = (uint64_t*)malloc(BITMAP_WORDS * sizeof(uint64_t));
+            if (words == NULL) {
+                fprintf(stderr, "Memory allocation failed for bitmap\n");
+                exit(EXIT_FAILURE);
+            }
+            int cardinality = 0;
+            for (int w = 0; w < BITMAP_WORDS; w++) {
+                words[w] = ca->words[w] & cb->words[w];
+                cardinality += __builtin_popcountll(words[w]);
+            }
+            out->words = words;
+            out->cardinality = cardinality;
         } else {
-            char* predecessor = getPredecessor(node, idx);
-            strcpy(node->keys[idx], predecessor);
-            BPlusTreeNode* predNode = node->children[idx];
-            while (!predNode->isLeaf) {
-                predNode = predNode->children[predNode->numKeys];
+            // Probe the other container with each element of the sparse one
+            const BitmapContainer* sparse = ca->words == NULL ? ca : cb;
+            const BitmapContainer* other = sparse == ca ? cb : ca;
+            out->capacity = sparse->cardinality;
+            out->array = (uint16_t*)malloc((out->capacity > 0 ? out->capacity : 1) * sizeof(uint16_t));
+            if (out->array == NULL) {
+                fprintf(stderr, "Memory allocation failed for bitmap\n");
+                exit(EXIT_FAILURE);
+            }
+            for (int k = 0; k < sparse->cardinality; k++) {
+                if (containerContains(other, sparse->array[k])) {
+                    out->array[out->cardinality++] = sparse->array[k];
+                }
             }
-            node->data[idx] = predNode->data[predNode->numKeys - 1];
-            deleteKeyHelper(node->children[idx], predecessor, minKeys);
-        }
-    } else {
-        if (node->isLeaf) {
-            printf("Key %s not found in the B+ tree.\n", key);
-            return;
-        }
-        bool isLastChild = (idx == node->numKeys);
-        if (node->children[idx]->numKeys <= minKeys) {
-            fill(node, idx, minKeys);
         }
-        if (isLastChild && idx > node->numKeys) {
-            deleteKeyHelper(node->children[idx - 1], key, minKeys);
-        } else {
-            deleteKeyHelper(node->children[idx], key, minKeys);
+        if (out->cardinality == 0) {
+            free(out->array);
+            free(out->words);
+            result->numContainers--;
         }
+        i++;
+        j++;
     }
 }
 
-void deleteFromBPlusTree(BPlusTree* tree, char* key) {
-    if (tree->root == NULL) {
-        return;
+void bitmapFree(RoaringBitmap* bitmap) {
+    for (int i = 0; i < bitmap->numContainers; i++) {
+        free(bitmap->containers[i].array);
+        free(bitmap->containers[i].words);
+    }
+    free(bitmap->containers);
+    bitmap->containers = NULL;
+    bitmap->numContainers = 0;
+    bitmap->capacity = 0;
+}
+
+// Fixed-width price key so that string order matches numeric order
+void priceKey(Money price, char* key) {
+    if (price < 0) price = 0;
+    if (price > 999999999999999999LL) price = 999999999999999999LL;
+    sprintf(key, "%018lld", (long long)price);
+}
+
+// Car trees keep row + 1 in a leaf's data slot, so a missing key still reads as NULL
+void* carRef(int row) {
+    return (void*)(intptr_t)(row + 1);
+}
+
+int carRow(const void* ref) {
+    return (int)(intptr_t)ref - 1;
+}
+
+// Row of the car with this VIN, -1 if there is none
+int findCarRow(const char* VIN) {
+    return carRow(searchInBPlusTree(carTree, (char*)VIN));
+}
+
+// Appends the car to the columns and adds its row to the attribute bitmaps and name index
+int assignCarRow(const Car* car) {
+    int row = appendCarColumns(car);
+    if ((int)car->fuelType >= PETROL && (int)car->fuelType <= HYBRID) {
+        bitmapAdd(&fuelTypeBitmaps[car->fuelType], row);
     }
-    int minKeys = (tree->order / 2) - 1;
-    deleteKeyHelper(tree->root, key, minKeys);
-    if (tree->root->numKeys == 0 && !tree->root->isLeaf) {
-        BPlusTreeNode* oldRoot = tree->root;
-        tree->root = tree->root->children[0];
-        free(oldRoot);
+    if ((int)car->carType >= HATCHBACK && (int)car->carType <= SUV) {
+        bitmapAdd(&carTypeBitmaps[car->carType], row);
     }
-    if (tree->root->numKeys == 0 && tree->root->isLeaf) {
-        BPlusTreeNode* oldRoot = tree->root;
-        tree->root = NULL;
-        free(oldRoot);
+    if (car->showroomId >= 1 && car->showroomId <= MAX_SHOWROOMS) {
+        bitmapAdd(&showroomBitmaps[car->showroomId - 1], row);
+    }
+    if (car->isSold) {
+        bitmapAdd(&soldCarBitmap, row);
     }
+    textIndexInsert(&carNameIndex, carName(row), carRef(row));
+    return row;
 }
 
-void printNode(BPlusTreeNode* node, int level) {
-    if (node == NULL) return;
-    for (int i = 0; i < level; i++) {
-        printf("  ");
+// Appends the car and adds its row to the price tree and attribute bitmaps
+int registerCarRow(const Car* car) {
+    int row = assignCarRow(car);
+    char key[20];
+    priceKey(car->price, key);
+    insertIntoBPlusTree(carPriceTree, key, carRef(row));
+    return row;
+}
+
+// The caller sets the sold flag in the columns; this keeps the sold bitmap in step
+void markCarRowSold(int row) {
+    bitmapAdd(&soldCarBitmap, row);
+}
+
+// Intersects the attribute bitmaps, then range-scans the price tree against them.
+// Returns the number of matches; *results is a malloc'd array of car rows in price order.
+int searchCarsByAttributes(const CarQuery* query, int** results) {
+    const RoaringBitmap* filters[3];
+    int numFilters = 0;
+    if (query->fuelType >= PETROL && query->fuelType <= HYBRID) {
+        filters[numFilters++] = &fuelTypeBitmaps[query->fuelType];
     }
-    printf("Keys: ");
-    for (int i = 0; i < node->numKeys; i++) {
-        printf("%s ", node->keys[i]);
+    if (query->carType >= HATCHBACK && query->carType <= SUV) {
+        filters[numFilters++] = &carTypeBitmaps[query->carType];
     }
-    printf("\n");
-    if (!node->isLeaf) {
-        for (int i = 0; i <= node->numKeys; i++) {
-            printNode(node->children[i], level + 1);
+    if (query->showroomId >= 1 && query->showroomId <= MAX_SHOWROOMS) {
+        filters[numFilters++] = &showroomBitmaps[query->showroomId - 1];
+    }
+
+    RoaringBitmap combined = {0};
+    const RoaringBitmap* filter = NULL;
+    if (numFilters == 1) {
+        filter = filters[0];
+    } else if (numFilters > 1) {
+        bitmapAnd(&combined, filters[0], filters[1]);
+        for (int i = 2; i < numFilters; i++) {
+            RoaringBitmap next = {0};
+            bitmapAnd(&next, &combined, filters[i]);
+            bitmapFree(&combined);
+            combined = next;
         }
+        filter = &combined;
     }
-}
 
-void printBPlusTree(BPlusTree* tree) {
-    if (tree->root == NULL) {
-        printf("Empty tree.\n");
-        return;
+    *results = NULL;
+    int count = 0, capacity = 0;
+    if (filter == NULL || filter->numContainers > 0) {
+        char lowKey[20], highKey[20];
+        priceKey(query->minPrice, lowKey);
+        priceKey(query->maxPrice, highKey);
+        BPlusTreeNode* leaf = findLeafForKey(carPriceTree, lowKey);
+        bool done = false;
+        while (leaf != NULL && !done) {
+            for (int i = 0; i < leaf->numKeys; i++) {
+                if (strcmp(leaf->keys[i], lowKey) < 0) continue;
+                if (strcmp(leaf->keys[i], highKey) > 0) {
+                    done = true;
+                    break;
+                }
+                int row = carRow(leaf->data[i]);
+                if (filter != NULL && !bitmapContains(filter, row)) continue;
+                if (!query->includeSold && carColumns.isSold[row]) continue;
+                if (count == capacity) {
+                    capacity = capacity == 0 ? 16 : capacity * 2;
+                    int* temp = (int*)realloc(*results, capacity * sizeof(int));
+                    if (temp == NULL) {
+                        fprintf(stderr, "Memory allocation failed for search results\n");
+                        break;
+                    }
+                    *results = temp;
+                }
+                (*results)[count++] = row;
+            }
+            leaf = leaf->next;
+        }
     }
-    printNode(tree->root, 0);
+    bitmapFree(&combined);
+    return count;
 }
 
-void saveCarsToFile() {
-    FILE* fp = fopen("cars.txt", "w");
-    if (!fp) {
-        printf("Error opening cars.txt for writing.\n");
-        return;
+void displayCarSearchResults(const CarQuery* query) {
+    int* results;
+    int count = searchCarsByAttributes(query, &results);
+    printf("\n=== Cars between %.2f and %.2f lakhs ===\n", moneyToLakhs(query->minPrice), moneyToLakhs(query->maxPrice));
+    printf("VIN\t\tName\t\tColor\tPrice\tFuel Type\tCar Type\tStatus\tShowroom ID\n");
+    printf("----------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < count; i++) {
+        int row = results[i];
+        printf("%-16s%-16s%-8s%-8.2f%-12s%-12s%-8s%d\n",
+               carColumns.VIN[row], carName(row), carColor(row), moneyToLakhs(carColumns.price[row]),
+               fuelTypeToString((FuelType)carColumns.fuelType[row]), carTypeToString((CarType)carColumns.carType[row]),
+               carColumns.isSold[row] ? "Sold" : "Available", carColumns.showroomId[row]);
     }
-    BPlusTreeNode* current = carTree->root;
-    while (current && !current->isLeaf) current = current->children[0];
-    while (current) {
-        for (int i = 0; i < current->numKeys; i++) {
-            Car* car = (Car*)current->data[i];
-            fprintf(fp, "%s,%s,%s,%.2f,%d,%d,%d,%d\n",
-                    car->VIN, car->name, car->color, car->price,
-                    car->fuelType, car->carType, car->isSold, car->showroomId);
-        }
-        current = current->next;
+    if (count == 0) {
+        printf("No cars match the search.\n");
     }
-    fclose(fp);
+    printf("Total matches: %d\n", count);
+    free(results);
 }
 
-void loadCarsFromFile() {
-    FILE* fp = fopen("cars.txt", "r");
-    if (!fp) return;
-    char line[256];
-    while (fgets(line, sizeof(line), fp)) {
-        Car* car = (Car*)malloc(sizeof(Car));
-        int isSold;
-        sscanf(line, "%19[^,],%99[^,],%99[^,],%lf,%d,%d,%d,%d",
-               car->VIN, car->name, car->color, &car->price,
-               (int*)&car->fuelType, (int*)&car->carType, &isSold, &car->showroomId);
-        car->isSold = (bool)isSold;
-        insertIntoBPlusTree(carTree, car->VIN, car);
-        if (car->isSold)
-            insertIntoBPlusTree(soldCarTree, car->VIN, car);
-        else
-            insertIntoBPlusTree(availableCarTree, car->VIN, car);
+// Car columns and inventory analytics
+// Appends the car as a new row and returns its row id
+int appendCarColumns(const Car* car) {
+    if (carColumns.numRows == carColumns.capacity) {
+        int newCapacity = carColumns.capacity == 0 ? 64 : carColumns.capacity * 2;
+        char (*VIN)[20] = realloc(carColumns.VIN, newCapacity * sizeof(*VIN));
+        if (VIN) carColumns.VIN = VIN;
+        uint32_t* nameId = (uint32_t*)realloc(carColumns.nameId, newCapacity * sizeof(uint32_t));
+        if (nameId) carColumns.nameId = nameId;
+        uint32_t* colorId = (uint32_t*)realloc(carColumns.colorId, newCapacity * sizeof(uint32_t));
+        if (colorId) carColumns.colorId = colorId;
+        Money* price = (Money*)realloc(carColumns.price, newCapacity * sizeof(Money));
+        if (price) carColumns.price = price;
+        int* showroomId = (int*)realloc(carColumns.showroomId, newCapacity * sizeof(int));
+        if (showroomId) carColumns.showroomId = showroomId;
+        uint8_t* fuelType = (uint8_t*)realloc(carColumns.fuelType, newCapacity);
+        if (fuelType) carColumns.fuelType = fuelType;
+        uint8_t* carType = (uint8_t*)realloc(carColumns.carType, newCapacity);
+        if (carType) carColumns.carType = carType;
+        uint8_t* isSold = (uint8_t*)realloc(carColumns.isSold, newCapacity);
+        if (isSold) carColumns.isSold = isSold;
+        if (!VIN || !nameId || !colorId || !price || !showroomId || !fuelType || !carType || !isSold) {
+            fprintf(stderr, "Memory allocation failed for car columns\n");
+            exit(EXIT_FAILURE);
+        }
+        carColumns.capacity = newCapacity;
     }
-    fclose(fp);
+    int row = carColumns.numRows++;
+    strcpy(carColumns.VIN[row], car->VIN);
+    carColumns.nameId[row] = car->nameId;
+    carColumns.colorId[row] = car->colorId;
+    carColumns.price[row] = car->price;
+    carColumns.showroomId[row] = car->showroomId;
+    carColumns.fuelType[row] = (uint8_t)car->fuelType;
+    carColumns.carType[row] = (uint8_t)car->carType;
+    carColumns.isSold[row] = car->isSold ? 1 : 0;
+    return row;
 }
 
-void saveCustomersToFile() {
-    FILE* fp = fopen("customers.txt", "w");
-    if (!fp) {
-        printf("Error opening customers.txt for writing.\n");
-        return;
-    }
-    for (int i = 0; i < numSalesPersonTrees; i++) {
-        BPlusTreeNode* current = salesPersonCustomerTrees[i].customerTree->root;
-        while (current && !current->isLeaf) current = current->children[0];
-        while (current) {
-            for (int j = 0; j < current->numKeys; j++) {
-                Customer* customer = (Customer*)current->data[j];
-                fprintf(fp, "%s,%s,%s,%s,%s,%s,%d,%d,%.2f,%.2f,%.2f\n",
-                        salesPersonCustomerTrees[i].salesPersonId, customer->name, customer->mobileNo,
-                        customer->address, customer->VIN, customer->registrationNo,
-                        customer->paymentType, customer->emiMonths, customer->downPayment,
-                        customer->loanAmount, customer->emiAmount);
-            }
-            current = current->next;
-        }
+void freeCarColumns() {
+    free(carColumns.VIN);
+    free(carColumns.nameId);
+    free(carColumns.colorId);
+    free(carColumns.price);
+    free(carColumns.showroomId);
+    free(carColumns.fuelType);
+    free(carColumns.carType);
+    free(carColumns.isSold);
+    memset(&carColumns, 0, sizeof(carColumns));
+}
+
+// Masked sums over the columns; no per-row branches so the loops vectorize
+void inventoryValueForShowroom(int showroomId, Money* availableValue, Money* soldValue,
+                               int* availableCars, int* soldCars) {
+    const int n = carColumns.numRows;
+    const Money* restrict price = carColumns.price;
+    const int* restrict showroom = carColumns.showroomId;
+    const uint8_t* restrict sold = carColumns.isSold;
+    Money available = 0, soldTotal = 0;
+    int availableCount = 0, soldCount = 0;
+    for (int r = 0; r < n; r++) {
+        int inShowroom = showroom[r] == showroomId;
+        int isAvailable = inShowroom & (sold[r] == 0);
+        int isSold = inShowroom & (sold[r] != 0);
+        available += price[r] & -(Money)isAvailable;
+        soldTotal += price[r] & -(Money)isSold;
+        availableCount += isAvailable;
+        soldCount += isSold;
     }
-    fclose(fp);
+    *availableValue = available;
+    *soldValue = soldTotal;
+    *availableCars = availableCount;
+    *soldCars = soldCount;
 }
 
-void loadCustomersFromFile() {
-    FILE* fp = fopen("customers.txt", "r");
-    if (!fp) return;
-    char line[512];
-    while (fgets(line, sizeof(line), fp)) {
-        Customer* customer = (Customer*)malloc(sizeof(Customer));
-        char salesPersonId[50];
-        sscanf(line, "%49[^,],%99[^,],%14[^,],%99[^,],%19[^,],%19[^,],%d,%d,%lf,%lf,%lf",
-               salesPersonId, customer->name, customer->mobileNo, customer->address,
-               customer->VIN, customer->registrationNo, (int*)&customer->paymentType,
-               &customer->emiMonths, &customer->downPayment, &customer->loanAmount,
-               &customer->emiAmount);
-        BPlusTree* customerTree = getCustomerTreeForSalesPerson(salesPersonId);
-        insertIntoBPlusTree(customerTree, customer->mobileNo, customer);
+void soldRatioForFuelType(int fuelType, int* totalCars, int* soldCars) {
+    const int n = carColumns.numRows;
+    const uint8_t* restrict fuel = carColumns.fuelType;
+    const uint8_t* restrict sold = carColumns.isSold;
+    int total = 0, soldCount = 0;
+    for (int r = 0; r < n; r++) {
+        int match = fuel[r] == fuelType;
+        total += match;
+        soldCount += match & (sold[r] != 0);
     }
-    fclose(fp);
+    *totalCars = total;
+    *soldCars = soldCount;
 }
 
-void saveSalesPersonsToFile() {
-    FILE* fp = fopen("salespersons.txt", "w");
-    if (!fp) {
-        printf("Error opening salespersons.txt for writing.\n");
-        return;
+void displayInventoryAnalytics() {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Money availableValue[MAX_SHOWROOMS], soldValue[MAX_SHOWROOMS];
+    int availableCars[MAX_SHOWROOMS], soldCars[MAX_SHOWROOMS];
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        inventoryValueForShowroom(i + 1, &availableValue[i], &soldValue[i], &availableCars[i], &soldCars[i]);
+    }
+    int fuelTotal[HYBRID + 1], fuelSold[HYBRID + 1];
+    for (int f = PETROL; f <= HYBRID; f++) {
+        soldRatioForFuelType(f, &fuelTotal[f], &fuelSold[f]);
     }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsedMs = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    printf("\n=== Inventory Value by Showroom ===\n");
+    printf("Showroom\tAvailable\tValue (lakhs)\tSold\tValue (lakhs)\n");
     for (int i = 0; i < MAX_SHOWROOMS; i++) {
-        if (salesPersonTrees[i]) {
-            BPlusTreeNode* current = salesPersonTrees[i]->root;
-            while (current && !current->isLeaf) current = current->children[0];
-            while (current) {
-                for (int j = 0; j < current->numKeys; j++) {
-                    SalesPerson* person = (SalesPerson*)current->data[j];
-                    fprintf(fp, "%d,%d,%s,%.2f,%.2f,%.2f,%d,%d\n",
-                            i + 1, person->id, person->name, person->salesTarget,
-                            person->salesAchieved, person->commission, person->numSales,
-                            person->extraIncentive);
-                }
-                current = current->next;
-            }
-        }
+        printf("%-16d%-16d%-16.2f%-8d%.2f\n", i + 1, availableCars[i], moneyToLakhs(availableValue[i]),
+               soldCars[i], moneyToLakhs(soldValue[i]));
     }
-    fclose(fp);
+    printf("\n=== Sold Ratio by Fuel Type ===\n");
+    for (int f = PETROL; f <= HYBRID; f++) {
+        printf("%-12s%d of %d sold (%.1f%%)\n", fuelTypeToString((FuelType)f), fuelSold[f], fuelTotal[f],
+               fuelTotal[f] > 0 ? 100.0 * fuelSold[f] / fuelTotal[f] : 0.0);
+    }
+    printf("Scanned %d rows in %.3f ms\n", carColumns.numRows, elapsedMs);
 }
 
-void loadSalesPersonsFromFile() {
-    FILE* fp = fopen("salespersons.txt", "r");
-    if (!fp) return;
-    char line[256];
-    while (fgets(line, sizeof(line), fp)) {
-        SalesPerson* person = (SalesPerson*)malloc(sizeof(SalesPerson));
-        int showroomId, extraIncentive;
-        sscanf(line, "%d,%d,%99[^,],%lf,%lf,%lf,%d,%d",
-               &showroomId, &person->id, person->name, &person->salesTarget,
-               &person->salesAchieved, &person->commission, &person->numSales,
-               &extraIncentive);
-        person->extraIncentive = (bool)extraIncentive;
-        char key[20];
-        sprintf(key, "%d", person->id);
-        insertIntoBPlusTree(salesPersonTrees[showroomId - 1], key, person);
+// K. Prefix and fuzzy name search
+TrieNode* createTrieNode(char ch) {
+    TrieNode* node = (TrieNode*)calloc(1, sizeof(TrieNode));
+    if (node == NULL) {
+        fprintf(stderr, "Memory allocation failed for TrieNode\n");
+        exit(EXIT_FAILURE);
     }
-    fclose(fp);
+    node->ch = ch;
+    return node;
 }
 
-void saveShowroomsToFile() {
-    FILE* fp = fopen("showrooms.txt", "w");
-    if (!fp) {
-        printf("Error opening showrooms.txt for writing.\n");
-        return;
+TrieNode* trieChild(TrieNode* node, char ch, bool create) {
+    TrieNode** link = &node->firstChild;
+    while (*link != NULL && (*link)->ch < ch) {
+        link = &(*link)->nextSibling;
     }
-    BPlusTreeNode* current = showroomTree->root;
-    while (current && !current->isLeaf) current = current->children[0];
-    while (current) {
-        for (int i = 0; i < current->numKeys; i++) {
-            Showroom* showroom = (Showroom*)current->data[i];
-            fprintf(fp, "%d,%s,%s,%d,%d,%d,%.2f,%.2f,%.2f,%.2f,%d,%d,%d\n",
-                    showroom->id, showroom->name, showroom->manufacturer,
-                    showroom->numTotalCars, showroom->numAvailableCars,
-                    showroom->numSoldCars, showroom->totalSales, 
-                    showroom->lastMonthSales, showroom->twoMonthsAgoSales, 
-                    showroom->threeMonthsAgoSales, showroom->lastMonthCars,
-                    showroom->twoMonthsAgoCars, showroom->threeMonthsAgoCars);
-        }
-        current = current->next;
+    if (*link != NULL && (*link)->ch == ch) {
+        return *link;
     }
-    fclose(fp);
+    if (!create) {
+        return NULL;
+    }
+    TrieNode* child = createTrieNode(ch);
+    child->nextSibling = *link;
+    *link = child;
+    return child;
 }
 
-void loadShowroomsFromFile() {
-    FILE* fp = fopen("showrooms.txt", "r");
-    if (!fp) return;
-    char line[256];
-    while (fgets(line, sizeof(line), fp)) {
-        Showroom* showroom = (Showroom*)malloc(sizeof(Showroom));
-        sscanf(line, "%d,%99[^,],%99[^,],%d,%d,%d,%lf,%lf,%lf,%lf,%d,%d,%d",
-               &showroom->id, showroom->name, showroom->manufacturer,
-               &showroom->numTotalCars, &showroom->numAvailableCars,
-               &showroom->numSoldCars, &showroom->totalSales, 
-               &showroom->lastMonthSales, &showroom->twoMonthsAgoSales, 
-               &showroom->threeMonthsAgoSales, &showroom->lastMonthCars,
-               &showroom->twoMonthsAgoCars, &showroom->threeMonthsAgoCars);
-        char key[20];
-        sprintf(key, "%d", showroom->id);
-        insertIntoBPlusTree(showroomTree, key, showroom);
+void textIndexInsert(TextIndex* index, const char* text, void* record) {
+    if (index->root == NULL) {
+        index->root = createTrieNode('\0');
     }
-    fclose(fp);
+    TrieNode* node = index->root;
+    for (const char* p = text; *p; p++) {
+        node = trieChild(node, (char)tolower((unsigned char)*p), true);
+    }
+    if (node->numPostings == node->capacity) {
+        int newCapacity = node->capacity == 0 ? 2 : node->capacity * 2;
+        void** temp = (void**)realloc(node->postings, newCapacity * sizeof(void*));
+        if (temp == NULL) {
+            fprintf(stderr, "Memory allocation failed for text index\n");
+            return;
+        }
+        node->postings = temp;
+        node->capacity = newCapacity;
+    }
+    node->postings[node->numPostings++] = record;
+    index->numEntries++;
 }
 
-void addCar(int showroomId, Car* car) {
-    if (showroomId < 1 || showroomId > MAX_SHOWROOMS) {
-        printf("Invalid showroom ID %d. Must be between 1 and %d.\n", showroomId, MAX_SHOWROOMS);
-        return;
+void trieCollect(TrieNode* node, void** results, int* count, int maxResults) {
+    for (int i = 0; i < node->numPostings && *count < maxResults; i++) {
+        results[(*count)++] = node->postings[i];
+    }
+    for (TrieNode* child = node->firstChild; child != NULL && *count < maxResults; child = child->nextSibling) {
+        trieCollect(child, results, count, maxResults);
     }
+}
 
-    if (searchInBPlusTree(carTree, car->VIN) != NULL) {
-        printf("Car with VIN %s already exists.\n", car->VIN);
-        return;
+// Returns up to maxResults records whose name starts with prefix (case-insensitive)
+int textIndexPrefixSearch(TextIndex* index, const char* prefix, void*** results, int maxResults) {
+    *results = (void**)malloc((maxResults > 0 ? maxResults : 1) * sizeof(void*));
+    if (*results == NULL || index->root == NULL) {
+        return 0;
+    }
+    TrieNode* node = index->root;
+    for (const char* p = prefix; *p && node != NULL; p++) {
+        node = trieChild(node, (char)tolower((unsigned char)*p), false);
     }
+    int count = 0;
+    if (node != NULL) {
+        trieCollect(node, *results, &count, maxResults);
+    }
+    return count;
+}
 
-    Car* newCar = (Car*)malloc(sizeof(Car));
-    if (newCar == NULL) {
-        fprintf(stderr, "Memory allocation failed for Car\n");
+// One Levenshtein DP row per trie level; branches whose best cell exceeds maxDistance are pruned
+void trieFuzzyWalk(TrieNode* node, const char* query, int queryLen, const int* prevRow,
+                   int maxDistance, void** results, int* count, int maxResults) {
+    int row[MAX_STRING + 1];
+    row[0] = prevRow[0] + 1;
+    int best = row[0];
+    for (int j = 1; j <= queryLen; j++) {
+        int cost = (query[j - 1] == node->ch) ? 0 : 1;
+        int value = prevRow[j - 1] + cost;
+        if (prevRow[j] + 1 < value) value = prevRow[j] + 1;
+        if (row[j - 1] + 1 < value) value = row[j - 1] + 1;
+        row[j] = value;
+        if (value < best) best = value;
+    }
+    if (row[queryLen] <= maxDistance) {
+        for (int i = 0; i < node->numPostings && *count < maxResults; i++) {
+            results[(*count)++] = node->postings[i];
+        }
+    }
+    if (best > maxDistance) {
         return;
     }
-    *newCar = *car;
-    newCar->isSold = false;
-    newCar->showroomId = showroomId;
-
-    insertIntoBPlusTree(carTree, newCar->VIN, newCar);
-    insertIntoBPlusTree(availableCarTree, newCar->VIN, newCar);
-
-    char showroomIdStr[20];
-    sprintf(showroomIdStr, "%d", showroomId);
-    Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
-    if (showroom != NULL) {
-        showroom->numTotalCars++;
-        showroom->numAvailableCars++;
+    for (TrieNode* child = node->firstChild; child != NULL && *count < maxResults; child = child->nextSibling) {
+        trieFuzzyWalk(child, query, queryLen, row, maxDistance, results, count, maxResults);
     }
-
-    printf("Added car %s with VIN %s to showroom %d.\n", newCar->name, newCar->VIN, showroomId);
-    saveCarsToFile();
-    saveShowroomsToFile();
 }
 
-void mergeAndSortShowroomsByVIN(const char* outputName) {
-    ShowroomCar* allCars = NULL;
-    int totalCars = 0;
-    
-    BPlusTreeNode* current = carTree->root;
+// Returns up to maxResults records whose whole name is within maxDistance edits of query
+int textIndexFuzzySearch(TextIndex* index, const char* query, int maxDistance, void*** results, int maxResults) {
+    *results = (void**)malloc((maxResults > 0 ? maxResults : 1) * sizeof(void*));
+    if (*results == NULL || index->root == NULL) {
+        return 0;
+    }
+    char lowered[MAX_STRING];
+    int queryLen = 0;
+    for (const char* p = query; *p && queryLen < MAX_STRING - 1; p++) {
+        lowered[queryLen++] = (char)tolower((unsigned char)*p);
+    }
+    lowered[queryLen] = '\0';
+
+    int row[MAX_STRING + 1];
+    for (int j = 0; j <= queryLen; j++) {
+        row[j] = j;
+    }
+    int count = 0;
+    if (queryLen <= maxDistance) {
+        for (int i = 0; i < index->root->numPostings && count < maxResults; i++) {
+            (*results)[count++] = index->root->postings[i];
+        }
+    }
+    for (TrieNode* child = index->root->firstChild; child != NULL && count < maxResults; child = child->nextSibling) {
+        trieFuzzyWalk(child, lowered, queryLen, row, maxDistance, *results, &count, maxResults);
+    }
+    return count;
+}
+
+void trieFree(TrieNode* node) {
+    while (node != NULL) {
+        TrieNode* next = node->nextSibling;
+        trieFree(node->firstChild);
+        free(node->postings);
+        free(node);
+        node = next;
+    }
+}
+
+void textIndexFree(TextIndex* index) {
+    trieFree(index->root);
+    index->root = NULL;
+    index->numEntries = 0;
+}
+
+void displayNameSearchResults(const char* text, bool fuzzy) {
+    void** results;
+    int maxDistance = strlen(text) > 6 ? 2 : 1;
+    int count = fuzzy ? textIndexFuzzySearch(&carNameIndex, text, maxDistance, &results, 50)
+                      : textIndexPrefixSearch(&carNameIndex, text, &results, 50);
+    printf("\n=== Cars matching \"%s\" ===\n", text);
+    for (int i = 0; i < count; i++) {
+        int row = carRow(results[i]);
+        printf("%-16s%-16s%-8s%-8.2f%-10s Showroom %d\n", carColumns.VIN[row], carName(row),
+               carColor(row), moneyToLakhs(carColumns.price[row]), carColumns.isSold[row] ? "Sold" : "Available",
+               carColumns.showroomId[row]);
+    }
+    if (count == 0) {
+        printf("No cars found.\n");
+    }
+    free(results);
+
+    count = fuzzy ? textIndexFuzzySearch(&customerNameIndex, text, maxDistance, &results, 50)
+                  : textIndexPrefixSearch(&customerNameIndex, text, &results, 50);
+    printf("\n=== Customers matching \"%s\" ===\n", text);
+    for (int i = 0; i < count; i++) {
+        Customer* customer = (Customer*)results[i];
+        printf("%-16s%-16s%-16s%s\n", customerName(customer), customer->mobileNo, customer->VIN,
+               paymentTypeToString(customer->paymentType));
+    }
+    if (count == 0) {
+        printf("No customers found.\n");
+    }
+    free(results);
+}
+
+// L. Rolling sales aggregates
+long dayNumber(time_t t) {
+    return (long)(t / SECONDS_PER_DAY);
+}
+
+int monthNumber(time_t t) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    return (tm.tm_year + 1900) * 12 + tm.tm_mon;
+}
+
+void formatDate(time_t t, char* buffer, size_t size) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(buffer, size, "%Y-%m-%d", &tm);
+}
+
+void rollupAddDay(SalesRollup* rollup, long day, Money amount, int cars) {
+    if (day > rollup->newestDay) {
+        long gap = day - rollup->newestDay;
+        if (gap > ROLLUP_DAYS) gap = ROLLUP_DAYS;
+        for (long d = day - gap + 1; d <= day; d++) {
+            rollup->days[d % ROLLUP_DAYS].amount = 0;
+            rollup->days[d % ROLLUP_DAYS].cars = 0;
+        }
+        rollup->newestDay = day;
+    } else if (day <= rollup->newestDay - ROLLUP_DAYS) {
+        return;  // Older than the daily ring
+    }
+    rollup->days[day % ROLLUP_DAYS].amount += amount;
+    rollup->days[day % ROLLUP_DAYS].cars += cars;
+}
+
+void rollupAddMonth(SalesRollup* rollup, int month, Money amount, int cars) {
+    if (month > rollup->newestMonth) {
+        int gap = month - rollup->newestMonth;
+        if (gap > ROLLUP_MONTHS) gap = ROLLUP_MONTHS;
+        for (int m = month - gap + 1; m <= month; m++) {
+            rollup->months[m % ROLLUP_MONTHS].amount = 0;
+            rollup->months[m % ROLLUP_MONTHS].cars = 0;
+        }
+        rollup->newestMonth = month;
+    } else if (month <= rollup->newestMonth - ROLLUP_MONTHS) {
+        return;  // Older than the monthly ring
+    }
+    rollup->months[month % ROLLUP_MONTHS].amount += amount;
+    rollup->months[month % ROLLUP_MONTHS].cars += cars;
+}
+
+void rollupRecord(SalesRollup* rollup, time_t when, Money amount, int cars) {
+    rollupAddDay(rollup, dayNumber(when), amount, cars);
+    rollupAddMonth(rollup, monthNumber(when), amount, cars);
+}
+
+// Sales in the days (now - fromDaysAgo, now - toDaysAgo]; at most ROLLUP_DAYS buckets are read
+SalesBucket rollupWindow(const SalesRollup* rollup, time_t now, int fromDaysAgo, int toDaysAgo) {
+    SalesBucket total = {0, 0};
+    long today = dayNumber(now);
+    for (long d = today - fromDaysAgo + 1; d <= today - toDaysAgo; d++) {
+        if (d > rollup->newestDay || d <= rollup->newestDay - ROLLUP_DAYS) continue;
+        total.amount += rollup->days[d % ROLLUP_DAYS].amount;
+        total.cars += rollup->days[d % ROLLUP_DAYS].cars;
+    }
+    return total;
+}
+
+SalesBucket rollupMonth(const SalesRollup* rollup, int month) {
+    SalesBucket empty = {0, 0};
+    if (month > rollup->newestMonth || month <= rollup->newestMonth - ROLLUP_MONTHS) {
+        return empty;
+    }
+    return rollup->months[month % ROLLUP_MONTHS];
+}
+
+SalesRollup* getModelRollup(uint32_t modelId) {
+    for (int i = 0; i < numModelRollups; i++) {
+        if (modelRollups[i].modelId == modelId) {
+            return &modelRollups[i].sales;
+        }
+    }
+    ModelSalesRollup* temp = (ModelSalesRollup*)realloc(modelRollups, (numModelRollups + 1) * sizeof(ModelSalesRollup));
+    if (temp == NULL) {
+        fprintf(stderr, "Memory reallocation failed\n");
+        return NULL;
+    }
+    modelRollups = temp;
+    memset(&modelRollups[numModelRollups], 0, sizeof(ModelSalesRollup));
+    modelRollups[numModelRollups].modelId = modelId;
+    numModelRollups++;
+    return &modelRollups[numModelRollups - 1].sales;
+}
+
+void displayRecentSales(int days) {
+    time_t now = time(NULL);
+    char from[11], to[11];
+    formatDate(now - (time_t)(days - 1) * SECONDS_PER_DAY, from, sizeof(from));
+    formatDate(now, to, sizeof(to));
+    if (days > ROLLUP_DAYS) {
+        printf("Only the last %d days are kept; showing those.\n", ROLLUP_DAYS);
+        days = ROLLUP_DAYS;
+    }
+    printf("\n=== Sales from %s to %s ===\n", from, to);
+
+    BPlusTreeNode* current = showroomTree->root;
     while (current && !current->isLeaf) current = current->children[0];
-    
     while (current != NULL) {
         for (int i = 0; i < current->numKeys; i++) {
-            ShowroomCar* temp = realloc(allCars, (totalCars + 1) * sizeof(ShowroomCar));
-            if (temp == NULL) {
-                printf("Memory allocation failed\n");
-                free(allCars);
-                return;
+            Showroom* showroom = (Showroom*)current->data[i];
+            SalesBucket total = rollupWindow(&showroom->sales, now, days, 0);
+            printf("\nShowroom %d: %s - %.2f lakhs (%d cars)\n", showroom->id, showroom->name,
+                   moneyToLakhs(total.amount), total.cars);
+            if (showroom->id < 1 || showroom->id > MAX_SHOWROOMS || salesPersonTrees[showroom->id - 1] == NULL) {
+                continue;
+            }
+            BPlusTreeNode* leaf = salesPersonTrees[showroom->id - 1]->root;
+            while (leaf && !leaf->isLeaf) leaf = leaf->children[0];
+            while (leaf != NULL) {
+                for (int j = 0; j < leaf->numKeys; j++) {
+                    SalesPerson* person = (SalesPerson*)leaf->data[j];
+                    SalesBucket personTotal = rollupWindow(&person->sales, now, days, 0);
+                    printf("  %-8d%-16s%.2f lakhs (%d cars)\n", person->id, person->name,
+                           moneyToLakhs(personTotal.amount), personTotal.cars);
+                }
+                leaf = leaf->next;
             }
-            allCars = temp;
-            allCars[totalCars].car = (Car*)current->data[i];
-            allCars[totalCars].showroomId = allCars[totalCars].car->showroomId;
-            totalCars++;
         }
         current = current->next;
     }
-    
-    for (int i = 0; i < totalCars - 1; i++) {
-        for (int j = 0; j < totalCars - i - 1; j++) {
-            if (strcmp(allCars[j].car->VIN, allCars[j + 1].car->VIN) > 0) {
-                ShowroomCar temp = allCars[j];
-                allCars[j] = allCars[j + 1];
-                allCars[j + 1] = temp;
+
+    printf("\nBy model:\n");
+    int shown = 0;
+    for (int i = 0; i < numModelRollups; i++) {
+        SalesBucket total = rollupWindow(&modelRollups[i].sales, now, days, 0);
+        if (total.cars > 0) {
+            printf("  %-16s%.2f lakhs (%d cars)\n", stringById(modelRollups[i].modelId),
+                   moneyToLakhs(total.amount), total.cars);
+            shown++;
+        }
+    }
+    if (shown == 0) {
+        printf("  No sales in this period.\n");
+    }
+}
+
+void writeRollup(FILE* fp, char scope, const char* key, const SalesRollup* rollup) {
+    char amount[32];
+    for (long d = rollup->newestDay - ROLLUP_DAYS + 1; d <= rollup->newestDay; d++) {
+        const SalesBucket* bucket = &rollup->days[((d % ROLLUP_DAYS) + ROLLUP_DAYS) % ROLLUP_DAYS];
+        if (bucket->cars != 0 || bucket->amount != 0) {
+            formatMoney(bucket->amount, LAKH_DIGITS, amount);
+            fprintf(fp, "%c,%s,D,%ld,%s,%d\n", scope, key, d, amount, bucket->cars);
+        }
+    }
+    for (int m = rollup->newestMonth - ROLLUP_MONTHS + 1; m <= rollup->newestMonth; m++) {
+        const SalesBucket* bucket = &rollup->months[((m % ROLLUP_MONTHS) + ROLLUP_MONTHS) % ROLLUP_MONTHS];
+        if (bucket->cars != 0 || bucket->amount != 0) {
+            formatMoney(bucket->amount, LAKH_DIGITS, amount);
+            fprintf(fp, "%c,%s,M,%d,%s,%d\n", scope, key, m, amount, bucket->cars);
+        }
+    }
+}
+
+void saveSalesRollupsToFile() {
+    TIME_SCOPE(TIMER_SAVE_ROLLUPS);
+    IoFile file;
+    FILE* fp = ioOpen(&file, "sales_rollups.txt", "w");
+    if (!fp) {
+        printf("Error opening sales_rollups.txt for writing.\n");
+        return;
+    }
+    char key[MAX_STRING];
+    BPlusTreeNode* current = showroomTree->root;
+    while (current && !current->isLeaf) current = current->children[0];
+    while (current) {
+        for (int i = 0; i < current->numKeys; i++) {
+            Showroom* showroom = (Showroom*)current->data[i];
+            sprintf(key, "%d", showroom->id);
+            writeRollup(fp, 'S', key, &showroom->sales);
+        }
+        current = current->next;
+    }
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        if (salesPersonTrees[i] == NULL) continue;
+        current = salesPersonTrees[i]->root;
+        while (current && !current->isLeaf) current = current->children[0];
+        while (current) {
+            for (int j = 0; j < current->numKeys; j++) {
+                SalesPerson* person = (SalesPerson*)current->data[j];
+                sprintf(key, "%d_%d", i + 1, person->id);
+                writeRollup(fp, 'P', key, &person->sales);
+            }
+            current = current->next;
+        }
+    }
+    for (int i = 0; i < numModelRollups; i++) {
+        writeRollup(fp, 'C', stringById(modelRollups[i].modelId), &modelRollups[i].sales);
+    }
+    ioClose(&file);
+}
+
+// Returns false if there is no rollup file, leaving the showroom buckets seeded from showrooms.txt
+bool loadSalesRollupsFromFile() {
+    TIME_SCOPE(TIMER_LOAD_ROLLUPS);
+    FILE* fp = fopen("sales_rollups.txt", "r");
+    if (!fp) return false;
+
+    BPlusTreeNode* current = showroomTree->root;
+    while (current && !current->isLeaf) current = current->children[0];
+    while (current) {
+        for (int i = 0; i < current->numKeys; i++) {
+            memset(&((Showroom*)current->data[i])->sales, 0, sizeof(SalesRollup));
+        }
+        current = current->next;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char scope, kind, key[MAX_STRING];
+        char amountText[32];
+        long bucket;
+        Money amount;
+        int cars;
+        if (sscanf(line, "%c,%99[^,],%c,%ld,%31[^,],%d", &scope, key, &kind, &bucket, amountText, &cars) != 6 ||
+            !parseMoney(amountText, LAKH_DIGITS, &amount)) {
+            continue;
+        }
+        SalesRollup* rollup = NULL;
+        if (scope == 'S') {
+            Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, key);
+            if (showroom != NULL) rollup = &showroom->sales;
+        } else if (scope == 'P') {
+            int showroomId;
+            char personIdStr[20];
+            if (sscanf(key, "%d_%19s", &showroomId, personIdStr) == 2 &&
+                showroomId >= 1 && showroomId <= MAX_SHOWROOMS && salesPersonTrees[showroomId - 1] != NULL) {
+                SalesPerson* person = (SalesPerson*)searchInBPlusTree(salesPersonTrees[showroomId - 1], personIdStr);
+                if (person != NULL) rollup = &person->sales;
             }
+        } else if (scope == 'C') {
+            rollup = getModelRollup(internString(key));
+        }
+        if (rollup == NULL) continue;
+        if (kind == 'D') {
+            rollupAddDay(rollup, bucket, amount, cars);
+        } else if (kind == 'M') {
+            rollupAddMonth(rollup, (int)bucket, amount, cars);
         }
     }
-    
-    printf("\n=== Merged and Sorted Cars from All Showrooms (%s) ===\n", outputName);
-    printf("VIN\t\tName\t\tColor\tPrice\tFuel Type\tCar Type\tStatus\tShowroom ID\n");
+    fclose(fp);
+    return true;
+}
+
+// M. Sales log with date-range queries
+void saleTimeKey(time_t timestamp, long sequence, char* key) {
+    sprintf(key, "%011llu%08lu", (unsigned long long)timestamp % 100000000000ULL,
+            (unsigned long)sequence % 100000000UL);
+}
+
+// Appends a copy of the record to salesLog without indexing it
+SaleRecord* storeSaleRecord(const SaleRecord* record) {
+    SaleRecord* newRecord = (SaleRecord*)malloc(sizeof(SaleRecord));
+    if (newRecord == NULL) {
+        fprintf(stderr, "Memory allocation failed for SaleRecord\n");
+        return NULL;
+    }
+    *newRecord = *record;
+    if (numSaleRecords == saleRecordCapacity) {
+        int newCapacity = saleRecordCapacity == 0 ? 64 : saleRecordCapacity * 2;
+        SaleRecord** temp = (SaleRecord**)realloc(salesLog, newCapacity * sizeof(SaleRecord*));
+        if (temp == NULL) {
+            fprintf(stderr, "Memory reallocation failed\n");
+            free(newRecord);
+            return NULL;
+        }
+        salesLog = temp;
+        saleRecordCapacity = newCapacity;
+    }
+    salesLog[numSaleRecords++] = newRecord;
+    return newRecord;
+}
+
+SaleRecord* indexSaleRecord(const SaleRecord* record) {
+    SaleRecord* newRecord = storeSaleRecord(record);
+    if (newRecord == NULL) return NULL;
+    char key[20];
+    saleTimeKey(newRecord->timestamp, newRecord->sequence, key);
+    insertIntoBPlusTree(salesTimeTree, key, newRecord);
+    return newRecord;
+}
+
+void writeSaleRecord(FILE* fp, const SaleRecord* record) {
+    char price[32];
+    formatMoney(record->price, LAKH_DIGITS, price);
+    fprintf(fp, "%ld,%lld,%s,%d,%d,%s,%d\n",
+            record->sequence, (long long)record->timestamp, record->VIN,
+            record->showroomId, record->salesPersonId, price, record->paymentType);
+}
+
+// Adds a sale to the in-memory log and appends it to sales_log.txt (at the next commit
+// in batch mode)
+SaleRecord* appendSaleRecord(time_t timestamp, const char* VIN, int showroomId, int salesPersonId,
+                             Money price, PaymentType paymentType) {
+    SaleRecord record;
+    record.sequence = numSaleRecords;
+    record.timestamp = timestamp;
+    strncpy(record.VIN, VIN, sizeof(record.VIN) - 1);
+    record.VIN[sizeof(record.VIN) - 1] = '\0';
+    record.showroomId = showroomId;
+    record.salesPersonId = salesPersonId;
+    record.price = price;
+    record.paymentType = paymentType;
+
+    SaleRecord* newRecord = indexSaleRecord(&record);
+    if (newRecord == NULL || batchMode) {
+        return newRecord;
+    }
+    IoFile file;
+    FILE* fp = ioOpen(&file, "sales_log.txt", "a");
+    if (!fp) {
+        printf("Error opening sales_log.txt for writing.\n");
+        return newRecord;
+    }
+    writeSaleRecord(fp, newRecord);
+    ioClose(&file);
+    return newRecord;
+}
+
+// Sales made before the log existed are rebuilt from customers that carry a sale time
+void backfillSalesLogFromCustomers() {
+    IoFile file;
+    FILE* fp = ioOpen(&file, "sales_log.txt", "w");
+    if (!fp) {
+        printf("Error opening sales_log.txt for writing.\n");
+        return;
+    }
+    for (int i = 0; i < numSalesPersonTrees; i++) {
+        int showroomId = 0, salesPersonId = 0;
+        sscanf(salesPersonCustomerTrees[i].salesPersonId, "%d_%d", &showroomId, &salesPersonId);
+        BPlusTreeNode* current = salesPersonCustomerTrees[i].customerTree->root;
+        while (current && !current->isLeaf) current = current->children[0];
+        while (current) {
+            for (int j = 0; j < current->numKeys; j++) {
+                Customer* customer = (Customer*)current->data[j];
+                int row = findCarRow(customer->VIN);
+                if (customer->saleTime == 0 || row < 0) continue;
+                SaleRecord record = {numSaleRecords, customer->saleTime, "", showroomId, salesPersonId,
+                                     carColumns.price[row], customer->paymentType};
+                strcpy(record.VIN, customer->VIN);
+                SaleRecord* newRecord = indexSaleRecord(&record);
+                if (newRecord != NULL) writeSaleRecord(fp, newRecord);
+            }
+            current = current->next;
+        }
+    }
+    ioClose(&file);
+}
+
+// The records are stored first and salesTimeTree is then bulk-built from them
+bool loadSalesLogFromFile() {
+    TIME_SCOPE(TIMER_LOAD_SALES_LOG);
+    FILE* fp = fopen("sales_log.txt", "r");
+    if (!fp) return false;
+    int firstRecord = numSaleRecords;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        SaleRecord record;
+        long long timestamp;
+        int paymentType;
+        char price[32];
+        if (sscanf(line, "%ld,%lld,%19[^,],%d,%d,%31[^,],%d", &record.sequence, &timestamp, record.VIN,
+                   &record.showroomId, &record.salesPersonId, price, &paymentType) != 7 ||
+            !parseMoney(price, LAKH_DIGITS, &record.price)) {
+            continue;
+        }
+        record.timestamp = (time_t)timestamp;
+        record.paymentType = (PaymentType)paymentType;
+        storeSaleRecord(&record);
+    }
+    fclose(fp);
+
+    int count = numSaleRecords - firstRecord;
+    BatchEntry* entries = (BatchEntry*)malloc((count > 0 ? count : 1) * sizeof(BatchEntry));
+    char (*keys)[20] = (char (*)[20])malloc((count > 0 ? count : 1) * sizeof(*keys));
+    if (entries == NULL || keys == NULL) {
+        fprintf(stderr, "Memory allocation failed for loading the sales log\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        SaleRecord* record = salesLog[firstRecord + i];
+        saleTimeKey(record->timestamp, record->sequence, keys[i]);
+        entries[i].key = keys[i];
+        entries[i].data = record;
+        entries[i].available = false;
+    }
+    batchInsertIntoBPlusTree(salesTimeTree, entries, count);
+    free(entries);
+    free(keys);
+    return true;
+}
+
+// Walks only the leaves of salesTimeTree that fall inside [from, to]
+void displaySalesBetweenDates(time_t from, time_t to) {
+    char fromStr[11], toStr[11];
+    formatDate(from, fromStr, sizeof(fromStr));
+    formatDate(to, toStr, sizeof(toStr));
+    printf("\n=== Sales from %s to %s ===\n", fromStr, toStr);
+
+    Money showroomAmount[MAX_SHOWROOMS + 1] = {0};
+    int showroomCars[MAX_SHOWROOMS + 1] = {0};
+    char lowKey[20], highKey[20];
+    saleTimeKey(from, 0, lowKey);
+    saleTimeKey(to, 99999999L, highKey);
+
+    printf("Date\t\tVIN\t\tShowroom\tSales Person\tPrice\tPayment\n");
     printf("----------------------------------------------------------------------------------------\n");
-    
-    for (int i = 0; i < totalCars; i++) {
-        Car* car = allCars[i].car;
-        printf("%-16s%-16s%-8s%-8.2f%-12s%-12s%-8s%d\n",
-               car->VIN, car->name, car->color, car->price,
-               fuelTypeToString(car->fuelType), carTypeToString(car->carType),
-               car->isSold ? "Sold" : "Available", allCars[i].showroomId);
+    BPlusTreeNode* leaf = findLeafForKey(salesTimeTree, lowKey);
+    bool done = false;
+    while (leaf != NULL && !done) {
+        for (int i = 0; i < leaf->numKeys; i++) {
+            if (strcmp(leaf->keys[i], lowKey) < 0) continue;
+            if (strcmp(leaf->keys[i], highKey) > 0) {
+                done = true;
+                break;
+            }
+            SaleRecord* record = (SaleRecord*)leaf->data[i];
+            char date[11];
+            formatDate(record->timestamp, date, sizeof(date));
+            printf("%-16s%-16s%-16d%-16d%-8.2f%s\n", date, record->VIN, record->showroomId,
+                   record->salesPersonId, moneyToLakhs(record->price), paymentTypeToString(record->paymentType));
+            int slot = (record->showroomId >= 1 && record->showroomId <= MAX_SHOWROOMS) ? record->showroomId : 0;
+            showroomAmount[slot] += record->price;
+            showroomCars[slot]++;
+        }
+        leaf = leaf->next;
     }
-    
-    FILE* fp = fopen(outputName, "w");
-    if (fp == NULL) {
-        printf("Error opening file %s for writing\n", outputName);
-    } else {
-        fprintf(fp, "VIN,Name,Color,Price,Fuel Type,Car Type,Status,Showroom ID\n");
-        for (int i = 0; i < totalCars; i++) {
-            Car* car = allCars[i].car;
-            fprintf(fp, "%s,%s,%s,%.2f,%s,%s,%s,%d\n",
-                    car->VIN, car->name, car->color, car->price,
-                    fuelTypeToString(car->fuelType), carTypeToString(car->carType),
-                    car->isSold ? "Sold" : "Available", allCars[i].showroomId);
+
+    printf("\nBy showroom:\n");
+    int total = 0;
+    for (int i = 1; i <= MAX_SHOWROOMS; i++) {
+        printf("  Showroom %d: %.2f lakhs (%d cars)\n", i, moneyToLakhs(showroomAmount[i]), showroomCars[i]);
+        total += showroomCars[i];
+    }
+    if (showroomCars[0] > 0) {
+        printf("  Unknown showroom: %.2f lakhs (%d cars)\n", moneyToLakhs(showroomAmount[0]), showroomCars[0]);
+        total += showroomCars[0];
+    }
+    printf("Total sales in period: %d\n", total);
+}
+
+bool parseDate(const char* text, time_t* result) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if (sscanf(text, "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday) != 3) {
+        return false;
+    }
+    if (tm.tm_mon < 1 || tm.tm_mon > 12 || tm.tm_mday < 1 || tm.tm_mday > 31) {
+        return false;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    *result = timegm(&tm);
+    return true;
+}
+
+// N. Network-wide sales forecasting
+void freeForecastBatch(ForecastBatch* batch) {
+    if (batch == NULL) return;
+    free(batch->showrooms);
+    free(batch->history);
+    free(batch->cars);
+    free(batch->weightedMean);
+    free(batch->smoothed);
+    free(batch->trend);
+    free(batch);
+}
+
+// Copies each showroom's trailing 30-day windows into the batch in one pass over its daily buckets
+ForecastBatch* buildForecastBatch(Showroom** showrooms, int numShowrooms, time_t now) {
+    ForecastBatch* batch = (ForecastBatch*)calloc(1, sizeof(ForecastBatch));
+    if (batch == NULL) {
+        fprintf(stderr, "Memory allocation failed for ForecastBatch\n");
+        return NULL;
+    }
+    int n = numShowrooms > 0 ? numShowrooms : 1;
+    batch->numShowrooms = numShowrooms;
+    batch->showrooms = (Showroom**)malloc(n * sizeof(Showroom*));
+    batch->history = (double*)calloc((size_t)FORECAST_MONTHS * n, sizeof(double));
+    batch->cars = (int*)calloc((size_t)FORECAST_MONTHS * n, sizeof(int));
+    batch->weightedMean = (double*)malloc(n * sizeof(double));
+    batch->smoothed = (double*)malloc(n * sizeof(double));
+    batch->trend = (double*)malloc(n * sizeof(double));
+    if (!batch->showrooms || !batch->history || !batch->cars || !batch->weightedMean ||
+        !batch->smoothed || !batch->trend) {
+        fprintf(stderr, "Memory allocation failed for ForecastBatch\n");
+        freeForecastBatch(batch);
+        return NULL;
+    }
+
+    long today = dayNumber(now);
+    for (int s = 0; s < numShowrooms; s++) {
+        const SalesRollup* rollup = &showrooms[s]->sales;
+        batch->showrooms[s] = showrooms[s];
+        long oldest = today - (long)FORECAST_MONTHS * 30 + 1;
+        if (oldest <= rollup->newestDay - ROLLUP_DAYS) oldest = rollup->newestDay - ROLLUP_DAYS + 1;
+        long newest = today < rollup->newestDay ? today : rollup->newestDay;
+        for (long d = oldest; d <= newest; d++) {
+            int m = FORECAST_MONTHS - 1 - (int)((today - d) / 30);
+            batch->history[(size_t)m * numShowrooms + s] += moneyToLakhs(rollup->days[d % ROLLUP_DAYS].amount);
+            batch->cars[(size_t)m * numShowrooms + s] += rollup->days[d % ROLLUP_DAYS].cars;
         }
-        fclose(fp);
-        printf("\nMerged data saved to %s\n", outputName);
     }
-    
-    free(allCars);
+    return batch;
+}
+
+// Each model is a sequence of loops over the showroom axis of contiguous rows
+void runForecastModels(ForecastBatch* batch) {
+    const int n = batch->numShowrooms;
+    const double* restrict history = batch->history;
+    double* restrict weighted = batch->weightedMean;
+    double* restrict smoothed = batch->smoothed;
+    double* restrict trend = batch->trend;
+    const double* last = history + (size_t)(FORECAST_MONTHS - 1) * n;
+    const double* twoAgo = history + (size_t)(FORECAST_MONTHS - 2) * n;
+    const double* threeAgo = history + (size_t)(FORECAST_MONTHS - 3) * n;
+
+    for (int s = 0; s < n; s++) {
+        weighted[s] = 0.5 * last[s] + 0.3 * twoAgo[s] + 0.2 * threeAgo[s];
+    }
+
+    for (int s = 0; s < n; s++) {
+        smoothed[s] = history[s];
+    }
+    for (int m = 1; m < FORECAST_MONTHS; m++) {
+        const double* row = history + (size_t)m * n;
+        for (int s = 0; s < n; s++) {
+            smoothed[s] = FORECAST_ALPHA * row[s] + (1.0 - FORECAST_ALPHA) * smoothed[s];
+        }
+    }
+
+    // Slope = sum((x - xMean) * y) / sum((x - xMean)^2) with x = 0..FORECAST_MONTHS-1
+    const double xMean = (FORECAST_MONTHS - 1) / 2.0;
+    double sxx = 0.0;
+    for (int m = 0; m < FORECAST_MONTHS; m++) {
+        sxx += (m - xMean) * (m - xMean);
+    }
+    for (int s = 0; s < n; s++) {
+        trend[s] = 0.0;
+    }
+    for (int m = 0; m < FORECAST_MONTHS; m++) {
+        const double* row = history + (size_t)m * n;
+        const double weight = (m - xMean) / sxx;
+        for (int s = 0; s < n; s++) {
+            trend[s] += weight * row[s];
+        }
+    }
+    double* restrict mean = (double*)calloc(n > 0 ? n : 1, sizeof(double));
+    if (mean == NULL) {
+        fprintf(stderr, "Memory allocation failed for forecast\n");
+        return;
+    }
+    for (int m = 0; m < FORECAST_MONTHS; m++) {
+        const double* row = history + (size_t)m * n;
+        for (int s = 0; s < n; s++) {
+            mean[s] += row[s];
+        }
+    }
+    const double ahead = FORECAST_MONTHS - xMean;
+    for (int s = 0; s < n; s++) {
+        double value = mean[s] / FORECAST_MONTHS + trend[s] * ahead;
+        trend[s] = value > 0.0 ? value : 0.0;
+    }
+    free(mean);
+}
+
+void displayNetworkForecast() {
+    int count = 0, capacity = 0;
+    Showroom** showrooms = NULL;
+    BPlusTreeNode* current = showroomTree->root;
+    while (current && !current->isLeaf) current = current->children[0];
+    while (current != NULL) {
+        for (int i = 0; i < current->numKeys; i++) {
+            if (count == capacity) {
+                capacity = capacity == 0 ? 16 : capacity * 2;
+                Showroom** temp = (Showroom**)realloc(showrooms, capacity * sizeof(Showroom*));
+                if (temp == NULL) {
+                    printf("Memory allocation failed\n");
+                    free(showrooms);
+                    return;
+                }
+                showrooms = temp;
+            }
+            showrooms[count++] = (Showroom*)current->data[i];
+        }
+        current = current->next;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ForecastBatch* batch = buildForecastBatch(showrooms, count, time(NULL));
+    if (batch == NULL) {
+        free(showrooms);
+        return;
+    }
+    runForecastModels(batch);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsedMs = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    printf("\n=== Next Month Forecast (lakhs) ===\n");
+    printf("ID\tShowroom\t\t\tLast 30 days\tWeighted\tSmoothed\tTrend\n");
+    printf("----------------------------------------------------------------------------------------\n");
+    double totals[3] = {0.0, 0.0, 0.0};
+    for (int s = 0; s < count; s++) {
+        printf("%-8d%-32s%-16.2f%-16.2f%-16.2f%.2f\n", showrooms[s]->id, showrooms[s]->name,
+               batch->history[(size_t)(FORECAST_MONTHS - 1) * count + s],
+               batch->weightedMean[s], batch->smoothed[s], batch->trend[s]);
+        totals[0] += batch->weightedMean[s];
+        totals[1] += batch->smoothed[s];
+        totals[2] += batch->trend[s];
+    }
+    printf("Network total: weighted %.2f, smoothed %.2f, trend %.2f lakhs\n", totals[0], totals[1], totals[2]);
+    printf("Forecast %d showrooms in %.3f ms\n", count, elapsedMs);
+    freeForecastBatch(batch);
+    free(showrooms);
+}
+
+// O. Loan quotes and amortization
+LoanRateTable* getLoanRateTable(int rateBasisPoints) {
+    for (int i = 0; i < numLoanRateTables; i++) {
+        if (loanRateTables[i]->rateBasisPoints == rateBasisPoints) {
+            return loanRateTables[i];
+        }
+    }
+    if (numLoanRateTables == loanRateTableCapacity) {
+        int capacity = loanRateTableCapacity == 0 ? 8 : loanRateTableCapacity * 2;
+        LoanRateTable** temp = (LoanRateTable**)realloc(loanRateTables, capacity * sizeof(LoanRateTable*));
+        if (temp == NULL) {
+            fprintf(stderr, "Memory allocation failed for loan rate tables\n");
+            return NULL;
+        }
+        loanRateTables = temp;
+        loanRateTableCapacity = capacity;
+    }
+    LoanRateTable* table = (LoanRateTable*)malloc(sizeof(LoanRateTable));
+    if (table == NULL) {
+        fprintf(stderr, "Memory allocation failed for loan rate table\n");
+        return NULL;
+    }
+    table->rateBasisPoints = rateBasisPoints;
+    double r = rateBasisPoints / 120000.0;  // Monthly rate
+    table->growth[0] = 1.0;
+    table->annuity[0] = 0.0;
+    for (int n = 1; n <= LOAN_MAX_MONTHS; n++) {
+        table->growth[n] = table->growth[n - 1] * (1.0 + r);
+        table->annuity[n] = rateBasisPoints == 0 ? 1.0 / n : r * table->growth[n] / (table->growth[n] - 1.0);
+    }
+    loanRateTables[numLoanRateTables++] = table;
+    return table;
+}
+
+void freeLoanRateTables() {
+    for (int i = 0; i < numLoanRateTables; i++) {
+        free(loanRateTables[i]);
+    }
+    free(loanRateTables);
+    loanRateTables = NULL;
+    numLoanRateTables = loanRateTableCapacity = 0;
+}
+
+LoanProduct* findLoanProduct(int months) {
+    for (int i = 0; i < NUM_LOAN_PRODUCTS; i++) {
+        if (loanProducts[i].months == months) {
+            return &loanProducts[i];
+        }
+    }
+    return NULL;
+}
+
+// Monthly instalment in paise, or -1 if the tenure is out of range
+Money quoteEMI(Money principal, int months, int rateBasisPoints) {
+    if (months < 1 || months > LOAN_MAX_MONTHS) return -1;
+    LoanRateTable* table = getLoanRateTable(rateBasisPoints);
+    if (table == NULL) return -1;
+    return llround((double)principal * table->annuity[months]);
+}
+
+void freeLoanQuoteBatch(LoanQuoteBatch* batch) {
+    free(batch->principal);
+    free(batch->months);
+    free(batch->rateBasisPoints);
+    free(batch->factor);
+    free(batch->emi);
+    free(batch->totalInterest);
+    memset(batch, 0, sizeof(LoanQuoteBatch));
+}
+
+bool loanQuoteBatchAdd(LoanQuoteBatch* batch, Money principal, int months, int rateBasisPoints) {
+    if (months < 1 || months > LOAN_MAX_MONTHS) return false;
+    if (batch->count == batch->capacity) {
+        int capacity = batch->capacity == 0 ? 64 : batch->capacity * 2;
+        Money* newPrincipal = (Money*)realloc(batch->principal, capacity * sizeof(Money));
+        if (newPrincipal != NULL) batch->principal = newPrincipal;
+        int* newMonths = (int*)realloc(batch->months, capacity * sizeof(int));
+        if (newMonths != NULL) batch->months = newMonths;
+        int* newRates = (int*)realloc(batch->rateBasisPoints, capacity * sizeof(int));
+        if (newRates != NULL) batch->rateBasisPoints = newRates;
+        double* newFactor = (double*)realloc(batch->factor, capacity * sizeof(double));
+        if (newFactor != NULL) batch->factor = newFactor;
+        Money* newEmi = (Money*)realloc(batch->emi, capacity * sizeof(Money));
+        if (newEmi != NULL) batch->emi = newEmi;
+        Money* newInterest = (Money*)realloc(batch->totalInterest, capacity * sizeof(Money));
+        if (newInterest != NULL) batch->totalInterest = newInterest;
+        if (!newPrincipal || !newMonths || !newRates || !newFactor || !newEmi || !newInterest) {
+            fprintf(stderr, "Memory allocation failed for loan quotes\n");
+            return false;
+        }
+        batch->capacity = capacity;
+    }
+    batch->principal[batch->count] = principal;
+    batch->months[batch->count] = months;
+    batch->rateBasisPoints[batch->count] = rateBasisPoints;
+    batch->count++;
+    return true;
+}
+
+// Gathers every quote's annuity factor, then prices the whole batch in flat loops
+bool quoteLoanBatch(LoanQuoteBatch* batch) {
+    const int n = batch->count;
+    LoanRateTable* table = NULL;
+    for (int i = 0; i < n; i++) {
+        if (table == NULL || table->rateBasisPoints != batch->rateBasisPoints[i]) {
+            table = getLoanRateTable(batch->rateBasisPoints[i]);
+            if (table == NULL) return false;
+        }
+        batch->factor[i] = table->annuity[batch->months[i]];
+    }
+
+    const Money* restrict principal = batch->principal;
+    const int* restrict months = batch->months;
+    const double* restrict factor = batch->factor;
+    Money* restrict emi = batch->emi;
+    Money* restrict interest = batch->totalInterest;
+    for (int i = 0; i < n; i++) {
+        emi[i] = (Money)((double)principal[i] * factor[i] + 0.5);
+    }
+    for (int i = 0; i < n; i++) {
+        interest[i] = emi[i] * months[i] - principal[i];
+    }
+    return true;
+}
+
+// Fills rows[0..months-1]; the last payment absorbs the rounding left in the balance
+int buildAmortizationSchedule(Money principal, int months, int rateBasisPoints, AmortizationRow* rows) {
+    Money emi = quoteEMI(principal, months, rateBasisPoints);
+    if (emi < 0) return 0;
+    double r = rateBasisPoints / 120000.0;
+    Money balance = principal;
+    for (int m = 0; m < months; m++) {
+        Money interest = llround((double)balance * r);
+        Money repaid = m == months - 1 ? balance : emi - interest;
+        if (repaid > balance) repaid = balance;
+        balance -= repaid;
+        rows[m].month = m + 1;
+        rows[m].payment = repaid + interest;
+        rows[m].interest = interest;
+        rows[m].principal = repaid;
+        rows[m].balance = balance;
+    }
+    return months;
+}
+
+void displayLoanQuotes(Money principal) {
+    LoanQuoteBatch batch = {0};
+    for (int i = 0; i < NUM_LOAN_PRODUCTS; i++) {
+        loanQuoteBatchAdd(&batch, principal, loanProducts[i].months, loanProducts[i].rateBasisPoints);
+    }
+    if (!quoteLoanBatch(&batch)) {
+        freeLoanQuoteBatch(&batch);
+        return;
+    }
+    printf("\n=== Loan Quotes for %.2f lakhs ===\n", moneyToLakhs(principal));
+    printf("Months\tRate\tEMI (rupees)\tTotal Interest (lakhs)\n");
+    printf("------------------------------------------------------\n");
+    for (int i = 0; i < batch.count; i++) {
+        printf("%d\t%.2f%%\t%-16.2f%.2f\n", batch.months[i], batch.rateBasisPoints[i] / 100.0,
+               moneyToRupees(batch.emi[i]), moneyToLakhs(batch.totalInterest[i]));
+    }
+    freeLoanQuoteBatch(&batch);
+}
+
+void displayAmortizationSchedule(Money principal, int months) {
+    const LoanProduct* product = findLoanProduct(months);
+    if (product == NULL) {
+        printf("Invalid EMI duration. Please choose 36, 60, or 84 months.\n");
+        return;
+    }
+    AmortizationRow* rows = (AmortizationRow*)malloc(months * sizeof(AmortizationRow));
+    if (rows == NULL) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    buildAmortizationSchedule(principal, months, product->rateBasisPoints, rows);
+    printf("\n=== Repayment Schedule: %.2f lakhs over %d months at %.2f%% ===\n",
+           moneyToLakhs(principal), months, product->rateBasisPoints / 100.0);
+    printf("Month\tPayment\t\tInterest\tPrincipal\tBalance (rupees)\n");
+    printf("----------------------------------------------------------------------\n");
+    Money totalInterest = 0;
+    for (int m = 0; m < months; m++) {
+        printf("%d\t%-16.2f%-16.2f%-16.2f%.2f\n", rows[m].month, moneyToRupees(rows[m].payment),
+               moneyToRupees(rows[m].interest), moneyToRupees(rows[m].principal), moneyToRupees(rows[m].balance));
+        totalInterest += rows[m].interest;
+    }
+    printf("Total interest: %.2f rupees\n", moneyToRupees(totalInterest));
+    free(rows);
+}
+
+// Sets a product's rate and re-prices every existing loan at the current product rates.
+// Signed contracts keep their EMI; the report shows what each would cost today.
+void requoteLoans(int months, int rateBasisPoints) {
+    LoanProduct* product = findLoanProduct(months);
+    if (product == NULL) {
+        printf("Invalid EMI duration. Please choose 36, 60, or 84 months.\n");
+        return;
+    }
+    product->rateBasisPoints = rateBasisPoints;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    LoanQuoteBatch batch = {0};
+    PointerList loans = {0};
+    Money totalBefore = 0;
+    for (BPlusTreeNode* leaf = leftmostLeaf(customerVinTree->root); leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->numKeys; i++) {
+            Customer* customer = (Customer*)leaf->data[i];
+            const LoanProduct* current = findLoanProduct(customer->emiMonths);
+            if (customer->paymentType != LOAN || current == NULL) continue;
+            if (!pointerListAppend(&loans, customer) ||
+                !loanQuoteBatchAdd(&batch, customer->loanAmount, customer->emiMonths, current->rateBasisPoints)) {
+                free(loans.items);
+                freeLoanQuoteBatch(&batch);
+                return;
+            }
+            totalBefore += customer->emiAmount;
+        }
+    }
+    if (!quoteLoanBatch(&batch)) {
+        free(loans.items);
+        freeLoanQuoteBatch(&batch);
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsedMs = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    Money totalAfter = 0;
+    int changed = 0;
+    for (int i = 0; i < loans.count; i++) {
+        const Customer* customer = (const Customer*)loans.items[i];
+        if (batch.emi[i] != customer->emiAmount) {
+            printf("%-20s%-24s%d months: EMI %.2f -> %.2f rupees\n", customer->VIN, customerName(customer),
+                   customer->emiMonths, moneyToRupees(customer->emiAmount), moneyToRupees(batch.emi[i]));
+            changed++;
+        }
+        totalAfter += batch.emi[i];
+        if (customer->emiMonths == months) {
+            cdcLoanRequoteEvent(customer, rateBasisPoints, batch.emi[i]);
+        }
+    }
+    printf("%d-month loans now at %.2f%%.\n", months, rateBasisPoints / 100.0);
+    printf("Re-quoted %d loans (%d changed) in %.3f ms. Monthly EMI book: %.2f -> %.2f rupees\n",
+           batch.count, changed, elapsedMs, moneyToRupees(totalBefore), moneyToRupees(totalAfter));
+    free(loans.items);
+    freeLoanQuoteBatch(&batch);
+}
+
+// P. Batched tree updates
+void swapBatchEntries(BatchEntry* a, BatchEntry* b) {
+    BatchEntry temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+// Multikey quicksort from key byte `depth` on: partitions on one character at a time
+// instead of strcmp'ing whole keys
+void sortBatchEntriesFrom(BatchEntry* entries, int n, int depth) {
+    while (n > 1) {
+        if (n < 8) {
+            for (int i = 1; i < n; i++) {
+                for (int j = i; j > 0 && strcmp(entries[j - 1].key + depth, entries[j].key + depth) > 0; j--) {
+                    swapBatchEntries(&entries[j - 1], &entries[j]);
+                }
+            }
+            return;
+        }
+        swapBatchEntries(&entries[0], &entries[n / 2]);
+        unsigned char pivot = (unsigned char)entries[0].key[depth];
+        int lt = 0, gt = n - 1, i = 1;
+        while (i <= gt) {
+            unsigned char c = (unsigned char)entries[i].key[depth];
+            if (c < pivot) {
+                swapBatchEntries(&entries[lt++], &entries[i++]);
+            } else if (c > pivot) {
+                swapBatchEntries(&entries[i], &entries[gt--]);
+            } else {
+                i++;
+            }
+        }
+        sortBatchEntriesFrom(entries, lt, depth);
+        sortBatchEntriesFrom(entries + gt + 1, n - gt - 1, depth);
+        if (pivot == '\0') return;
+        entries += lt;
+        n = gt - lt + 1;
+        depth++;
+    }
+}
+
+// Sorts by key. The first 8 bytes are packed big-endian into an integer and radix
+// sorted a byte per pass; runs sharing that prefix are finished from byte 8.
+void sortBatchEntries(BatchEntry* entries, int n) {
+    if (n < 64) {
+        sortBatchEntriesFrom(entries, n, 0);
+        return;
+    }
+    uint64_t* prefix = (uint64_t*)malloc(2 * (size_t)n * sizeof(uint64_t));
+    int* order = (int*)malloc(2 * (size_t)n * sizeof(int));
+    BatchEntry* sorted = (BatchEntry*)malloc(n * sizeof(BatchEntry));
+    if (prefix == NULL || order == NULL || sorted == NULL) {
+        fprintf(stderr, "Memory allocation failed for batch sort\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) {
+        const unsigned char* key = (const unsigned char*)entries[i].key;
+        uint64_t packed = 0;
+        int length = 0;
+        for (; length < 8 && key[length]; length++) {
+            packed = (packed << 8) | key[length];
+        }
+        prefix[i] = packed << (8 * (8 - length));
+        order[i] = i;
+    }
+
+    uint64_t* fromPrefix = prefix;
+    uint64_t* toPrefix = prefix + n;
+    int* fromOrder = order;
+    int* toOrder = order + n;
+    for (int shift = 0; shift < 64; shift += 8) {
+        int counts[257] = {0};
+        for (int i = 0; i < n; i++) {
+            counts[((fromPrefix[i] >> shift) & 0xFF) + 1]++;
+        }
+        if (counts[((fromPrefix[0] >> shift) & 0xFF) + 1] == n) {
+            continue;  // Every key has the same byte here
+        }
+        for (int b = 0; b < 256; b++) {
+            counts[b + 1] += counts[b];
+        }
+        for (int i = 0; i < n; i++) {
+            int slot = counts[(fromPrefix[i] >> shift) & 0xFF]++;
+            toPrefix[slot] = fromPrefix[i];
+            toOrder[slot] = fromOrder[i];
+        }
+        uint64_t* swapPrefix = fromPrefix;
+        fromPrefix = toPrefix;
+        toPrefix = swapPrefix;
+        int* swapOrder = fromOrder;
+        fromOrder = toOrder;
+        toOrder = swapOrder;
+    }
+
+    for (int i = 0; i < n; i++) {
+        sorted[i] = entries[fromOrder[i]];
+    }
+    for (int i = 0; i < n;) {
+        int end = i + 1;
+        while (end < n && fromPrefix[end] == fromPrefix[i]) end++;
+        // Keys shorter than 8 bytes end inside the prefix, so equal prefixes mean equal keys
+        if (end - i > 1 && (fromPrefix[i] & 0xFF) != 0) {
+            sortBatchEntriesFrom(sorted + i, end - i, 8);
+        }
+        i = end;
+    }
+    memcpy(entries, sorted, n * sizeof(BatchEntry));
+    free(prefix);
+    free(order);
+    free(sorted);
+}
+
+// Drops the dead slots of a lazily deleted leaf; returns how many were dropped.
+// Dead slots never carry an availability bit, so subtree counts are unchanged.
+int purgeTombstones(BPlusTreeNode* leaf) {
+    if (leaf->tombstoneMask == 0) return 0;
+    int kept = 0;
+    uint8_t mask = 0;
+    for (int i = 0; i < leaf->numKeys; i++) {
+        if ((leaf->tombstoneMask >> i) & 1u) continue;
+        if (kept != i) {
+            strcpy(leaf->keys[kept], leaf->keys[i]);
+            leaf->data[kept] = leaf->data[i];
+        }
+        if ((leaf->availableMask >> i) & 1u) mask |= (uint8_t)(1u << kept);
+        kept++;
+    }
+    int purged = leaf->numKeys - kept;
+    leaf->numKeys = kept;
+    leaf->availableMask = mask;
+    leaf->tombstoneMask = 0;
+    return purged;
+}
+
+// Descends to key's leaf, recording the inner nodes passed and the tightest separator
+// above the leaf (NULL on the rightmost path). Every key <= *upper belongs to this leaf.
+BPlusTreeNode* findLeafWithBound(BPlusTree* tree, const char* key, const char** upper,
+                                 BPlusTreeNode** path, int* depth) {
+    BPlusTreeNode* current = tree->root;
+    *upper = NULL;
+    *depth = 0;
+    while (!current->isLeaf) {
+        int i = 0;
+        while (i < current->numKeys && strcmp(key, current->keys[i]) > 0) {
+            i++;
+        }
+        if (i < current->numKeys) {
+            *upper = current->keys[i];
+        }
+        path[(*depth)++] = current;
+        current = current->children[i];
+    }
+    return current;
+}
+
+void freeInnerNodes(BPlusTreeNode* node) {
+    if (node == NULL || node->isLeaf) return;
+    for (int i = 0; i <= node->numKeys; i++) {
+        freeInnerNodes(node->children[i]);
+    }
+    free(node);
+}
+
+// Rebuilds the inner levels bottom-up over the leaf chain starting at firstLeaf,
+// spreading children evenly so every inner node has at least two
+void buildInnerLevels(BPlusTree* tree, BPlusTreeNode* firstLeaf) {
+    // Empty leaves have no key to separate them by, so they are dropped from the chain
+    while (firstLeaf != NULL && firstLeaf->numKeys == 0) {
+        BPlusTreeNode* next = firstLeaf->next;
+        free(firstLeaf);
+        firstLeaf = next;
+    }
+    int count = 0;
+    for (BPlusTreeNode* leaf = firstLeaf; leaf != NULL; leaf = leaf->next) {
+        while (leaf->next != NULL && leaf->next->numKeys == 0) {
+            BPlusTreeNode* empty = leaf->next;
+            leaf->next = empty->next;
+            free(empty);
+        }
+        count++;
+    }
+    if (count == 0) {
+        tree->root = NULL;
+        return;
+    }
+    BPlusTreeNode** nodes = (BPlusTreeNode**)malloc(count * sizeof(BPlusTreeNode*));
+    const char** maxKeys = (const char**)malloc(count * sizeof(const char*));
+    if (nodes == NULL || maxKeys == NULL) {
+        fprintf(stderr, "Memory allocation failed for tree rebuild\n");
+        exit(EXIT_FAILURE);
+    }
+    count = 0;
+    for (BPlusTreeNode* leaf = firstLeaf; leaf != NULL; leaf = leaf->next) {
+        recountAvailable(leaf);
+        nodes[count] = leaf;
+        maxKeys[count++] = leaf->keys[leaf->numKeys - 1];
+    }
+    while (count > 1) {
+        int parents = (count + B_PLUS_ORDER - 1) / B_PLUS_ORDER;
+        int base = count / parents, extra = count % parents, next = 0;
+        for (int p = 0; p < parents; p++) {
+            int children = base + (p < extra ? 1 : 0);
+            BPlusTreeNode* parent = createBPlusTreeNode(false);
+            for (int c = 0; c < children; c++) {
+                parent->children[c] = nodes[next + c];
+                if (c < children - 1) {
+                    strcpy(parent->keys[c], maxKeys[next + c]);
+                }
+            }
+            parent->numKeys = children - 1;
+            recountAvailable(parent);
+            next += children;
+            nodes[p] = parent;
+            maxKeys[p] = maxKeys[next - 1];
+        }
+        count = parents;
+    }
+    tree->root = nodes[0];
+    free(nodes);
+    free(maxKeys);
+}
+
+// Merges entries[from, end) into leaf. If the result overflows, the leaf keeps the
+// first share and new leaves are chained after it. Returns the number of leaves used.
+int mergeBatchIntoLeaf(BPlusTreeNode* leaf, const BatchEntry* entries, int from, int end,
+                       char (*keys)[20], void** data, bool* available) {
+    const int maxKeys = B_PLUS_ORDER - 1;
+    int total = 0, a = 0, b = from;
+    while (a < leaf->numKeys || b < end) {
+        if (b == end || (a < leaf->numKeys && strcmp(leaf->keys[a], entries[b].key) <= 0)) {
+            strcpy(keys[total], leaf->keys[a]);
+            data[total] = leaf->data[a];
+            available[total++] = (leaf->availableMask >> a) & 1u;
+            a++;
+        } else {
+            strcpy(keys[total], entries[b].key);
+            data[total] = entries[b].data;
+            available[total++] = entries[b].available;
+            b++;
+        }
+    }
+
+    int pieces = (total + maxKeys - 1) / maxKeys;
+    int next = 0;
+    BPlusTreeNode* node = leaf;
+    for (int p = 0; p < pieces; p++) {
+        int size = total / pieces + (p < total % pieces ? 1 : 0);
+        if (p > 0) {
+            BPlusTreeNode* piece = createBPlusTreeNode(true);
+            piece->next = node->next;
+            node->next = piece;
+            node = piece;
+        }
+        node->availableMask = 0;
+        for (int k = 0; k < size; k++, next++) {
+            strcpy(node->keys[k], keys[next]);
+            node->data[k] = data[next];
+            if (available[next]) node->availableMask |= (uint8_t)(1u << k);
+        }
+        node->numKeys = size;
+        recountAvailable(node);
+    }
+    return pieces;
+}
+
+// Inserts a batch in key order, visiting each leaf it touches once. A small batch
+// descends once per leaf; a batch at least half the tree's size walks the leaf chain
+// instead. Leaves that overflow are split in the chain and the inner levels are
+// rebuilt once at the end.
+void batchInsertIntoBPlusTree(BPlusTree* tree, BatchEntry* entries, int n) {
+    if (n <= 0) return;
+    sortBatchEntries(entries, n);
+    if (tree->root == NULL) {
+        tree->root = createBPlusTreeNode(true);
+    }
+
+    const int maxKeys = B_PLUS_ORDER - 1;
+    char (*keys)[20] = (char (*)[20])malloc((size_t)(n + maxKeys) * sizeof(*keys));
+    void** data = (void**)malloc((size_t)(n + maxKeys) * sizeof(void*));
+    bool* available = (bool*)malloc((size_t)(n + maxKeys) * sizeof(bool));
+    if (keys == NULL || data == NULL || available == NULL) {
+        fprintf(stderr, "Memory allocation failed for batch insert\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bool restructured = false;
+    if ((long)n * 2 >= tree->numKeys) {
+        BPlusTreeNode* leaf = tree->root;
+        while (!leaf->isLeaf) leaf = leaf->children[0];
+        for (int i = 0; leaf != NULL && i < n;) {
+            BPlusTreeNode* following = leaf->next;
+            tree->tombstones -= purgeTombstones(leaf);
+            int end = i;
+            if (following == NULL) {
+                end = n;
+            } else if (leaf->numKeys > 0) {
+                // Keys up to this leaf's largest belong here; later ones go further right
+                while (end < n && strcmp(entries[end].key, leaf->keys[leaf->numKeys - 1]) <= 0) {
+                    end++;
+                }
+            }
+            if (end > i) {
+                mergeBatchIntoLeaf(leaf, entries, i, end, keys, data, available);
+            }
+            i = end;
+            leaf = following;
+        }
+        restructured = true;
+    } else {
+        BPlusTreeNode* path[64];
+        int depth;
+        const char* upper;
+        for (int i = 0; i < n;) {
+            BPlusTreeNode* leaf = findLeafWithBound(tree, entries[i].key, &upper, path, &depth);
+            tree->tombstones -= purgeTombstones(leaf);
+            int end = i, added = 0;
+            while (end < n && (upper == NULL || strcmp(entries[end].key, upper) <= 0)) {
+                added += entries[end].available ? 1 : 0;
+                end++;
+            }
+            if (mergeBatchIntoLeaf(leaf, entries, i, end, keys, data, available) > 1) {
+                restructured = true;
+            } else {
+                for (int d = 0; d < depth; d++) {
+                    path[d]->availableCount += added;
+                }
+            }
+            i = end;
+        }
+    }
+    free(keys);
+    free(data);
+    free(available);
+    tree->numKeys += n;
+
+    if (restructured) {
+        BPlusTreeNode* first = tree->root;
+        while (!first->isLeaf) first = first->children[0];
+        freeInnerNodes(tree->root);
+        buildInnerLevels(tree, first);
+    }
+    if (tree->bloom != NULL) {
+        if (tree->bloom->keys + n > tree->bloom->capacity) {
+            rebuildBloomFilter(tree);
+        } else {
+            for (int i = 0; i < n; i++) {
+                bloomAdd(tree->bloom, entries[i].key);
+            }
+        }
+    }
+}
+
+// Purges the chain's tombstones and folds each leaf into its predecessor while the
+// pair fits and one of them is under half full. Returns the new first leaf.
+BPlusTreeNode* foldLeafChain(BPlusTree* tree, BPlusTreeNode* first) {
+    const int maxKeys = B_PLUS_ORDER - 1;
+    const int minFill = maxKeys / 2;
+    BPlusTreeNode* kept = NULL;
+    BPlusTreeNode* leaf = first;
+    first = NULL;
+    while (leaf != NULL) {
+        BPlusTreeNode* next = leaf->next;
+        tree->tombstones -= purgeTombstones(leaf);
+        if (kept != NULL && kept->numKeys + leaf->numKeys <= maxKeys &&
+            (kept->numKeys < minFill || leaf->numKeys < minFill)) {
+            for (int k = 0; k < leaf->numKeys; k++) {
+                strcpy(kept->keys[kept->numKeys + k], leaf->keys[k]);
+                kept->data[kept->numKeys + k] = leaf->data[k];
+            }
+            kept->availableMask |= (uint8_t)(leaf->availableMask << kept->numKeys);
+            kept->numKeys += leaf->numKeys;
+            kept->next = next;
+            free(leaf);
+        } else if (leaf->numKeys == 0) {
+            if (kept != NULL) kept->next = next;
+            free(leaf);
+        } else {
+            if (first == NULL) first = leaf;
+            kept = leaf;
+        }
+        leaf = next;
+    }
+    return first;
+}
+
+// Removes a batch of keys with one descent per leaf touched; missing keys are skipped.
+// Leaves left under half full are merged with their neighbours and the inner levels
+// rebuilt once at the end. Returns the number of keys removed.
+int batchDeleteFromBPlusTree(BPlusTree* tree, const char** keys, int n) {
+    if (n <= 0 || tree->root == NULL) return 0;
+    BatchEntry* sorted = (BatchEntry*)malloc(n * sizeof(BatchEntry));
+    if (sorted == NULL) {
+        fprintf(stderr, "Memory allocation failed for batch delete\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) {
+        sorted[i].key = keys[i];
+        sorted[i].data = NULL;
+        sorted[i].available = false;
+    }
+    sortBatchEntries(sorted, n);
+
+    const int minFill = (B_PLUS_ORDER - 1) / 2;
+    int removed = 0;
+    bool underfull = false;
+    BPlusTreeNode* path[64];
+    int depth;
+    const char* upper;
+    for (int i = 0; i < n;) {
+        BPlusTreeNode* leaf = findLeafWithBound(tree, sorted[i].key, &upper, path, &depth);
+        tree->tombstones -= purgeTombstones(leaf);
+        int end = i;
+        while (end < n && (upper == NULL || strcmp(sorted[end].key, upper) <= 0)) {
+            end++;
+        }
+
+        int kept = 0, b = i, lostAvailable = 0;
+        uint8_t mask = 0;
+        for (int a = 0; a < leaf->numKeys; a++) {
+            int cmp = 1;
+            while (b < end && (cmp = strcmp(sorted[b].key, leaf->keys[a])) < 0) {
+                b++;
+            }
+            bool isAvailable = (leaf->availableMask >> a) & 1u;
+            if (b < end && cmp == 0) {
+                removed++;
+                lostAvailable += isAvailable ? 1 : 0;
+                continue;
+            }
+            if (kept != a) {
+                strcpy(leaf->keys[kept], leaf->keys[a]);
+                leaf->data[kept] = leaf->data[a];
+            }
+            if (isAvailable) mask |= (uint8_t)(1u << kept);
+            kept++;
+        }
+        leaf->numKeys = kept;
+        leaf->availableMask = mask;
+        recountAvailable(leaf);
+        for (int d = 0; d < depth; d++) {
+            path[d]->availableCount -= lostAvailable;
+        }
+        if (kept < minFill) {
+            underfull = true;
+        }
+        i = end;
+    }
+    free(sorted);
+    tree->numKeys -= removed;
+
+    if (underfull) {
+        BPlusTreeNode* first = tree->root;
+        while (!first->isLeaf) first = first->children[0];
+        freeInnerNodes(tree->root);
+        buildInnerLevels(tree, foldLeafChain(tree, first));
+    }
+    if (tree->bloom != NULL && removed > 0) {
+        tree->bloom->deletions += removed;
+        if (tree->bloom->deletions * 2 > tree->bloom->keys) {
+            rebuildBloomFilter(tree);
+        }
+    }
+    return removed;
+}
+
+// Dealer feeds: bulk car imports and bulk status changes through the batch tree APIs
+void lookupShowrooms(Showroom** showrooms) {
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        char showroomIdStr[20];
+        sprintf(showroomIdStr, "%d", i + 1);
+        showrooms[i] = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
+    }
+}
+
+// Feed lines use the cars.txt columns without the sold flag:
+// VIN,name,color,price,fuelType,carType,showroomId
+void importDealerFeed(const char* fileName) {
+    FILE* fp = fopen(fileName, "r");
+    if (!fp) {
+        printf("Error opening %s for reading.\n", fileName);
+        return;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int count = 0, capacity = 0, invalid = 0, duplicates = 0;
+    Car* cars = NULL;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char VIN[20] = "", name[MAX_STRING] = "", color[MAX_STRING] = "", price[32] = "";
+        int fuelType, carType, showroomId;
+        if (sscanf(line, "%19[^,],%99[^,],%99[^,],%31[^,],%d,%d,%d", VIN, name, color, price,
+                   &fuelType, &carType, &showroomId) != 7 ||
+            showroomId < 1 || showroomId > MAX_SHOWROOMS || fuelType < PETROL || fuelType > HYBRID ||
+            carType < HATCHBACK || carType > SUV) {
+            invalid++;
+            continue;
+        }
+        Money amount;
+        if (!parseMoney(price, LAKH_DIGITS, &amount) || amount < 0) {
+            invalid++;
+            continue;
+        }
+        if (searchInBPlusTree(carTree, VIN) != NULL) {
+            duplicates++;
+            continue;
+        }
+        if (count == capacity) {
+            int newCapacity = capacity == 0 ? 256 : capacity * 2;
+            Car* temp = (Car*)realloc(cars, newCapacity * sizeof(Car));
+            if (temp == NULL) {
+                fprintf(stderr, "Memory allocation failed for dealer feed\n");
+                break;
+            }
+            cars = temp;
+            capacity = newCapacity;
+        }
+        Car* car = &cars[count++];
+        strcpy(car->VIN, VIN);
+        car->nameId = internString(name);
+        car->colorId = internString(color);
+        car->price = amount;
+        car->fuelType = (FuelType)fuelType;
+        car->carType = (CarType)carType;
+        car->isSold = false;
+        car->showroomId = showroomId;
+    }
+    fclose(fp);
+
+    // Entries carry the parsed car until it has a row; the keys stay in cars
+    BatchEntry* entries = (BatchEntry*)malloc((count > 0 ? count : 1) * sizeof(BatchEntry));
+    if (entries == NULL) {
+        fprintf(stderr, "Memory allocation failed for dealer feed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        entries[i].key = cars[i].VIN;
+        entries[i].data = &cars[i];
+        entries[i].available = true;
+    }
+
+    // A VIN repeated within the feed keeps its first occurrence
+    sortBatchEntries(entries, count);
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique > 0 && strcmp(entries[unique - 1].key, entries[i].key) == 0) {
+            duplicates++;
+            continue;
+        }
+        entries[unique++] = entries[i];
+    }
+    count = unique;
+
+    char (*priceKeys)[20] = (char (*)[20])malloc((count > 0 ? count : 1) * sizeof(*priceKeys));
+    BatchEntry* priceEntries = (BatchEntry*)malloc((count > 0 ? count : 1) * sizeof(BatchEntry));
+    if (priceKeys == NULL || priceEntries == NULL) {
+        fprintf(stderr, "Memory allocation failed for dealer feed\n");
+        exit(EXIT_FAILURE);
+    }
+    Showroom* showrooms[MAX_SHOWROOMS];
+    lookupShowrooms(showrooms);
+    for (int i = 0; i < count; i++) {
+        Car* car = (Car*)entries[i].data;
+        int row = assignCarRow(car);
+        entries[i].data = carRef(row);
+        priceKey(car->price, priceKeys[i]);
+        priceEntries[i].key = priceKeys[i];
+        priceEntries[i].data = carRef(row);
+        priceEntries[i].available = false;
+        Showroom* showroom = showrooms[car->showroomId - 1];
+        if (showroom != NULL) {
+            showroom->numTotalCars++;
+            showroom->numAvailableCars++;
+        }
+    }
+    batchInsertIntoBPlusTree(carTree, entries, count);
+    if (!singleCarIndex) {
+        for (int i = 0; i < count; i++) {
+            entries[i].available = false;
+        }
+        batchInsertIntoBPlusTree(availableCarTree, entries, count);
+    }
+    batchInsertIntoBPlusTree(carPriceTree, priceEntries, count);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsedMs = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    // Same events as adding the cars one by one, with one update per touched showroom
+    bool touched[MAX_SHOWROOMS] = {false};
+    for (int i = 0; i < count; i++) {
+        int row = carRow(entries[i].data);
+        cdcCarEvent("insert", row);
+        touched[carColumns.showroomId[row] - 1] = true;
+    }
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        if (touched[i] && showrooms[i] != NULL) cdcShowroomEvent(showrooms[i]);
+    }
+
+    printf("Imported %d cars from %s (%d already known or repeated, %d invalid lines) in %.3f ms",
+           count, fileName, duplicates, invalid, elapsedMs);
+    if (elapsedMs > 0) {
+        printf(", %.0f rows/s", (count + duplicates + invalid) / (elapsedMs / 1000.0));
+    }
+    printf(".\n");
+    free(entries);
+    free(cars);
+    free(priceEntries);
+    free(priceKeys);
+    if (count > 0) {
+        saveCarsToFile();
+        saveShowroomsToFile();
+    }
+}
+
+// Marks every car listed in fileName (one VIN per line) as sold without a customer
+// record, e.g. fleet transfers reported by the dealer
+void bulkMarkCarsSold(const char* fileName) {
+    FILE* fp = fopen(fileName, "r");
+    if (!fp) {
+        printf("Error opening %s for reading.\n", fileName);
+        return;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Showroom* showrooms[MAX_SHOWROOMS];
+    lookupShowrooms(showrooms);
+    int count = 0, capacity = 0, skipped = 0;
+    BatchEntry* entries = NULL;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char VIN[20];
+        if (sscanf(line, "%19s", VIN) != 1) {
+            continue;
+        }
+        int row = findCarRow(VIN);
+        if (row < 0 || carColumns.isSold[row]) {
+            skipped++;
+            continue;
+        }
+        if (count == capacity) {
+            int newCapacity = capacity == 0 ? 256 : capacity * 2;
+            BatchEntry* temp = (BatchEntry*)realloc(entries, newCapacity * sizeof(BatchEntry));
+            if (temp == NULL) {
+                fprintf(stderr, "Memory allocation failed for bulk mark sold\n");
+                break;
+            }
+            entries = temp;
+            capacity = newCapacity;
+        }
+        carColumns.isSold[row] = 1;
+        setAvailability(carTree, carColumns.VIN[row], false);
+        markCarRowSold(row);
+        int showroomId = carColumns.showroomId[row];
+        if (showroomId >= 1 && showroomId <= MAX_SHOWROOMS && showrooms[showroomId - 1] != NULL) {
+            showrooms[showroomId - 1]->numSoldCars++;
+            showrooms[showroomId - 1]->numAvailableCars--;
+        }
+        entries[count].key = carColumns.VIN[row];
+        entries[count].data = carRef(row);
+        entries[count].available = false;
+        count++;
+    }
+    fclose(fp);
+
+    if (!singleCarIndex && count > 0) {
+        const char** keys = (const char**)malloc(count * sizeof(const char*));
+        if (keys == NULL) {
+            fprintf(stderr, "Memory allocation failed for bulk mark sold\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < count; i++) {
+            keys[i] = entries[i].key;
+        }
+        batchDeleteFromBPlusTree(availableCarTree, keys, count);
+        batchInsertIntoBPlusTree(soldCarTree, entries, count);
+        free(keys);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsedMs = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    bool touched[MAX_SHOWROOMS] = {false};
+    for (int i = 0; i < count; i++) {
+        int row = carRow(entries[i].data);
+        cdcCarEvent("update", row);
+        int showroomId = carColumns.showroomId[row];
+        if (showroomId >= 1 && showroomId <= MAX_SHOWROOMS) touched[showroomId - 1] = true;
+    }
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        if (touched[i] && showrooms[i] != NULL) cdcShowroomEvent(showrooms[i]);
+    }
+    printf("Marked %d cars sold (%d unknown or already sold) in %.3f ms.\n", count, skipped, elapsedMs);
+    free(entries);
+    if (count > 0) {
+        saveCarsToFile();
+        saveShowroomsToFile();
+    }
+}
+
+// Deletion functions
+int finddeleteKeyPosition(BPlusTreeNode* node, char* key) {
+    int idx = 0;
+    while (idx < node->numKeys && strcmp(key, node->keys[idx]) > 0) {
+        idx++;
+    }
+    return idx;
+}
+
+char* getPredecessor(BPlusTreeNode* node, int idx) {
+    BPlusTreeNode* curr = node->children[idx];
+    while (!curr->isLeaf) {
+        curr = curr->children[curr->numKeys];
+    }
+    return curr->keys[curr->numKeys - 1];
+}
+
+void removeFromLeaf(BPlusTreeNode* node, int idx) {
+    for (int i = idx + 1; i < node->numKeys; i++) {
+        strcpy(node->keys[i - 1], node->keys[i]);
+        node->data[i - 1] = node->data[i];
+    }
+    unsigned int below = (1u << idx) - 1;
+    node->availableMask = (uint8_t)((node->availableMask & below) | ((node->availableMask >> 1) & ~below));
+    node->numKeys--;
+    recountAvailable(node);
+}
+
+// Leaves hold every key, so leaf rebalancing moves entries between siblings and only
+// rewrites the parent's separator (the largest key of the left subtree)
+void borrowLeafFromPrev(BPlusTreeNode* parent, int idx) {
+    BPlusTreeNode* child = parent->children[idx];
+    BPlusTreeNode* sibling = parent->children[idx - 1];
+    for (int i = child->numKeys - 1; i >= 0; i--) {
+        strcpy(child->keys[i + 1], child->keys[i]);
+        child->data[i + 1] = child->data[i];
+    }
+    int last = sibling->numKeys - 1;
+    strcpy(child->keys[0], sibling->keys[last]);
+    child->data[0] = sibling->data[last];
+    child->availableMask = (uint8_t)((child->availableMask << 1) | ((sibling->availableMask >> last) & 1u));
+    sibling->availableMask &= (uint8_t)((1u << last) - 1);
+    child->numKeys++;
+    sibling->numKeys--;
+    strcpy(parent->keys[idx - 1], sibling->keys[last - 1]);
+    recountAvailable(child);
+    recountAvailable(sibling);
+}
+
+void borrowLeafFromNext(BPlusTreeNode* parent, int idx) {
+    BPlusTreeNode* child = parent->children[idx];
+    BPlusTreeNode* sibling = parent->children[idx + 1];
+    strcpy(child->keys[child->numKeys], sibling->keys[0]);
+    child->data[child->numKeys] = sibling->data[0];
+    child->availableMask |= (uint8_t)((sibling->availableMask & 1u) << child->numKeys);
+    child->numKeys++;
+    removeFromLeaf(sibling, 0);
+    strcpy(parent->keys[idx], child->keys[child->numKeys - 1]);
+    recountAvailable(child);
+}
+
+void mergeLeaves(BPlusTreeNode* parent, int idx) {
+    BPlusTreeNode* child = parent->children[idx];
+    BPlusTreeNode* sibling = parent->children[idx + 1];
+    for (int i = 0; i < sibling->numKeys; i++) {
+        strcpy(child->keys[child->numKeys + i], sibling->keys[i]);
+        child->data[child->numKeys + i] = sibling->data[i];
+    }
+    child->availableMask |= (uint8_t)(sibling->availableMask << child->numKeys);
+    child->numKeys += sibling->numKeys;
+    child->next = sibling->next;
+    recountAvailable(child);
+    for (int i = idx + 1; i < parent->numKeys; i++) {
+        strcpy(parent->keys[i - 1], parent->keys[i]);
+        parent->data[i - 1] = parent->data[i];
+    }
+    for (int i = idx + 2; i <= parent->numKeys; i++) {
+        parent->children[i - 1] = parent->children[i];
+    }
+    parent->numKeys--;
+    free(sibling);
+}
+
+void borrowFromPrev(BPlusTreeNode* parent, int idx) {
+    BPlusTreeNode* child = parent->children[idx];
+    BPlusTreeNode* sibling = parent->children[idx - 1];
+    if (child->isLeaf) {
+        borrowLeafFromPrev(parent, idx);
+        return;
+    }
+    for (int i = child->numKeys - 1; i >= 0; i--) {
+        strcpy(child->keys[i + 1], child->keys[i]);
+        child->data[i + 1] = child->data[i];
+    }
+    if (!child->isLeaf) {
+        for (int i = child->numKeys; i >= 0; i--) {
+            child->children[i + 1] = child->children[i];
+        }
+    }
+    strcpy(child->keys[0], parent->keys[idx - 1]);
+    child->data[0] = parent->data[idx - 1];
+    if (!child->isLeaf) {
+        child->children[0] = sibling->children[sibling->numKeys];
+    }
+    strcpy(parent->keys[idx - 1], sibling->keys[sibling->numKeys - 1]);
+    parent->data[idx - 1] = sibling->data[sibling->numKeys - 1];
+    child->numKeys++;
+    sibling->numKeys--;
+    recountAvailable(child);
+    recountAvailable(sibling);
+}
+
+void borrowFromNext(BPlusTreeNode* parent, int idx) {
+    BPlusTreeNode* child = parent->children[idx];
+    BPlusTreeNode* sibling = parent->children[idx + 1];
+    if (child->isLeaf) {
+        borrowLeafFromNext(parent, idx);
+        return;
+    }
+    strcpy(child->keys[child->numKeys], parent->keys[idx]);
+    child->data[child->numKeys] = parent->data[idx];
+    if (!child->isLeaf) {
+        child->children[child->numKeys + 1] = sibling->children[0];
+    }
+    strcpy(parent->keys[idx], sibling->keys[0]);
+    parent->data[idx] = sibling->data[0];
+    for (int i = 1; i < sibling->numKeys; i++) {
+        strcpy(sibling->keys[i - 1], sibling->keys[i]);
+        sibling->data[i - 1] = sibling->data[i];
+    }
+    if (!sibling->isLeaf) {
+        for (int i = 1; i <= sibling->numKeys; i++) {
+            sibling->children[i - 1] = sibling->children[i];
+        }
+    }
+    child->numKeys++;
+    sibling->numKeys--;
+    recountAvailable(child);
+    recountAvailable(sibling);
+}
+
+void merge(BPlusTreeNode* parent, int idx) {
+    BPlusTreeNode* child = parent->children[idx];
+    BPlusTreeNode* sibling = parent->children[idx + 1];
+    if (child->isLeaf) {
+        mergeLeaves(parent, idx);
+        return;
+    }
+    strcpy(child->keys[child->numKeys], parent->keys[idx]);
+    child->data[child->numKeys] = parent->data[idx];
+    for (int i = 0; i < sibling->numKeys; i++) {
+        strcpy(child->keys[child->numKeys + 1 + i], sibling->keys[i]);
+        child->data[child->numKeys + 1 + i] = sibling->data[i];
+    }
+    if (!child->isLeaf) {
+        for (int i = 0; i <= sibling->numKeys; i++) {
+            child->children[child->numKeys + 1 + i] = sibling->children[i];
+        }
+    }
+    for (int i = idx + 1; i < parent->numKeys; i++) {
+        strcpy(parent->keys[i - 1], parent->keys[i]);
+        parent->data[i - 1] = parent->data[i];
+    }
+    for (int i = idx + 2; i <= parent->numKeys; i++) {
+        parent->children[i - 1] = parent->children[i];
+    }
+    child->numKeys += sibling->numKeys + 1;
+    parent->numKeys--;
+    recountAvailable(child);
+    free(sibling);
+}
+
+void fill(BPlusTreeNode* parent, int idx, int minKeys) {
+    if (idx != 0 && parent->children[idx - 1]->numKeys > minKeys) {
+        COUNT_EVENT(COUNTER_BORROWS, 1);
+        borrowFromPrev(parent, idx);
+    } else if (idx != parent->numKeys && parent->children[idx + 1]->numKeys > minKeys) {
+        COUNT_EVENT(COUNTER_BORROWS, 1);
+        borrowFromNext(parent, idx);
+    } else {
+        COUNT_EVENT(COUNTER_MERGES, 1);
+        if (idx != parent->numKeys) {
+            merge(parent, idx);
+        } else {
+            merge(parent, idx - 1);
+        }
+    }
+}
+
+bool deleteKeyHelper(BPlusTreeNode* node, char* key, int minKeys) {
+    int idx = finddeleteKeyPosition(node, key);
+    COUNT_EVENT(COUNTER_NODE_VISITS, 1);
+    COUNT_EVENT(COUNTER_KEY_COMPARISONS, idx + (idx < node->numKeys));
+    if (node->isLeaf) {
+        if (idx < node->numKeys && strcmp(node->keys[idx], key) == 0) {
+            removeFromLeaf(node, idx);
+            return true;
+        }
+        printf("Key %s not found in the B+ tree.\n", key);
+        return false;
+    }
+    // An inner key only bounds its left subtree, so it stays valid when that key is removed
+    bool isLastChild = (idx == node->numKeys);
+    if (node->children[idx]->numKeys <= minKeys) {
+        fill(node, idx, minKeys);
+    }
+    if (isLastChild && idx > node->numKeys) {
+        idx--;
+    }
+    bool found = deleteKeyHelper(node->children[idx], key, minKeys);
+    recountAvailable(node);
+    return found;
+}
+
+// Marks key's slot dead and drops its availability bit; nothing moves. Returns false if absent.
+bool lazyDeleteKey(BPlusTree* tree, const char* key) {
+    BPlusTreeNode* path[64];
+    int depth;
+    const char* upper;
+    BPlusTreeNode* leaf = findLeafWithBound(tree, key, &upper, path, &depth);
+    for (int i = 0; i < leaf->numKeys; i++) {
+        if (strcmp(leaf->keys[i], key) != 0 || ((leaf->tombstoneMask >> i) & 1u)) {
+            continue;
+        }
+        leaf->tombstoneMask |= (uint8_t)(1u << i);
+        if ((leaf->availableMask >> i) & 1u) {
+            leaf->availableMask &= (uint8_t)~(1u << i);
+            leaf->availableCount--;
+            for (int d = 0; d < depth; d++) {
+                path[d]->availableCount--;
+            }
+        }
+        tree->tombstones++;
+        if (leaf->numKeys - countBits(leaf->tombstoneMask) == tree->minLiveKeys - 1) {
+            tree->underflowLeaves++;
+        }
+        // Purging only shifts slots inside this leaf, so parent bounds stay valid
+        if (countBits(leaf->tombstoneMask) * 2 > leaf->numKeys) {
+            tree->tombstones -= purgeTombstones(leaf);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Brings key back in its dead slot with new data and status, while lazyDeleteKey's
+// slot has not been purged. Returns false if it has.
+bool reviveLazyKey(BPlusTree* tree, const char* key, void* data, bool available) {
+    if (tree->root == NULL || tree->tombstones == 0) return false;
+    BPlusTreeNode* path[64];
+    int depth;
+    const char* upper;
+    BPlusTreeNode* leaf = findLeafWithBound(tree, key, &upper, path, &depth);
+    for (int i = 0; i < leaf->numKeys; i++) {
+        if (strcmp(leaf->keys[i], key) == 0 && ((leaf->tombstoneMask >> i) & 1u)) {
+            leaf->tombstoneMask &= (uint8_t)~(1u << i);
+            leaf->data[i] = data;
+            if (available) {
+                leaf->availableMask |= (uint8_t)(1u << i);
+                leaf->availableCount++;
+                for (int d = 0; d < depth; d++) {
+                    path[d]->availableCount++;
+                }
+            }
+            tree->tombstones--;
+            tree->numKeys++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Purges every tombstone, folds drained leaves into their neighbours and rebuilds the
+// inner levels, all in one pass over the leaf chain
+void compactBPlusTree(BPlusTree* tree) {
+    if (tree->root == NULL) return;
+    BPlusTreeNode* first = tree->root;
+    while (!first->isLeaf) first = first->children[0];
+    freeInnerNodes(tree->root);
+    buildInnerLevels(tree, foldLeafChain(tree, first));
+    tree->underflowLeaves = 0;
+}
+
+// The full pass runs only at idle points (between commands, at batch commits)
+bool compactionDue(const BPlusTree* tree) {
+    if (tree == NULL || !tree->lazyDeletes) return false;
+    return tree->underflowLeaves > 0 || tree->tombstones * 4 > tree->numKeys;
+}
+
+void deleteFromBPlusTree(BPlusTree* tree, char* key) {
+    if (tree->root == NULL) {
+        return;
+    }
+    if (tree->lazyDeletes) {
+        if (!lazyDeleteKey(tree, key)) {
+            printf("Key %s not found in the B+ tree.\n", key);
+            return;
+        }
+        tree->numKeys--;
+    } else {
+        int minKeys = (tree->order / 2) - 1;
+        if (!deleteKeyHelper(tree->root, key, minKeys)) {
+            return;
+        }
+        tree->numKeys--;
+        if (tree->root->numKeys == 0 && !tree->root->isLeaf) {
+            BPlusTreeNode* oldRoot = tree->root;
+            tree->root = tree->root->children[0];
+            free(oldRoot);
+        }
+        if (tree->root->numKeys == 0 && tree->root->isLeaf) {
+            BPlusTreeNode* oldRoot = tree->root;
+            tree->root = NULL;
+            free(oldRoot);
+        }
+    }
+    // Deleted keys still pass the filter; rebuild once they are half of the keys it holds
+    if (tree->bloom != NULL && ++tree->bloom->deletions * 2 > tree->bloom->keys) {
+        rebuildBloomFilter(tree);
+    }
+}
+
+void printNode(BPlusTreeNode* node, int level) {
+    if (node == NULL) return;
+    for (int i = 0; i < level; i++) {
+        printf("  ");
+    }
+    printf("Keys: ");
+    for (int i = 0; i < node->numKeys; i++) {
+        printf("%s ", node->keys[i]);
+    }
+    printf("\n");
+    if (!node->isLeaf) {
+        for (int i = 0; i <= node->numKeys; i++) {
+            printNode(node->children[i], level + 1);
+        }
+    }
+}
+
+void printBPlusTree(BPlusTree* tree) {
+    if (tree->root == NULL) {
+        printf("Empty tree.\n");
+        return;
+    }
+    printNode(tree->root, 0);
+}
+
+size_t recordSize(int type, const void* record) {
+    switch (type) {
+        case 1: // One row across the car columns
+            return sizeof(*carColumns.VIN) + 2 * sizeof(uint32_t) + sizeof(Money) + sizeof(int) + 3 * sizeof(uint8_t);
+        case 2: {
+            const Customer* customer = (const Customer*)record;
+            return sizeof(Customer) + (customer->name ? strlen(customer->name) + 1 : 0) +
+                   (customer->address ? strlen(customer->address) + 1 : 0);
+        }
+        case 3: return sizeof(SalesPerson);
+        case 4: return sizeof(Showroom);
+        case 5: return sizeof(SaleRecord);
+        default: return 0;
+    }
+}
+
+void measureNode(const BPlusTree* tree, const BPlusTreeNode* node, int depth, TreeShape* shape) {
+    if (depth > shape->height) shape->height = depth;
+    shape->nodes++;
+    shape->slots += node->numKeys;
+    if (node != tree->root && (shape->minKeys < 0 || node->numKeys < shape->minKeys)) {
+        shape->minKeys = node->numKeys;
+    }
+    if (!node->isLeaf) {
+        for (int i = 0; i <= node->numKeys; i++) {
+            measureNode(tree, node->children[i], depth + 1, shape);
+        }
+        return;
+    }
+    shape->leaves++;
+    for (int i = 0; i < node->numKeys; i++) {
+        if (node->tombstoneMask & (1u << i)) {
+            shape->tombstones++;
+            continue;
+        }
+        shape->liveKeys++;
+        shape->keyLengths[strnlen(node->keys[i], 19)]++;
+        shape->recordBytes += recordSize(tree->type, node->data[i]);
+    }
+}
+
+// Adds the tree's shape to shape, which starts zeroed with minKeys = -1
+void measureTree(const BPlusTree* tree, TreeShape* shape) {
+    shape->trees++;
+    if (tree->root != NULL) {
+        measureNode(tree, tree->root, 1, shape);
+    }
+    shape->nodeBytes = shape->nodes * sizeof(BPlusTreeNode);
+}
+
+// The indexes of the statistics report; the per-salesperson customer trees share a row
+int measureIndexes(IndexShape* indexes) {
+    BPlusTree* trees[MAX_MEASURED_INDEXES] = {carTree, availableCarTree, soldCarTree, carPriceTree, showroomTree,
+                                              salesTimeTree, customerVinTree};
+    const char* names[] = {"Cars by VIN", "Available cars", "Sold cars", "Cars by price", "Showrooms",
+                           "Sales by time", "Customers by VIN"};
+    int count = 0;
+    for (int i = 0; i < 7 + MAX_SHOWROOMS; i++) {
+        BPlusTree* tree = i < 7 ? trees[i] : salesPersonTrees[i - 7];
+        if (tree == NULL) continue;
+        IndexShape* index = &indexes[count++];
+        memset(&index->shape, 0, sizeof(TreeShape));
+        index->shape.minKeys = -1;
+        if (i < 7) {
+            snprintf(index->name, sizeof(index->name), "%s", names[i]);
+        } else {
+            snprintf(index->name, sizeof(index->name), "Sales persons of showroom %d", i - 6);
+        }
+        measureTree(tree, &index->shape);
+    }
+    IndexShape* customers = &indexes[count++];
+    snprintf(customers->name, sizeof(customers->name), "Customers (%d trees)", numSalesPersonTrees);
+    memset(&customers->shape, 0, sizeof(TreeShape));
+    customers->shape.minKeys = -1;
+    for (int i = 0; i < numSalesPersonTrees; i++) {
+        measureTree(salesPersonCustomerTrees[i].customerTree, &customers->shape);
+    }
+    return count;
+}
+
+double shapeFill(const TreeShape* shape) {
+    return shape->nodes > 0 ? 100.0 * shape->slots / (shape->nodes * (B_PLUS_ORDER - 1)) : 0;
+}
+
+double shapeMinFill(const TreeShape* shape) {
+    return shape->minKeys >= 0 ? 100.0 * shape->minKeys / (B_PLUS_ORDER - 1) : 100.0;
+}
+
+void shapeKeyLengths(const TreeShape* shape, int* minLength, double* avgLength, int* maxLength) {
+    long keys = 0, total = 0;
+    *minLength = 0;
+    *maxLength = 0;
+    for (int length = 0; length < 20; length++) {
+        if (shape->keyLengths[length] == 0) continue;
+        if (keys == 0) *minLength = length;
+        *maxLength = length;
+        keys += shape->keyLengths[length];
+        total += shape->keyLengths[length] * length;
+    }
+    *avgLength = keys > 0 ? (double)total / keys : 0;
+}
+
+void displayTreeShapes() {
+    IndexShape indexes[MAX_MEASURED_INDEXES];
+    int count = measureIndexes(indexes);
+    printf("\n=== Tree Shape (order %d) ===\n", B_PLUS_ORDER);
+    printf("%-28s%-8s%-10s%-10s%-11s%-11s%-11s%-11s%s\n", "Index", "Height", "Nodes", "Leaves", "Avg fill%",
+           "Min fill%", "Node KB", "Record KB", "Key length min/avg/max");
+    printf("------------------------------------------------------------------------------------------------------------------\n");
+    for (int i = 0; i < count; i++) {
+        const TreeShape* shape = &indexes[i].shape;
+        int minLength, maxLength;
+        double avgLength;
+        shapeKeyLengths(shape, &minLength, &avgLength, &maxLength);
+        printf("%-28s%-8d%-10ld%-10ld%-11.1f%-11.1f%-11.1f%-11.1f%d/%.1f/%d", indexes[i].name, shape->height,
+               shape->nodes, shape->leaves, shapeFill(shape), shapeMinFill(shape), shape->nodeBytes / 1024.0,
+               shape->recordBytes / 1024.0, minLength, avgLength, maxLength);
+        if (shape->tombstones > 0) printf(" (%ld tombstones)", shape->tombstones);
+        printf("\n");
+    }
+}
+
+void printTreeStatistics(const char* name, BPlusTree* tree) {
+    printf("%-28s%-10d", name, tree->numKeys);
+    const BloomFilter* bloom = tree->bloom;
+    if (bloom == NULL) {
+        printf("no filter\n");
+        return;
+    }
+    long rejected = atomic_load_explicit(&bloom->rejected, memory_order_relaxed);
+    long falsePositives = atomic_load_explicit(&bloom->falsePositives, memory_order_relaxed);
+    long negatives = rejected + falsePositives;
+    printf("%-11.1f%-14.3f%-12ld%-12ld", bloom->numBits / 8192.0, 100.0 * bloomExpectedFalsePositiveRate(bloom),
+           rejected, falsePositives);
+    if (negatives > 0) {
+        printf("%.3f\n", 100.0 * falsePositives / negatives);
+    } else {
+        printf("n/a\n");
+    }
+}
+
+// Key counts per index and, for filtered trees, how well the Bloom filter screens misses
+void displayIndexStatistics() {
+    printf("\n=== Index Statistics ===\n");
+    printf("%-28s%-10s%-11s%-14s%-12s%-12s%s\n", "Index", "Keys", "Filter KB", "Expected FP%",
+           "Rejected", "False pos.", "Measured FP%");
+    printf("----------------------------------------------------------------------------------------------\n");
+    printTreeStatistics("Cars by VIN", carTree);
+    if (!singleCarIndex) {
+        printTreeStatistics("Available cars", availableCarTree);
+        printTreeStatistics("Sold cars", soldCarTree);
+    }
+    printTreeStatistics("Cars by price", carPriceTree);
+    printTreeStatistics("Showrooms", showroomTree);
+    printTreeStatistics("Sales by time", salesTimeTree);
+    printTreeStatistics("Customers by VIN", customerVinTree);
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        char name[40];
+        sprintf(name, "Sales persons, showroom %d", i + 1);
+        printTreeStatistics(name, salesPersonTrees[i]);
+    }
+    for (int i = 0; i < numSalesPersonTrees; i++) {
+        char name[80];
+        snprintf(name, sizeof(name), "Customers of %s", salesPersonCustomerTrees[i].salesPersonId);
+        printTreeStatistics(name, salesPersonCustomerTrees[i].customerTree);
+    }
+    displayTreeShapes();
+}
+
+void saveAllToFiles() {
+    TIME_SCOPE(TIMER_SAVE_ALL);
+    saveCarsToFile();
+    saveCustomersToFile();
+    saveSalesPersonsToFile();
+    saveShowroomsToFile();
+    saveSalesRollupsToFile();
+}
+
+void saveCarsToFile() {
+    TIME_SCOPE(TIMER_SAVE_CARS);
+    IoFile file;
+    FILE* fp = ioOpen(&file, "cars.txt", "w");
+    if (!fp) {
+        printf("Error opening cars.txt for writing.\n");
+        return;
+    }
+    char price[32];
+    BPlusTreeNode* current = carTree->root;
+    while (current && !current->isLeaf) current = current->children[0];
+    while (current) {
+        for (int i = 0; i < current->numKeys; i++) {
+            int row = carRow(current->data[i]);
+            formatMoney(carColumns.price[row], LAKH_DIGITS, price);
+            fprintf(fp, "%s,%s,%s,%s,%d,%d,%d,%d\n",
+                    carColumns.VIN[row], carName(row), carColor(row), price,
+                    carColumns.fuelType[row], carColumns.carType[row], carColumns.isSold[row],
+                    carColumns.showroomId[row]);
+        }
+        current = current->next;
+    }
+    ioClose(&file);
+}
+
+// The rows are appended first and the car trees are then bulk-built from them, which
+// packs their leaves; per-key inserts of the price keys would leave them half full
+void loadCarsFromFile() {
+    TIME_SCOPE(TIMER_LOAD_CARS);
+    FILE* fp = fopen("cars.txt", "r");
+    if (!fp) return;
+    int firstRow = carColumns.numRows;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        Car car = {0};
+        int isSold;
+        char name[MAX_STRING] = "", color[MAX_STRING] = "", price[32] = "";
+        sscanf(line, "%19[^,],%99[^,],%99[^,],%31[^,],%d,%d,%d,%d",
+               car.VIN, name, color, price,
+               (int*)&car.fuelType, (int*)&car.carType, &isSold, &car.showroomId);
+        if (!parseMoney(price, LAKH_DIGITS, &car.price)) car.price = 0;
+        car.nameId = internString(name);
+        car.colorId = internString(color);
+        car.isSold = (bool)isSold;
+        assignCarRow(&car);
+    }
+    fclose(fp);
+
+    // Keys point into carColumns, which stops moving once every row is in
+    int count = carColumns.numRows - firstRow;
+    if (count == 0) return;
+    BatchEntry* entries = (BatchEntry*)malloc(count * sizeof(BatchEntry));
+    BatchEntry* otherEntries = (BatchEntry*)malloc(count * sizeof(BatchEntry));
+    char (*priceKeys)[20] = (char (*)[20])malloc(count * sizeof(*priceKeys));
+    if (entries == NULL || otherEntries == NULL || priceKeys == NULL) {
+        fprintf(stderr, "Memory allocation failed for loading cars\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        int row = firstRow + i;
+        entries[i].key = carColumns.VIN[row];
+        entries[i].data = carRef(row);
+        entries[i].available = !carColumns.isSold[row];
+        priceKey(carColumns.price[row], priceKeys[i]);
+        otherEntries[i].key = priceKeys[i];
+        otherEntries[i].data = carRef(row);
+        otherEntries[i].available = false;
+    }
+    batchInsertIntoBPlusTree(carTree, entries, count);
+    batchInsertIntoBPlusTree(carPriceTree, otherEntries, count);
+    if (!singleCarIndex) {
+        // Available cars fill otherEntries from the front, sold cars from the back
+        int numAvailable = 0, numSold = 0;
+        for (int i = 0; i < count; i++) {
+            BatchEntry entry = {entries[i].key, entries[i].data, false};
+            if (entries[i].available) {
+                otherEntries[numAvailable++] = entry;
+            } else {
+                otherEntries[count - ++numSold] = entry;
+            }
+        }
+        batchInsertIntoBPlusTree(availableCarTree, otherEntries, numAvailable);
+        batchInsertIntoBPlusTree(soldCarTree, otherEntries + numAvailable, numSold);
+    }
+    free(entries);
+    free(otherEntries);
+    free(priceKeys);
+}
+
+void saveCustomersToFile() {
+    TIME_SCOPE(TIMER_SAVE_CUSTOMERS);
+    IoFile file;
+    FILE* fp = ioOpen(&file, "customers.txt", "w");
+    if (!fp) {
+        printf("Error opening customers.txt for writing.\n");
+        return;
+    }
+    for (int i = 0; i < numSalesPersonTrees; i++) {
+        BPlusTreeNode* current = salesPersonCustomerTrees[i].customerTree->root;
+        while (current && !current->isLeaf) current = current->children[0];
+        while (current) {
+            for (int j = 0; j < current->numKeys; j++) {
+                Customer* customer = (Customer*)current->data[j];
+                char downPayment[32], loanAmount[32], emiAmount[32];
+                formatMoney(customer->downPayment, LAKH_DIGITS, downPayment);
+                formatMoney(customer->loanAmount, LAKH_DIGITS, loanAmount);
+                formatMoney(customer->emiAmount, RUPEE_DIGITS, emiAmount);
+                fprintf(fp, "%s,%s,%s,%s,%s,%s,%d,%d,%s,%s,%s,%lld\n",
+                        salesPersonCustomerTrees[i].salesPersonId, customerName(customer), customer->mobileNo,
+                        customer->address ? customer->address : "", customer->VIN, customer->registrationNo,
+                        customer->paymentType, customer->emiMonths, downPayment,
+                        loanAmount, emiAmount, (long long)customer->saleTime);
+            }
+            current = current->next;
+        }
+    }
+    ioClose(&file);
+}
+
+// Customers are collected first and each tree is then bulk-built from its share
+void loadCustomersFromFile() {
+    TIME_SCOPE(TIMER_LOAD_CUSTOMERS);
+    FILE* fp = fopen("customers.txt", "r");
+    if (!fp) return;
+    PointerList customers = {NULL, 0, 0};
+    PointerList customerTrees = {NULL, 0, 0};
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        Customer* customer = (Customer*)malloc(sizeof(Customer));
+        char salesPersonId[50];
+        char name[MAX_STRING] = "", address[MAX_STRING] = "";
+        char downPayment[32] = "0", loanAmount[32] = "0", emiAmount[32] = "0";
+        long long saleTime = 0;
+        sscanf(line, "%49[^,],%99[^,],%14[^,],%99[^,],%19[^,],%19[^,],%d,%d,%31[^,],%31[^,],%31[^,],%lld",
+               salesPersonId, name, customer->mobileNo, address,
+               customer->VIN, customer->registrationNo, (int*)&customer->paymentType,
+               &customer->emiMonths, downPayment, loanAmount,
+               emiAmount, &saleTime);
+        if (!parseMoney(downPayment, LAKH_DIGITS, &customer->downPayment)) customer->downPayment = 0;
+        if (!parseMoney(loanAmount, LAKH_DIGITS, &customer->loanAmount)) customer->loanAmount = 0;
+        if (!parseMoney(emiAmount, RUPEE_DIGITS, &customer->emiAmount)) customer->emiAmount = 0;
+        customer->saleTime = (time_t)saleTime;
+        customer->name = arenaStrdup(&stringArena, name);
+        customer->address = arenaStrdup(&stringArena, address);
+        textIndexInsert(&customerNameIndex, customerName(customer), customer);
+        if (!pointerListAppend(&customers, customer) ||
+            !pointerListAppend(&customerTrees, getCustomerTreeForSalesPerson(salesPersonId))) {
+            fprintf(stderr, "Memory allocation failed for loading customers\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    fclose(fp);
+
+    int count = customers.count;
+    BatchEntry* entries = (BatchEntry*)malloc((count > 0 ? count : 1) * sizeof(BatchEntry));
+    if (entries == NULL) {
+        fprintf(stderr, "Memory allocation failed for loading customers\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        Customer* customer = (Customer*)customers.items[i];
+        entries[i].key = customer->VIN;
+        entries[i].data = customer;
+        entries[i].available = false;
+    }
+    batchInsertIntoBPlusTree(customerVinTree, entries, count);
+
+    // customers.txt is written one salesperson at a time, so each run of lines
+    // sharing a tree is one batch
+    for (int i = 0; i < count;) {
+        BPlusTree* customerTree = (BPlusTree*)customerTrees.items[i];
+        int n = 0;
+        for (; i < count && customerTrees.items[i] == customerTree; i++) {
+            Customer* customer = (Customer*)customers.items[i];
+            entries[n].key = customer->mobileNo;
+            entries[n].data = customer;
+            entries[n].available = false;
+            n++;
+        }
+        batchInsertIntoBPlusTree(customerTree, entries, n);
+    }
+    free(entries);
+    free(customers.items);
+    free(customerTrees.items);
+}
+
+void saveSalesPersonsToFile() {
+    TIME_SCOPE(TIMER_SAVE_SALESPERSONS);
+    IoFile file;
+    FILE* fp = ioOpen(&file, "salespersons.txt", "w");
+    if (!fp) {
+        printf("Error opening salespersons.txt for writing.\n");
+        return;
+    }
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        if (salesPersonTrees[i]) {
+            BPlusTreeNode* current = salesPersonTrees[i]->root;
+            while (current && !current->isLeaf) current = current->children[0];
+            while (current) {
+                for (int j = 0; j < current->numKeys; j++) {
+                    SalesPerson* person = (SalesPerson*)current->data[j];
+                    char salesTarget[32], salesAchieved[32], commission[32];
+                    formatMoney(person->salesTarget, LAKH_DIGITS, salesTarget);
+                    formatMoney(person->salesAchieved, LAKH_DIGITS, salesAchieved);
+                    formatMoney(person->commission, LAKH_DIGITS, commission);
+                    fprintf(fp, "%d,%d,%s,%s,%s,%s,%d,%d\n",
+                            i + 1, person->id, person->name, salesTarget,
+                            salesAchieved, commission, person->numSales,
+                            person->extraIncentive);
+                }
+                current = current->next;
+            }
+        }
+    }
+    ioClose(&file);
+}
+
+void loadSalesPersonsFromFile() {
+    TIME_SCOPE(TIMER_LOAD_SALESPERSONS);
+    FILE* fp = fopen("salespersons.txt", "r");
+    if (!fp) return;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        SalesPerson* person = (SalesPerson*)malloc(sizeof(SalesPerson));
+        int showroomId, extraIncentive;
+        char salesTarget[32] = "0", salesAchieved[32] = "0", commission[32] = "0";
+        sscanf(line, "%d,%d,%99[^,],%31[^,],%31[^,],%31[^,],%d,%d",
+               &showroomId, &person->id, person->name, salesTarget,
+               salesAchieved, commission, &person->numSales,
+               &extraIncentive);
+        if (!parseMoney(salesTarget, LAKH_DIGITS, &person->salesTarget)) person->salesTarget = 0;
+        if (!parseMoney(salesAchieved, LAKH_DIGITS, &person->salesAchieved)) person->salesAchieved = 0;
+        if (!parseMoney(commission, LAKH_DIGITS, &person->commission)) person->commission = 0;
+        person->extraIncentive = (bool)extraIncentive;
+        memset(&person->sales, 0, sizeof(SalesRollup));
+        char key[20];
+        sprintf(key, "%d", person->id);
+        insertIntoBPlusTree(salesPersonTrees[showroomId - 1], key, person);
+    }
+    fclose(fp);
+}
+
+void saveShowroomsToFile() {
+    TIME_SCOPE(TIMER_SAVE_SHOWROOMS);
+    IoFile file;
+    FILE* fp = ioOpen(&file, "showrooms.txt", "w");
+    if (!fp) {
+        printf("Error opening showrooms.txt for writing.\n");
+        return;
+    }
+    // The three monthly columns are trailing 30-day windows kept for older readers;
+    // the full history lives in sales_rollups.txt
+    time_t now = time(NULL);
+    BPlusTreeNode* current = showroomTree->root;
+    while (current && !current->isLeaf) current = current->children[0];
+    while (current) {
+        for (int i = 0; i < current->numKeys; i++) {
+            Showroom* showroom = (Showroom*)current->data[i];
+            SalesBucket lastMonth = rollupWindow(&showroom->sales, now, 30, 0);
+            SalesBucket twoMonthsAgo = rollupWindow(&showroom->sales, now, 60, 30);
+            SalesBucket threeMonthsAgo = rollupWindow(&showroom->sales, now, 90, 60);
+            char totalSales[32], month1[32], month2[32], month3[32];
+            formatMoney(showroom->totalSales, LAKH_DIGITS, totalSales);
+            formatMoney(lastMonth.amount, LAKH_DIGITS, month1);
+            formatMoney(twoMonthsAgo.amount, LAKH_DIGITS, month2);
+            formatMoney(threeMonthsAgo.amount, LAKH_DIGITS, month3);
+            fprintf(fp, "%d,%s,%s,%d,%d,%d,%s,%s,%s,%s,%d,%d,%d\n",
+                    showroom->id, showroom->name, showroom->manufacturer,
+                    showroom->numTotalCars, showroom->numAvailableCars,
+                    showroom->numSoldCars, totalSales, 
+                    month1, month2, 
+                    month3, lastMonth.cars,
+                    twoMonthsAgo.cars, threeMonthsAgo.cars);
+        }
+        current = current->next;
+    }
+    ioClose(&file);
+}
+
+void loadShowroomsFromFile() {
+    TIME_SCOPE(TIMER_LOAD_SHOWROOMS);
+    FILE* fp = fopen("showrooms.txt", "r");
+    if (!fp) return;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        Showroom* showroom = (Showroom*)calloc(1, sizeof(Showroom));
+        char totalSales[32] = "0", monthText[3][32] = {"0", "0", "0"};
+        Money monthSales[3] = {0, 0, 0};
+        int monthCars[3] = {0, 0, 0};
+        sscanf(line, "%d,%99[^,],%99[^,],%d,%d,%d,%31[^,],%31[^,],%31[^,],%31[^,],%d,%d,%d",
+               &showroom->id, showroom->name, showroom->manufacturer,
+               &showroom->numTotalCars, &showroom->numAvailableCars,
+               &showroom->numSoldCars, totalSales, 
+               monthText[0], monthText[1], 
+               monthText[2], &monthCars[0],
+               &monthCars[1], &monthCars[2]);
+        if (!parseMoney(totalSales, LAKH_DIGITS, &showroom->totalSales)) showroom->totalSales = 0;
+        for (int m = 0; m < 3; m++) {
+            if (!parseMoney(monthText[m], LAKH_DIGITS, &monthSales[m])) monthSales[m] = 0;
+        }
+        // Seed the rolling buckets from the month columns; replaced by
+        // sales_rollups.txt when that file exists
+        time_t now = time(NULL);
+        for (int m = 2; m >= 0; m--) {
+            if (monthSales[m] != 0 || monthCars[m] != 0) {
+                rollupRecord(&showroom->sales, now - (time_t)(15 + 30 * m) * SECONDS_PER_DAY,
+                             monthSales[m], monthCars[m]);
+            }
+        }
+        char key[20];
+        sprintf(key, "%d", showroom->id);
+        insertIntoBPlusTree(showroomTree, key, showroom);
+    }
+    fclose(fp);
+}
+
+bool addCar(int showroomId, Car* car) {
+    TIME_SCOPE(TIMER_ADD_CAR);
+    if (showroomId < 1 || showroomId > MAX_SHOWROOMS) {
+        if (!batchMode) printf("Invalid showroom ID %d. Must be between 1 and %d.\n", showroomId, MAX_SHOWROOMS);
+        return false;
+    }
+
+    if (searchInBPlusTree(carTree, car->VIN) != NULL) {
+        if (!batchMode) printf("Car with VIN %s already exists.\n", car->VIN);
+        return false;
+    }
+
+    Car newCar = *car;
+    newCar.isSold = false;
+    newCar.showroomId = showroomId;
+
+    int row = registerCarRow(&newCar);
+    insertWithStatus(carTree, carColumns.VIN[row], carRef(row), true);
+    if (!singleCarIndex) {
+        insertIntoBPlusTree(availableCarTree, carColumns.VIN[row], carRef(row));
+    }
+    char price[32];
+    formatMoney(newCar.price, LAKH_DIGITS, price);
+    char VIN[40], name[2 * MAX_STRING], color[2 * MAX_STRING];
+    publishMutation("add-car\t%d\t%s\t%s\t%s\t%s\t%d\t%d", showroomId, replicationField(newCar.VIN, VIN, sizeof(VIN)),
+                    replicationField(carName(row), name, sizeof(name)),
+                    replicationField(carColor(row), color, sizeof(color)), price, newCar.fuelType, newCar.carType);
+    cdcCarEvent("insert", row);
+
+    char showroomIdStr[20];
+    sprintf(showroomIdStr, "%d", showroomId);
+    Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
+    if (showroom != NULL) {
+        showroom->numTotalCars++;
+        showroom->numAvailableCars++;
+        cdcShowroomEvent(showroom);
+    }
+
+    if (!batchMode) {
+        printf("Added car %s with VIN %s to showroom %d.\n", stringById(newCar.nameId), newCar.VIN, showroomId);
+        saveCarsToFile();
+        saveShowroomsToFile();
+    }
+    return true;
+}
+
+void collectCars(BPlusTreeNode* firstLeaf, BPlusTreeNode* endLeaf, void* partial) {
+    for (BPlusTreeNode* leaf = firstLeaf; leaf != endLeaf; leaf = leaf->next) {
+        for (int i = 0; i < leaf->numKeys; i++) {
+            if ((leaf->tombstoneMask >> i) & 1u) continue;
+            pointerListAppend((PointerList*)partial, leaf->data[i]);
+        }
+    }
+}
+
+void mergeAndSortShowroomsByVIN(const char* outputName) {
+    // carTree leaves are already in VIN order, so concatenating the ranges in order sorts the merge
+    PointerList* partials;
+    int numPartials = parallelScanTrees(&carTree, 1, collectCars, sizeof(PointerList), (void**)&partials);
+    int totalCars = 0;
+    for (int p = 0; p < numPartials; p++) {
+        totalCars += partials[p].count;
+    }
+    ShowroomCar* allCars = (ShowroomCar*)malloc((totalCars > 0 ? totalCars : 1) * sizeof(ShowroomCar));
+    if (allCars == NULL) {
+        printf("Memory allocation failed\n");
+        for (int p = 0; p < numPartials; p++) free(partials[p].items);
+        free(partials);
+        return;
+    }
+    totalCars = 0;
+    for (int p = 0; p < numPartials; p++) {
+        for (int i = 0; i < partials[p].count; i++) {
+            allCars[totalCars].row = carRow(partials[p].items[i]);
+            allCars[totalCars].showroomId = carColumns.showroomId[allCars[totalCars].row];
+            totalCars++;
+        }
+        free(partials[p].items);
+    }
+    free(partials);
+    
+    printf("\n=== Merged and Sorted Cars from All Showrooms (%s) ===\n", outputName);
+    printf("VIN\t\tName\t\tColor\tPrice\tFuel Type\tCar Type\tStatus\tShowroom ID\n");
+    printf("----------------------------------------------------------------------------------------\n");
+    
+    for (int i = 0; i < totalCars; i++) {
+        int row = allCars[i].row;
+        printf("%-16s%-16s%-8s%-8.2f%-12s%-12s%-8s%d\n",
+               carColumns.VIN[row], carName(row), carColor(row), moneyToLakhs(carColumns.price[row]),
+               fuelTypeToString((FuelType)carColumns.fuelType[row]), carTypeToString((CarType)carColumns.carType[row]),
+               carColumns.isSold[row] ? "Sold" : "Available", allCars[i].showroomId);
+    }
+    
+    FILE* fp = fopen(outputName, "w");
+    if (fp == NULL) {
+        printf("Error opening file %s for writing\n", outputName);
+    } else {
+        fprintf(fp, "VIN,Name,Color,Price,Fuel Type,Car Type,Status,Showroom ID\n");
+        for (int i = 0; i < totalCars; i++) {
+            int row = allCars[i].row;
+            fprintf(fp, "%s,%s,%s,%.2f,%s,%s,%s,%d\n",
+                    carColumns.VIN[row], carName(row), carColor(row), moneyToLakhs(carColumns.price[row]),
+                    fuelTypeToString((FuelType)carColumns.fuelType[row]),
+                    carTypeToString((CarType)carColumns.carType[row]),
+                    carColumns.isSold[row] ? "Sold" : "Available", allCars[i].showroomId);
+        }
+        fclose(fp);
+        printf("\nMerged data saved to %s\n", outputName);
+    }
+    
+    free(allCars);
+}
+
+// New functions
+typedef struct {
+    PointerList showroomCars[MAX_SHOWROOMS];
+} ShowroomCarsPartial;
+
+void collectCarsByShowroom(BPlusTreeNode* firstLeaf, BPlusTreeNode* endLeaf, void* partial) {
+    ShowroomCarsPartial* byShowroom = (ShowroomCarsPartial*)partial;
+    for (BPlusTreeNode* leaf = firstLeaf; leaf != endLeaf; leaf = leaf->next) {
+        for (int j = 0; j < leaf->numKeys; j++) {
+            int showroomId = carColumns.showroomId[carRow(leaf->data[j])];
+            if (showroomId >= 1 && showroomId <= MAX_SHOWROOMS) {
+                pointerListAppend(&byShowroom->showroomCars[showroomId - 1], leaf->data[j]);
+            }
+        }
+    }
+}
+
+void displayAllCarsShowroomWise() {
+    ShowroomCarsPartial* partials;
+    int numPartials = parallelScanTrees(&carTree, 1, collectCarsByShowroom, sizeof(ShowroomCarsPartial),
+                                        (void**)&partials);
+
+    printf("\n=== Cars Organized by Showroom ===\n");
+    for (int i = 1; i <= MAX_SHOWROOMS; i++) {
+        char showroomIdStr[20];
+        sprintf(showroomIdStr, "%d", i);
+        Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
+        
+        if (showroom == NULL) {
+            printf("Showroom %d not found.\n", i);
+            continue;
+        }
+        
+        printf("\nShowroom %d: %s (%s)\n", showroom->id, showroom->name, showroom->manufacturer);
+        printf("----------------------------------------\n");
+        printf("VIN\t\tName\t\tColor\tPrice\tStatus\n");
+        printf("----------------------------------------\n");
+        
+        int carCount = 0;
+        for (int p = 0; p < numPartials; p++) {
+            PointerList* cars = &partials[p].showroomCars[i - 1];
+            for (int j = 0; j < cars->count; j++) {
+                int row = carRow(cars->items[j]);
+                printf("%-16s%-16s%-8s%-8.2f%s\n",
+                       carColumns.VIN[row], carName(row), carColor(row), moneyToLakhs(carColumns.price[row]),
+                       carColumns.isSold[row] ? "Sold" : "Available");
+                carCount++;
+            }
+        }
+        
+        if (carCount == 0) {
+            printf("No cars found in this showroom.\n");
+        }
+        printf("Total cars: %d\n", carCount);
+    }
+
+    for (int p = 0; p < numPartials; p++) {
+        for (int i = 0; i < MAX_SHOWROOMS; i++) {
+            free(partials[p].showroomCars[i].items);
+        }
+    }
+    free(partials);
+}
+
+void displayAvailableCars() {
+    PointerList cars = {NULL, 0, 0};
+    if (singleCarIndex) {
+        collectAvailableCars(carTree->root, &cars);
+    } else {
+        BPlusTreeNode* leaf = leftmostLeaf(availableCarTree->root);
+        collectCars(leaf, NULL, &cars);
+    }
+
+    printf("\n=== Available Cars ===\n");
+    printf("VIN\t\tName\t\tColor\tPrice\tShowroom\n");
+    printf("----------------------------------------\n");
+    for (int i = 0; i < cars.count; i++) {
+        int row = carRow(cars.items[i]);
+        printf("%-16s%-16s%-8s%-8.2f%d\n", carColumns.VIN[row], carName(row), carColor(row),
+               moneyToLakhs(carColumns.price[row]), carColumns.showroomId[row]);
+    }
+    printf("Total available: %d\n", cars.count);
+    free(cars.items);
+}
+
+/*void displayAllSalesPersonsShowroomWise() {
+    printf("\n=== Salespersons Organized by Showroom ===\n");
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        char showroomIdStr[20];
+        sprintf(showroomIdStr, "%d", i + 1);
+        Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
+        
+        if (showroom == NULL || salesPersonTrees[i] == NULL) {
+            printf("Showroom %d not found or not initialized.\n", i + 1);
+            continue;
+        }
+        
+        printf("\nShowroom %d: %s\n", i + 1, showroom->name);
+        printf("----------------------------------------\n");
+        printf("ID\tName\t\tSales Achieved\tCommission\n");
+        printf("----------------------------------------\n");
+        
+        int personCount = 0;
+        BPlusTreeNode* current = salesPersonTrees[i]->root;
+        while (current && !current->isLeaf) current = current->children[0];
+        
+        while (current != NULL) {
+            for (int j = 0; j < current->numKeys; j++) {
+                SalesPerson* person = (SalesPerson*)current->data[j];
+                printf("%-8d%-16s%-16.2f%.2f\n",
+                       person->id, person->name, person->salesAchieved, Ascending(person->commission));
+                personCount++;
+            }
+            current = current->next;
+        }
+        
+        if (personCount == 0) {
+            printf("No salespersons found in this showroom.\n");
+        }
+        printf("Total salespersons: %d\n", personCount);
+    }
+}*/
+void displayAllSalesPersonsShowroomWise() {
+    printf("\n=== Salespersons Organized by Showroom ===\n");
+    for (int i = 0; i < MAX_SHOWROOMS; i++) {
+        char showroomIdStr[20];
+        sprintf(showroomIdStr, "%d", i + 1);
+        Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
+        
+        if (showroom == NULL || salesPersonTrees[i] == NULL) {
+            printf("Showroom %d not found or not initialized.\n", i + 1);
+            continue;
+        }
+        
+        printf("\nShowroom %d: %s\n", i + 1, showroom->name);
+        printf("----------------------------------------\n");
+        printf("ID\tName\t\tSales Achieved\tCommission\n");
+        printf("----------------------------------------\n");
+        
+        int personCount = 0;
+        BPlusTreeNode* current = salesPersonTrees[i]->root;
+        while (current && !current->isLeaf) current = current->children[0];
+        
+        while (current != NULL) {
+            for (int j = 0; j < current->numKeys; j++) {
+                SalesPerson* person = (SalesPerson*)current->data[j];
+                printf("%-8d%-16s%-16.2f%.2f\n",
+                       person->id, person->name, moneyToLakhs(person->salesAchieved), moneyToLakhs(person->commission));
+                personCount++;
+            }
+            current = current->next;
+        }
+        
+        if (personCount == 0) {
+            printf("No salespersons found in this showroom.\n");
+        }
+        printf("Total salespersons: %d\n", personCount);
+    }
+}
+
+void displayCustomersForSalesPerson(int showroomId, int salesPersonId) {
+    char salesPersonIdStr[50];
+    sprintf(salesPersonIdStr, "%d_%d", showroomId, salesPersonId);
+    
+    BPlusTree* customerTree = getCustomerTreeForSalesPerson(salesPersonIdStr);
+    if (customerTree == NULL || customerTree->root == NULL) {
+        printf("No customer tree found for salesperson %d in showroom %d.\n", 
+               salesPersonId, showroomId);
+        return;
+    }
+    
+    printf("\n=== Customers for Salesperson %d in Showroom %d ===\n", 
+           salesPersonId, showroomId);
+    printf("----------------------------------------\n");
+    printf("Name\t\tMobile\t\tCar VIN\t\tPayment\n");
+    printf("----------------------------------------\n");
+    
+    int customerCount = 0;
+    BPlusTreeNode* current = customerTree->root;
+    while (current && !current->isLeaf) current = current->children[0];
+    
+    while (current != NULL) {
+        for (int i = 0; i < current->numKeys; i++) {
+            Customer* customer = (Customer*)current->data[i];
+            printf("%-16s%-16s%-16s%s\n",
+                   customerName(customer), customer->mobileNo, customer->VIN,
+                   paymentTypeToString(customer->paymentType));
+            customerCount++;
+        }
+        current = current->next;
+    }
+    
+    if (customerCount == 0) {
+        printf("No customers found for this salesperson.\n");
+    }
+    printf("Total customers: %d\n", customerCount);
+}
+
+// Q. Batch transaction mode
+// A script holds one command per line with comma-separated fields. Blank lines and
+// lines starting with '#' are skipped. Prices and down payments are in lakhs.
+//   add-car,showroomId,VIN,name,color,price,fuelType,carType
+//   add-salesperson,showroomId,id,name
+//   sell,showroomId,salesPersonId,VIN,customerName,mobile,address,registration,0
+//   sell,showroomId,salesPersonId,VIN,customerName,mobile,address,registration,1,downPayment,emiMonths
+//   find-car,VIN
+//   search-cars,showroomId,fuelType,carType,minPrice,maxPrice,includeSold
+//   sales-range,showroomId,minSales,maxSales
+//   commit
+
+// Splits line in place at separator, dropping the line ending
+int splitBatchFields(char* line, char separator, char** fields, int maxFields) {
+    line[strcspn(line, "\r\n")] = '\0';
+    int count = 0;
+    char* field = line;
+    while (count < maxFields) {
+        fields[count++] = field;
+        char* comma = strchr(field, separator);
+        if (comma == NULL) {
+            return count;
+        }
+        *comma = '\0';
+        field = comma + 1;
+    }
+    return maxFields + 1;      // More fields than any command takes
+}
+
+bool copyBatchField(char* dest, size_t size, const char* field) {
+    size_t length = strlen(field);
+    if (length == 0 || length >= size) {
+        return false;
+    }
+    memcpy(dest, field, length + 1);
+    return true;
+}
+
+bool parseBatchInt(const char* field, int* value) {
+    char extra;
+    return sscanf(field, "%d%c", value, &extra) == 1;
+}
+
+bool parseBatchLakhs(const char* field, Money* amount) {
+    return parseMoney(field, LAKH_DIGITS, amount) && *amount >= 0;
+}
+
+// Writes the data files and the sales made since the last commit, then runs any
+// compaction that was deferred while the batch was busy. Returns false if a follower
+// is loading the files; the changes are then saved by the first commit after it.
+bool commitBatch(BatchStats* stats) {
+    if (atomic_load(&snapshotHold)) {
+        stats->deferredCommits++;
+        return false;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    cdcFlush();
+    saveAllToFiles();
+    if (stats->firstUnloggedSale < numSaleRecords) {
+        IoFile file;
+        FILE* fp = ioOpen(&file, "sales_log.txt", "a");
+        if (!fp) {
+            printf("Error opening sales_log.txt for writing.\n");
+        } else {
+            for (int i = stats->firstUnloggedSale; i < numSaleRecords; i++) {
+                writeSaleRecord(fp, salesLog[i]);
+            }
+            ioClose(&file);
+            stats->firstUnloggedSale = numSaleRecords;
+        }
+    }
+    if (compactionDue(availableCarTree)) {
+        compactBPlusTree(availableCarTree);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats->commitMs += (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    stats->commits++;
+    return true;
+}
+
+int findBatchCommand(const char* name) {
+    for (int i = 0; i < NUM_BATCH_COMMANDS; i++) {
+        if (strcmp(name, batchCommandNames[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// Commands that only read shared state; the server runs these concurrently
+bool isBatchQuery(BatchCommand command) {
+    return command == BATCH_FIND_CAR || command == BATCH_SEARCH_CARS || command == BATCH_SALES_RANGE ||
+           command == BATCH_METRICS;
+}
+
+void replyAppendf(ReplyBuffer* reply, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (reply->length + needed + 1 > reply->capacity) {
+        size_t newCapacity = reply->capacity == 0 ? 256 : reply->capacity;
+        while (reply->length + needed + 1 > newCapacity) newCapacity *= 2;
+        char* temp = (char*)realloc(reply->data, newCapacity);
+        if (temp == NULL) {
+            fprintf(stderr, "Memory allocation failed for reply buffer\n");
+            exit(EXIT_FAILURE);
+        }
+        reply->data = temp;
+        reply->capacity = newCapacity;
+    }
+    va_start(args, format);
+    vsnprintf(reply->data + reply->length, needed + 1, format, args);
+    va_end(args);
+    reply->length += needed;
+}
+
+// Record lines: car,VIN,name,color,price,fuelType,carType,sold,showroomId
+//               sale,VIN,customer,mobile,paymentType,downPayment,loanAmount,emiRupees,emiMonths,saleTime
+//               salesperson,showroomId,id,name,salesAchieved,numSales,commission
+//               tree,index,height,nodes,leaves,liveKeys,tombstones,avgFill%,minFill%,nodeBytes,recordBytes,
+//                    keyLengths (length:count pairs separated by spaces)
+//               counter,name,value and timer,... (see replyMetrics)
+void replyCar(ReplyBuffer* reply, int row) {
+    char price[32];
+    formatMoney(carColumns.price[row], LAKH_DIGITS, price);
+    replyAppendf(reply, "car,%s,%s,%s,%s,%d,%d,%d,%d\n", carColumns.VIN[row], carName(row), carColor(row), price,
+                 carColumns.fuelType[row], carColumns.carType[row], carColumns.isSold[row],
+                 carColumns.showroomId[row]);
+    reply->records++;
+}
+
+void replySale(ReplyBuffer* reply, const Customer* customer) {
+    char down[32], loan[32], emi[32];
+    formatMoney(customer->downPayment, LAKH_DIGITS, down);
+    formatMoney(customer->loanAmount, LAKH_DIGITS, loan);
+    formatMoney(customer->emiAmount, RUPEE_DIGITS, emi);
+    replyAppendf(reply, "sale,%s,%s,%s,%d,%s,%s,%s,%d,%lld\n", customer->VIN, customerName(customer),
+                 customer->mobileNo, customer->paymentType, down, loan, emi, customer->emiMonths,
+                 (long long)customer->saleTime);
+    reply->records++;
+}
+
+void replySalesPerson(ReplyBuffer* reply, int showroomId, const SalesPerson* person) {
+    char achieved[32], commission[32];
+    formatMoney(person->salesAchieved, LAKH_DIGITS, achieved);
+    formatMoney(person->commission, LAKH_DIGITS, commission);
+    replyAppendf(reply, "salesperson,%d,%d,%s,%s,%d,%s\n", showroomId, person->id, person->name,
+                 achieved, person->numSales, commission);
+    reply->records++;
+}
+
+// Runs one parsed command. Query results are counted in stats->matches and, when reply
+// is not NULL, written to it as records.
+BatchResult executeBatchCommand(BatchCommand command, char** fields, int numFields, BatchStats* stats,
+                                ReplyBuffer* reply) {
+    switch (command) {
+        case BATCH_ADD_CAR: {
+            Car car;
+            char name[MAX_STRING], color[MAX_STRING];
+            int showroomId, fuelType, carType;
+            if (numFields != 8 || !parseBatchInt(fields[1], &showroomId) ||
+                !copyBatchField(car.VIN, sizeof(car.VIN), fields[2]) ||
+                !copyBatchField(name, sizeof(name), fields[3]) ||
+                !copyBatchField(color, sizeof(color), fields[4]) ||
+                !parseBatchLakhs(fields[5], &car.price) ||
+                !parseBatchInt(fields[6], &fuelType) || fuelType < PETROL || fuelType > HYBRID ||
+                !parseBatchInt(fields[7], &carType) || carType < HATCHBACK || carType > SUV) {
+                return BATCH_INVALID;
+            }
+            car.nameId = internString(name);
+            car.colorId = internString(color);
+            car.fuelType = (FuelType)fuelType;
+            car.carType = (CarType)carType;
+            return addCar(showroomId, &car) ? BATCH_DONE : BATCH_REJECTED;
+        }
+        case BATCH_ADD_SALESPERSON: {
+            SalesPerson person;
+            int showroomId;
+            if (numFields != 4 || !parseBatchInt(fields[1], &showroomId) ||
+                !parseBatchInt(fields[2], &person.id) ||
+                !copyBatchField(person.name, sizeof(person.name), fields[3])) {
+                return BATCH_INVALID;
+            }
+            return addSalesPerson(showroomId, &person) ? BATCH_DONE : BATCH_REJECTED;
+        }
+        case BATCH_SELL: {
+            Customer customer;
+            char VIN[20], name[MAX_STRING], address[MAX_STRING], salesPersonId[50];
+            int showroomId, personId, paymentType;
+            if ((numFields != 9 && numFields != 11) || !parseBatchInt(fields[1], &showroomId) ||
+                !parseBatchInt(fields[2], &personId) ||
+                !copyBatchField(VIN, sizeof(VIN), fields[3]) ||
+                !copyBatchField(name, sizeof(name), fields[4]) ||
+                !copyBatchField(customer.mobileNo, sizeof(customer.mobileNo), fields[5]) ||
+                !copyBatchField(address, sizeof(address), fields[6]) ||
+                !copyBatchField(customer.registrationNo, sizeof(customer.registrationNo), fields[7]) ||
+                !parseBatchInt(fields[8], &paymentType) || paymentType < CASH || paymentType > LOAN ||
+                (paymentType == LOAN) != (numFields == 11)) {
+                return BATCH_INVALID;
+            }
+            customer.paymentType = (PaymentType)paymentType;
+            if (customer.paymentType == LOAN &&
+                (!parseBatchLakhs(fields[9], &customer.downPayment) ||
+                 !parseBatchInt(fields[10], &customer.emiMonths))) {
+                return BATCH_INVALID;
+            }
+            customer.name = arenaStrdup(&stringArena, name);
+            customer.address = arenaStrdup(&stringArena, address);
+            sprintf(salesPersonId, "%d_%d", showroomId, personId);
+            if (stats->groupOpen) {
+                // Once one sale of the group fails, the whole group rolls back at end
+                if (stats->group.failed || !stageSale(&stats->group, salesPersonId, VIN, &customer)) {
+                    stats->group.failed = true;
+                    return BATCH_REJECTED;
+                }
+                return BATCH_DONE;
+            }
+            if (!sellCar(salesPersonId, VIN, &customer)) {
+                return BATCH_REJECTED;
+            }
+            if (reply != NULL) {
+                Customer* sold = (Customer*)searchInBPlusTree(customerVinTree, VIN);
+                if (sold != NULL) replySale(reply, sold);
+            }
+            return BATCH_DONE;
+        }
+        case BATCH_FIND_CAR: {
+            if (numFields != 2 || fields[1][0] == '\0') {
+                return BATCH_INVALID;
+            }
+            int row = findCarRow(fields[1]);
+            if (row < 0) {
+                return BATCH_REJECTED;
+            }
+            stats->matches++;
+            if (reply != NULL) {
+                replyCar(reply, row);
+                Customer* customer = carColumns.isSold[row]
+                                         ? (Customer*)searchInBPlusTree(customerVinTree, carColumns.VIN[row])
+                                         : NULL;
+                if (customer != NULL) replySale(reply, customer);
+            }
+            return BATCH_DONE;
+        }
+        case BATCH_SEARCH_CARS: {
+            CarQuery query;
+            int includeSold;
+            if (numFields != 7 || !parseBatchInt(fields[1], &query.showroomId) ||
+                !parseBatchInt(fields[2], &query.fuelType) || !parseBatchInt(fields[3], &query.carType) ||
+                !parseBatchLakhs(fields[4], &query.minPrice) || !parseBatchLakhs(fields[5], &query.maxPrice) ||
+                !parseBatchInt(fields[6], &includeSold)) {
+                return BATCH_INVALID;
+            }
+            query.includeSold = includeSold != 0;
+            int* results;
+            int count = searchCarsByAttributes(&query, &results);
+            for (int i = 0; reply != NULL && i < count; i++) {
+                replyCar(reply, results[i]);
+            }
+            stats->matches += count;
+            free(results);
+            return BATCH_DONE;
+        }
+        case BATCH_SALES_RANGE: {
+            int showroomId;
+            Money minSales, maxSales;
+            if (numFields != 4 || !parseBatchInt(fields[1], &showroomId) ||
+                showroomId < 1 || showroomId > MAX_SHOWROOMS || salesPersonTrees[showroomId - 1] == NULL ||
+                !parseBatchLakhs(fields[2], &minSales) || !parseBatchLakhs(fields[3], &maxSales)) {
+                return BATCH_INVALID;
+            }
+            BPlusTreeNode* leaf = leftmostLeaf(salesPersonTrees[showroomId - 1]->root);
+            for (; leaf != NULL; leaf = leaf->next) {
+                for (int i = 0; i < leaf->numKeys; i++) {
+                    SalesPerson* person = (SalesPerson*)leaf->data[i];
+                    if (person->salesAchieved < minSales || person->salesAchieved > maxSales) continue;
+                    stats->matches++;
+                    if (reply != NULL) replySalesPerson(reply, showroomId, person);
+                }
+            }
+            return BATCH_DONE;
+        }
+        case BATCH_TREE_STATS: {
+            if (numFields != 1) {
+                return BATCH_INVALID;
+            }
+            if (reply == NULL) {
+                displayTreeShapes();
+                return BATCH_DONE;
+            }
+            IndexShape indexes[MAX_MEASURED_INDEXES];
+            int count = measureIndexes(indexes);
+            for (int i = 0; i < count; i++) {
+                const TreeShape* shape = &indexes[i].shape;
+                char lengths[256] = "";
+                size_t used = 0;
+                for (int length = 0; length < 20 && used < sizeof(lengths); length++) {
+                    if (shape->keyLengths[length] == 0) continue;
+                    used += snprintf(lengths + used, sizeof(lengths) - used, "%s%d:%ld", used > 0 ? " " : "",
+                                     length, shape->keyLengths[length]);
+                }
+                replyAppendf(reply, "tree,%s,%d,%ld,%ld,%ld,%ld,%.1f,%.1f,%zu,%zu,%s\n", indexes[i].name,
+                             shape->height, shape->nodes, shape->leaves, shape->liveKeys, shape->tombstones,
+                             shapeFill(shape), shapeMinFill(shape), shape->nodeBytes, shape->recordBytes, lengths);
+                reply->records++;
+            }
+            stats->matches += count;
+            return BATCH_DONE;
+        }
+        case BATCH_METRICS: {
+            if (numFields != 1) {
+                return BATCH_INVALID;
+            }
+            if (reply == NULL) {
+                displayMetrics();
+            } else {
+                replyMetrics(reply);
+            }
+            return BATCH_DONE;
+        }
+        case BATCH_BEGIN: {
+            if (numFields != 1) {
+                return BATCH_INVALID;
+            }
+            if (stats->groupOpen) {
+                return BATCH_REJECTED;
+            }
+            beginSaleTransaction(&stats->group);
+            stats->groupOpen = true;
+            return BATCH_DONE;
+        }
+        case BATCH_END: {
+            if (numFields != 1) {
+                return BATCH_INVALID;
+            }
+            if (!stats->groupOpen) {
+                return BATCH_REJECTED;
+            }
+            stats->groupOpen = false;
+            bool failed = stats->group.failed;
+            if (failed) {
+                rollbackSaleTransaction(&stats->group);
+            } else {
+                commitSaleTransaction(&stats->group);
+            }
+            endSaleTransaction(&stats->group);
+            return failed ? BATCH_REJECTED : BATCH_DONE;
+        }
+        case BATCH_COMMIT: {
+            if (numFields != 1) {
+                return BATCH_INVALID;
+            }
+            if (stats->groupOpen) {
+                return BATCH_REJECTED;     // Would save half of a group
+            }
+            if (!commitBatch(stats) && reply != NULL) {
+                replyAppendf(reply, "commit,deferred\n");
+                reply->records++;
+            }
+            return BATCH_DONE;
+        }
+        default:
+            return BATCH_INVALID;
+    }
+}
+
+// Runs a script without prompts or per-operation output. Data files are written every
+// commitEvery operations (0 = only at the end) and at explicit commit lines.
+void runBatchFile(const char* fileName, int commitEvery) {
+    FILE* fp = fopen(fileName, "r");
+    if (!fp) {
+        printf("Error opening %s for reading.\n", fileName);
+        return;
+    }
+    BatchStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.firstUnloggedSale = numSaleRecords;
+    batchMode = true;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    char line[1024];
+    char* fields[12];
+    long lineNumber = 0, operations = 0, sinceCommit = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lineNumber++;
+        if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') {
+            continue;
+        }
+        int numFields = splitBatchFields(line, ',', fields, 12);
+        int command = findBatchCommand(fields[0]);
+        BatchResult result = command < 0 ? BATCH_INVALID
+                                         : executeBatchCommand((BatchCommand)command, fields, numFields, &stats, NULL);
+        if (result == BATCH_INVALID) {
+            if (stats.invalidLines++ < 10) {
+                printf("Line %ld: invalid %s command.\n", lineNumber, fields[0]);
+            }
+            continue;
+        }
+        stats.executed[command]++;
+        if (result == BATCH_REJECTED) stats.failed[command]++;
+        if (command == BATCH_COMMIT) {
+            sinceCommit = 0;
+            continue;
+        }
+        operations++;
+        if (commitEvery > 0 && ++sinceCommit >= commitEvery && !stats.groupOpen) {
+            commitBatch(&stats);
+            sinceCommit = 0;
+        }
+    }
+    fclose(fp);
+    if (stats.groupOpen) {
+        printf("Rolled back %d sales of a group with no end line.\n", stats.group.numSales);
+        rollbackSaleTransaction(&stats.group);
+        endSaleTransaction(&stats.group);
+        stats.groupOpen = false;
+    }
+    commitBatch(&stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ioFlush();
+    batchMode = false;
+    double elapsedMs = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    printf("\n=== Batch Summary: %s ===\n", fileName);
+    printf("%-18s%-12s%s\n", "Command", "Executed", "Failed");
+    for (int i = 0; i < NUM_BATCH_COMMANDS; i++) {
+        if (stats.executed[i] > 0) {
+            printf("%-18s%-12ld%ld\n", batchCommandNames[i], stats.executed[i], stats.failed[i]);
+        }
+    }
+    printf("Invalid lines: %ld\n", stats.invalidLines);
+    printf("Query matches: %ld\n", stats.matches);
+    printf("Commits: %d (%.3f ms saving files)\n", stats.commits, stats.commitMs);
+    printIoStatistics();
+    printf("Operations: %ld in %.3f ms", operations, elapsedMs);
+    if (elapsedMs > 0) {
+        printf(", %.0f ops/s (%.0f ops/s excluding commits)", operations / (elapsedMs / 1000.0),
+               elapsedMs > stats.commitMs ? operations / ((elapsedMs - stats.commitMs) / 1000.0) : 0.0);
+    }
+    printf("\n");
+}
+
+// R. Socket server and load generator
+// Clients send batch-format commands, one per line, over a Unix domain socket. Each
+// reply is "OK <n>" followed by n record lines, or a single "ERR <reason>" line.
+volatile sig_atomic_t serverStopping = 0;
+
+void stopServer(int signal) {
+    (void)signal;
+    serverStopping = 1;
+}
+
+void serverSetInterest(Server* server, ServerConnection* conn, uint32_t events) {
+    if (events == conn->events) return;
+    struct epoll_event event = {.events = events, .data.ptr = conn};
+    int op = conn->events == 0 ? EPOLL_CTL_ADD : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+    epoll_ctl(server->epollFd, op, conn->fd, &event);
+    conn->events = events;
+}
+
+void serverCloseConnection(Server* server, ServerConnection* conn) {
+    serverSetInterest(server, conn, 0);
+    if (conn->busy) {
+        conn->closing = true;  // Freed once the worker hands it back
+        return;
+    }
+    close(conn->fd);
+    if (conn->prev != NULL) conn->prev->next = conn->next;
+    else server->connections = conn->next;
+    if (conn->next != NULL) conn->next->prev = conn->prev;
+    free(conn->records.data);
+    free(conn->output.data);
+    free(conn);
+}
+
+// Runs on a pool thread; the event loop does not touch conn until it is handed back
+void serveRequest(void* arg) {
+    ServerConnection* conn = (ServerConnection*)arg;
+    Server* server = conn->server;
+    char* fields[12];
+    int numFields = splitBatchFields(conn->request, ',', fields, 12);
+    conn->command = findBatchCommand(fields[0]);
+    conn->records.length = 0;
+    conn->records.records = 0;
+    conn->result = BATCH_INVALID;
+    // Sale groups need a BatchStats of their own; server connections share one
+    if (conn->command >= 0 && conn->command != BATCH_BEGIN && conn->command != BATCH_END) {
+        BatchCommand command = (BatchCommand)conn->command;
+        if (isBatchQuery(command)) {
+            BatchStats queryStats;
+            memset(&queryStats, 0, sizeof(queryStats));
+            pthread_rwlock_rdlock(&server->dataLock);
+            conn->result = executeBatchCommand(command, fields, numFields, &queryStats, &conn->records);
+            pthread_rwlock_unlock(&server->dataLock);
+        } else {
+            pthread_rwlock_wrlock(&server->dataLock);
+            conn->result = executeBatchCommand(command, fields, numFields, &server->stats, &conn->records);
+            if (command == BATCH_COMMIT) {
+                server->sinceCommit = 0;
+            } else if (conn->result == BATCH_DONE && command != BATCH_TREE_STATS && server->commitEvery > 0 &&
+                       ++server->sinceCommit >= server->commitEvery && commitBatch(&server->stats)) {
+                server->sinceCommit = 0;       // A deferred commit is retried after the next update
+            }
+            pthread_rwlock_unlock(&server->dataLock);
+            // A client told OK can find the change in the feed, commit or not
+            cdcFlush();
+        }
+    }
+
+    conn->output.length = 0;
+    conn->outputSent = 0;
+    if (conn->result == BATCH_DONE) {
+        replyAppendf(&conn->output, "OK %d\n", conn->records.records);
+        if (conn->records.length > 0) {
+            replyAppendf(&conn->output, "%.*s", (int)conn->records.length, conn->records.data);
+        }
+    } else {
+        replyAppendf(&conn->output, "ERR %s\n", conn->result == BATCH_REJECTED ? "rejected" : "invalid command");
+    }
+
+    pthread_mutex_lock(&server->doneLock);
+    conn->nextDone = server->doneList;
+    server->doneList = conn;
+    pthread_mutex_unlock(&server->doneLock);
+    uint64_t one = 1;
+    if (write(server->wakeFd, &one, sizeof(one)) < 0) {
+        // The counter is already non-zero, so the loop is woken anyway
+    }
+}
+
+// Returns false if the peer is gone
+bool serverFlush(ServerConnection* conn) {
+    while (conn->outputSent < conn->output.length) {
+        ssize_t sent = send(conn->fd, conn->output.data + conn->outputSent,
+                            conn->output.length - conn->outputSent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        conn->outputSent += (size_t)sent;
+    }
+    return true;
+}
+
+// Hands the next buffered line to the pool once the previous reply is fully sent;
+// otherwise waits for output space or more input
+void serverAdvance(Server* server, ServerConnection* conn) {
+    if (conn->outputSent < conn->output.length) {
+        serverSetInterest(server, conn, EPOLLOUT);
+        return;
+    }
+    char* newline = (char*)memchr(conn->input, '\n', conn->inputLength);
+    if (newline == NULL) {
+        if (conn->inputLength == sizeof(conn->input)) {
+            serverCloseConnection(server, conn);  // No line ending in sight
+        } else {
+            serverSetInterest(server, conn, EPOLLIN);
+        }
+        return;
+    }
+    size_t lineLength = (size_t)(newline - conn->input);
+    if (lineLength >= sizeof(conn->request)) {
+        serverCloseConnection(server, conn);
+        return;
+    }
+    memcpy(conn->request, conn->input, lineLength);
+    conn->request[lineLength] = '\0';
+    conn->inputLength -= lineLength + 1;
+    memmove(conn->input, newline + 1, conn->inputLength);
+    conn->busy = true;
+    serverSetInterest(server, conn, 0);
+    threadPoolSubmit(server->pool, serveRequest, conn);
+}
+
+void serverAccept(Server* server) {
+    for (;;) {
+        int fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        ServerConnection* conn = (ServerConnection*)calloc(1, sizeof(ServerConnection));
+        if (conn == NULL) {
+            fprintf(stderr, "Memory allocation failed for ServerConnection\n");
+            close(fd);
+            return;
+        }
+        conn->fd = fd;
+        conn->server = server;
+        conn->next = server->connections;
+        if (server->connections != NULL) server->connections->prev = conn;
+        server->connections = conn;
+        server->accepted++;
+        serverSetInterest(server, conn, EPOLLIN);
+    }
+}
+
+// Takes back connections whose replies the workers have finished
+void serverCollectReplies(Server* server) {
+    uint64_t count;
+    if (read(server->wakeFd, &count, sizeof(count)) < 0) {
+        // Nothing pending; the list below is checked regardless
+    }
+    pthread_mutex_lock(&server->doneLock);
+    ServerConnection* done = server->doneList;
+    server->doneList = NULL;
+    pthread_mutex_unlock(&server->doneLock);
+    while (done != NULL) {
+        ServerConnection* conn = done;
+        done = done->nextDone;
+        conn->busy = false;
+        if (conn->command < 0 || conn->result == BATCH_INVALID) {
+            server->invalid++;
+        } else {
+            server->executed[conn->command]++;
+            if (conn->result == BATCH_REJECTED) server->failed[conn->command]++;
+        }
+        if (conn->closing || !serverFlush(conn)) {
+            serverCloseConnection(server, conn);
+        } else {
+            serverAdvance(server, conn);
+        }
+    }
+}
+
+void serverHandleEvent(Server* server, ServerConnection* conn, uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        serverCloseConnection(server, conn);
+        return;
+    }
+    if (events & EPOLLOUT) {
+        if (!serverFlush(conn)) {
+            serverCloseConnection(server, conn);
+            return;
+        }
+    }
+    if (events & EPOLLIN) {
+        ssize_t received = recv(conn->fd, conn->input + conn->inputLength,
+                                sizeof(conn->input) - conn->inputLength, 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            serverCloseConnection(server, conn);
+            return;
+        }
+        if (received > 0) conn->inputLength += (size_t)received;
+    }
+    serverAdvance(server, conn);
+}
+
+// Serves clients on socketPath until SIGINT or SIGTERM, then commits and prints a summary
+void runServer(const char* socketPath, int workers, int commitEvery, const char* replicatePath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        printf("Socket path %s is too long.\n", socketPath);
+        return;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socketPath);
+    if (server.listenFd < 0 || bind(server.listenFd, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(server.listenFd, SOMAXCONN) < 0) {
+        printf("Error listening on %s: %s\n", socketPath, strerror(errno));
+        if (server.listenFd >= 0) close(server.listenFd);
+        return;
+    }
+    server.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    server.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server.epollFd < 0 || server.wakeFd < 0) {
+        fprintf(stderr, "Failed to create event loop: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event listenEvent = {.events = EPOLLIN, .data.ptr = &server.listenFd};
+    struct epoll_event wakeEvent = {.events = EPOLLIN, .data.ptr = &server.wakeFd};
+    epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.listenFd, &listenEvent);
+    epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.wakeFd, &wakeEvent);
+    pthread_rwlock_init(&server.dataLock, NULL);
+    pthread_mutex_init(&server.doneLock, NULL);
+    server.stats.firstUnloggedSale = numSaleRecords;
+    server.commitEvery = commitEvery;
+    server.pool = threadPoolCreate(workers);
+    batchMode = true;
+    if (replicatePath != NULL && startReplication(&server, replicatePath)) {
+        printf("Shipping the mutation log to followers on %s.\n", replicatePath);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServer;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("Serving on %s with %d worker threads. Press Ctrl+C to stop.\n", socketPath, server.pool->numThreads);
+    fflush(stdout);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!serverStopping) {
+        int ready = epoll_wait(server.epollFd, events, SERVER_MAX_EVENTS, -1);
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.ptr == &server.listenFd) {
+                serverAccept(&server);
+            } else if (events[i].data.ptr == &server.wakeFd) {
+                serverCollectReplies(&server);
+            } else {
+                serverHandleEvent(&server, (ServerConnection*)events[i].data.ptr, events[i].events);
+            }
+        }
+    }
+
+    threadPoolWait(server.pool);
+    serverCollectReplies(&server);
+    while (server.connections != NULL) {
+        serverCloseConnection(&server, server.connections);
+    }
+    threadPoolDestroy(server.pool);
+    stopReplication(replicatePath);
+    commitBatch(&server.stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ioFlush();
+    batchMode = false;
+    close(server.listenFd);
+    close(server.epollFd);
+    close(server.wakeFd);
+    unlink(socketPath);
+    pthread_rwlock_destroy(&server.dataLock);
+    pthread_mutex_destroy(&server.doneLock);
+
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    long requests = server.invalid;
+    printf("\n=== Server Summary ===\n");
+    printf("%-18s%-12s%s\n", "Command", "Executed", "Failed");
+    for (int i = 0; i < NUM_BATCH_COMMANDS; i++) {
+        requests += server.executed[i];
+        if (server.executed[i] > 0) {
+            printf("%-18s%-12ld%ld\n", batchCommandNames[i], server.executed[i], server.failed[i]);
+        }
+    }
+    printf("Invalid requests: %ld\n", server.invalid);
+    printf("Connections: %ld, commits: %d (%.3f ms saving files)", server.accepted, server.stats.commits,
+           server.stats.commitMs);
+    if (server.stats.deferredCommits > 0) {
+        printf(", %d deferred while a follower loaded", server.stats.deferredCommits);
+    }
+    printf("\n");
+    printIoStatistics();
+    printf("Requests: %ld in %.3f s", requests, elapsed);
+    if (elapsed > 0) {
+        printf(", %.0f requests/s", requests / elapsed);
+    }
+    printf("\n");
+}
+
+// Sends one request and reads its reply. Returns the number of records, -1 for an
+// ERR reply and -2 if the connection failed.
+long loadRoundTrip(int fd, const char* request, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        ssize_t n = send(fd, request + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0) return -2;
+        sent += (size_t)n;
+    }
+    char buffer[8192], header[64];
+    size_t headerLength = 0;
+    long linesWanted = -1, linesSeen = 0, records = -1;
+    while (linesWanted < 0 || linesSeen < linesWanted) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) return -2;
+        for (ssize_t i = 0; i < received; i++) {
+            if (linesWanted >= 0) {
+                linesSeen += buffer[i] == '\n';
+            } else if (buffer[i] != '\n') {
+                if (headerLength < sizeof(header) - 1) header[headerLength++] = buffer[i];
+            } else {
+                header[headerLength] = '\0';
+                if (sscanf(header, "OK %ld", &records) != 1) records = -1;
+                linesWanted = records > 0 ? records : 0;
+            }
+        }
+    }
+    return records;
+}
+
+// Each client registers a salesperson, then mixes car adds, lookups, sales and price
+// range searches over its own VINs. Some lookups ask for VINs that were never added,
+// so the Bloom filters answer them without a tree walk.
+void* runLoadClient(void* arg) {
+    LoadClient* client = (LoadClient*)arg;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, client->socketPath, sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        printf("Client %d: error connecting to %s: %s\n", client->clientId, client->socketPath, strerror(errno));
+        if (fd >= 0) close(fd);
+        client->errors = client->requests;
+        return NULL;
+    }
+
+    int showroomId = client->clientId % MAX_SHOWROOMS + 1;
+    int personId = 100000 + (int)(getpid() % 10000) * LOADGEN_MAX_CLIENTS + client->clientId;
+    char prefix[12], request[SERVER_LINE_MAX];
+    snprintf(prefix, sizeof(prefix), "L%d-%d", (int)(getpid() % 100000), client->clientId);
+    int length = snprintf(request, sizeof(request), "add-salesperson,%d,%d,Load Client %d\n",
+                          showroomId, personId, client->clientId);
+    if (loadRoundTrip(fd, request, (size_t)length) < 0) client->errors++;
+
+    unsigned int seed = (unsigned int)(client->clientId * 7919 + 1);
+    int added = 0, sold = 0;
+    for (int i = 0; i < client->requests; i++) {
+        int kind = i % 10;
+        int price = 3 + added % 60;
+        bool expectMiss = false;
+        if (kind < 3 || added == 0) {
+            length = snprintf(request, sizeof(request), "add-car,%d,%s-%d,Load Model %d,Grey,%d.50,%d,%d\n",
+                              showroomId, prefix, added, added % 25, price, added % 5, added % 3);
+            added++;
+        } else if (kind == 8 && sold < added) {
+            int soldPrice = 3 + sold % 60;
+            if (sold % 2 == 0) {
+                length = snprintf(request, sizeof(request), "sell,%d,%d,%s-%d,Buyer %d,9%09d,Load Street,LG%d,0\n",
+                                  showroomId, personId, prefix, sold, sold, sold, sold);
+            } else {
+                length = snprintf(request, sizeof(request),
+                                  "sell,%d,%d,%s-%d,Buyer %d,9%09d,Load Street,LG%d,1,%d,60\n",
+                                  showroomId, personId, prefix, sold, sold, sold, sold, soldPrice / 2 + 1);
+            }
+            sold++;
+        } else if (kind == 9) {
+            length = snprintf(request, sizeof(request), "search-cars,%d,-1,-1,%d,%d.99,0\n",
+                              showroomId, price, price);
+        } else if (kind == 7) {
+            length = snprintf(request, sizeof(request), "find-car,%s-M%d\n", prefix, rand_r(&seed) % added);
+            expectMiss = true;
+        } else {
+            length = snprintf(request, sizeof(request), "find-car,%s-%d\n", prefix, rand_r(&seed) % added);
+        }
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        long records = loadRoundTrip(fd, request, (size_t)length);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (records == -2) {
+            client->errors += client->requests - i;
+            break;
+        }
+        if (records < 0 && expectMiss) {
+            client->misses++;
+        } else if (records < 0 || expectMiss) {
+            client->errors++;
+        } else {
+            client->records += records;
+        }
+        client->latencies[client->completed++] =
+            (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL + (uint64_t)(end.tv_nsec - start.tv_nsec);
+    }
+    close(fd);
+    return NULL;
+}
+
+int compareLatencies(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+void runLoadGenerator(const char* socketPath, int numClients, int requestsPerClient) {
+    if (numClients < 1) numClients = 1;
+    if (numClients > LOADGEN_MAX_CLIENTS) numClients = LOADGEN_MAX_CLIENTS;
+    if (requestsPerClient < 1) requestsPerClient = 1;
+    LoadClient clients[LOADGEN_MAX_CLIENTS];
+    pthread_t threads[LOADGEN_MAX_CLIENTS];
+    uint64_t* latencies = (uint64_t*)malloc((size_t)numClients * requestsPerClient * sizeof(uint64_t));
+    if (latencies == NULL) {
+        fprintf(stderr, "Memory allocation failed for load generator\n");
+        exit(EXIT_FAILURE);
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < numClients; i++) {
+        clients[i] = (LoadClient){socketPath, i, requestsPerClient, 0, 0, 0, 0,
+                                  latencies + (size_t)i * requestsPerClient};
+        if (pthread_create(&threads[i], NULL, runLoadClient, &clients[i]) != 0) {
+            fprintf(stderr, "Failed to start load client %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    long completed = 0, errors = 0, misses = 0, records = 0;
+    for (int i = 0; i < numClients; i++) {
+        pthread_join(threads[i], NULL);
+        // Pack the completed latencies together for the percentiles
+        memmove(latencies + completed, clients[i].latencies, clients[i].completed * sizeof(uint64_t));
+        completed += clients[i].completed;
+        errors += clients[i].errors;
+        misses += clients[i].misses;
+        records += clients[i].records;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    qsort(latencies, completed, sizeof(uint64_t), compareLatencies);
+
+    printf("=== Load Generator: %d clients x %d requests ===\n", numClients, requestsPerClient);
+    printf("Completed: %ld, errors: %ld, missing-VIN lookups: %ld, records received: %ld\n", completed, errors,
+           misses, records);
+    printf("Elapsed: %.3f s", elapsed);
+    if (elapsed > 0) {
+        printf(", %.0f requests/s", completed / elapsed);
+    }
+    printf("\n");
+    if (completed > 0) {
+        printf("Latency (us): p50 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+               latencies[completed / 2] / 1000.0, latencies[completed * 99 / 100] / 1000.0,
+               latencies[completed * 999 / 1000] / 1000.0, latencies[completed - 1] / 1000.0);
+    }
+    free(latencies);
+}
+
+// S. Background file writer
+IoWriter ioWriter;
+
+// Writes one job. A rewrite goes to a temporary file that is renamed over the old one,
+// so a crash or a concurrent reader never sees a half-written snapshot.
+bool writeFully(int fd, const char* data, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t n = write(fd, data + written, length - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        written += (size_t)n;
+    }
+    return true;
+}
+
+bool writeIoJob(const IoJob* job) {
+    char path[80];
+    snprintf(path, sizeof(path), job->append ? "%s" : "%s.tmp", job->fileName);
+    int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC | (job->append ? O_APPEND : O_TRUNC), 0644);
+    if (fd < 0) {
+        printf("Error opening %s for writing.\n", job->fileName);
+        return false;
+    }
+    bool written = writeFully(fd, job->data, job->length);
+    close(fd);
+    if (!written) {
+        printf("Error writing %s: %s\n", job->fileName, strerror(errno));
+        if (!job->append) unlink(path);
+        return false;
+    }
+    if (!job->append && rename(path, job->fileName) != 0) {
+        printf("Error replacing %s: %s\n", job->fileName, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void* runIoWriter(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&ioWriter.lock);
+    for (;;) {
+        while (ioWriter.count == 0 && !ioWriter.stopping) {
+            pthread_cond_wait(&ioWriter.hasWork, &ioWriter.lock);
+        }
+        if (ioWriter.count == 0) break;     // Stopping, and everything is written
+        IoJob job = ioWriter.ring[ioWriter.head];
+        ioWriter.head = (ioWriter.head + 1) % IO_RING_SIZE;
+        ioWriter.count--;
+        ioWriter.inFlight = true;
+        ioWriter.inFlightSequence = job.sequence;
+        pthread_cond_broadcast(&ioWriter.progress);
+        pthread_mutex_unlock(&ioWriter.lock);
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool ok = writeIoJob(&job);
+        free(job.data);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        pthread_mutex_lock(&ioWriter.lock);
+        ioWriter.inFlight = false;
+        ioWriter.writeMs += (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+        if (ok) {
+            ioWriter.files++;
+            ioWriter.bytes += (long)job.length;
+        }
+        pthread_cond_broadcast(&ioWriter.progress);
+    }
+    pthread_mutex_unlock(&ioWriter.lock);
+    return NULL;
+}
+
+// Queues data (taking ownership) for fileName. A rewrite replaces a rewrite of the
+// same file that is still waiting, since only the newest snapshot matters.
+void ioSubmit(const char* fileName, bool append, char* data, size_t length) {
+    pthread_mutex_lock(&ioWriter.lock);
+    ioWriter.submitted++;
+    for (int i = ioWriter.count - 1; i >= 0 && !append; i--) {
+        IoJob* queued = &ioWriter.ring[(ioWriter.head + i) % IO_RING_SIZE];
+        if (strcmp(queued->fileName, fileName) != 0) continue;
+        if (queued->append) break;          // Must land after that append
+        free(queued->data);
+        queued->data = data;
+        queued->length = length;
+        ioWriter.superseded++;
+        pthread_mutex_unlock(&ioWriter.lock);
+        return;
+    }
+    if (ioWriter.count == IO_RING_SIZE) ioWriter.fullWaits++;
+    while (ioWriter.count == IO_RING_SIZE) {
+        pthread_cond_wait(&ioWriter.progress, &ioWriter.lock);
+    }
+    IoJob* job = &ioWriter.ring[(ioWriter.head + ioWriter.count) % IO_RING_SIZE];
+    snprintf(job->fileName, sizeof(job->fileName), "%s", fileName);
+    job->append = append;
+    job->data = data;
+    job->length = length;
+    job->sequence = ioWriter.submitted;
+    ioWriter.count++;
+    pthread_cond_signal(&ioWriter.hasWork);
+    pthread_mutex_unlock(&ioWriter.lock);
+}
+
+FILE* ioOpen(IoFile* file, const char* fileName, const char* mode) {
+    snprintf(file->fileName, sizeof(file->fileName), "%s", fileName);
+    file->append = mode[0] == 'a';
+    file->buffered = ioWriter.running;
+    if (!file->buffered) {
+        file->fp = fopen(fileName, mode);
+        return file->fp;
+    }
+    file->data = NULL;
+    file->length = 0;
+    file->fp = open_memstream(&file->data, &file->length);
+    return file->fp;
+}
+
+void ioClose(IoFile* file) {
+    fclose(file->fp);
+    if (file->buffered) {
+        ioSubmit(file->fileName, file->append, file->data, file->length);
+    }
+}
+
+// Flush barrier: returns once everything submitted before the call has been written.
+// Jobs leave the ring in sequence order, so it is enough to wait for the oldest
+// pending job to be newer than the call.
+void ioFlush() {
+    if (!ioWriter.running) return;
+    pthread_mutex_lock(&ioWriter.lock);
+    long target = ioWriter.submitted;
+    for (;;) {
+        long oldest = ioWriter.inFlight ? ioWriter.inFlightSequence
+                      : ioWriter.count > 0 ? ioWriter.ring[ioWriter.head].sequence
+                      : target + 1;
+        if (oldest > target) break;
+        pthread_cond_wait(&ioWriter.progress, &ioWriter.lock);
+    }
+    pthread_mutex_unlock(&ioWriter.lock);
+}
+
+void ioStart() {
+    memset(&ioWriter, 0, sizeof(ioWriter));
+    pthread_mutex_init(&ioWriter.lock, NULL);
+    pthread_cond_init(&ioWriter.hasWork, NULL);
+    pthread_cond_init(&ioWriter.progress, NULL);
+    if (pthread_create(&ioWriter.thread, NULL, runIoWriter, NULL) != 0) {
+        fprintf(stderr, "Failed to start the file writer thread\n");
+        exit(EXIT_FAILURE);
+    }
+    ioWriter.running = true;
+}
+
+// Writes out everything still queued, then stops the thread
+void ioStop() {
+    if (!ioWriter.running) return;
+    pthread_mutex_lock(&ioWriter.lock);
+    ioWriter.stopping = true;
+    pthread_cond_signal(&ioWriter.hasWork);
+    pthread_mutex_unlock(&ioWriter.lock);
+    pthread_join(ioWriter.thread, NULL);
+    ioWriter.running = false;
+    pthread_mutex_destroy(&ioWriter.lock);
+    pthread_cond_destroy(&ioWriter.hasWork);
+    pthread_cond_destroy(&ioWriter.progress);
+}
+
+void printIoStatistics() {
+    if (!ioWriter.running) return;
+    pthread_mutex_lock(&ioWriter.lock);
+    printf("Background writer: %ld files (%.1f KB) in %.3f ms, %ld superseded rewrites, %ld waits for ring space\n",
+           ioWriter.files, ioWriter.bytes / 1024.0, ioWriter.writeMs, ioWriter.superseded, ioWriter.fullWaits);
+    pthread_mutex_unlock(&ioWriter.lock);
+}
+
+// T. Log-shipping replication
+// A primary started with --serve and --replicate streams its mutations, as batch commands
+// with tab-separated fields, to follower processes started with --follow. A follower
+// loads the primary's snapshot files, replays the log and serves the read-only reports.
+// Lines on the wire: "S,<seq>" (snapshot saved), "M,<seq>,<ns>,<command>" (mutation)
+// and "H,<seq>,<ns>" (heartbeat); the follower answers "L" once it has loaded. Text
+// fields escape backslash, tab, CR and LF; a sell ends with the primary's sale time.
+ReplicationLog* replicationLog = NULL;   // Set on a primary
+Replica* replica = NULL;                 // Set on a follower
+pthread_rwlock_t replicaLock = PTHREAD_RWLOCK_INITIALIZER;  // Reports read, the applier writes
+
+int64_t realtimeNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void publishMutation(const char* format, ...) {
+    ReplicationLog* log = replicationLog;
+    if (log == NULL) return;
+    char record[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(record, sizeof(record), format, args);
+    va_end(args);
+    int64_t now = realtimeNs();
+    pthread_mutex_lock(&log->lock);
+    log->sequence++;
+    replyAppendf(&log->pending, "M,%ld,%lld,%s\n", log->sequence, (long long)now, record);
+    log->pending.records++;
+    pthread_cond_signal(&log->hasData);
+    pthread_mutex_unlock(&log->lock);
+}
+
+// Escapes text for a tab-separated mutation record, truncating it to fit
+const char* replicationField(const char* text, char* out, size_t size) {
+    size_t length = 0;
+    for (const char* c = text; *c != '\0' && length + 3 < size; c++) {
+        const char* escape = *c == '\\' ? "\\\\" : *c == '\t' ? "\\t" : *c == '\n' ? "\\n" : *c == '\r' ? "\\r" : NULL;
+        if (escape != NULL) {
+            memcpy(out + length, escape, 2);
+            length += 2;
+        } else {
+            out[length++] = *c;
+        }
+    }
+    out[length] = '\0';
+    return out;
+}
+
+void unescapeReplicationField(char* field) {
+    char* out = field;
+    for (const char* c = field; *c != '\0'; c++) {
+        if (*c == '\\' && c[1] != '\0') {
+            c++;
+            *out++ = *c == 't' ? '\t' : *c == 'n' ? '\n' : *c == 'r' ? '\r' : *c;
+        } else {
+            *out++ = *c;
+        }
+    }
+    *out = '\0';
+}
+
+bool sendFully(int fd, const char* data, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        ssize_t n = send(fd, data + sent, length - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// Sends data to every follower, dropping the ones that fail or stall
+void replicationShip(ReplicationLog* log, const char* data, size_t length) {
+    for (int i = 0; i < log->numFollowers;) {
+        if (sendFully(log->followers[i], data, length)) {
+            i++;
+            continue;
+        }
+        close(log->followers[i]);
+        log->followers[i] = log->followers[--log->numFollowers];
+    }
+}
+
+// Saves a snapshot for a new follower. The files are not rewritten again until the
+// follower reports that it has loaded them; the records after the snapshot wait in
+// loadingBacklog meanwhile, so the sender keeps shipping to the other followers.
+void replicationAddFollower(ReplicationLog* log, int fd) {
+    struct timeval sendTimeout = {.tv_sec = 5};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+    if (log->numFollowers == REPLICATION_MAX_FOLLOWERS) {
+        close(fd);
+        return;
+    }
+
+    pthread_rwlock_wrlock(&log->server->dataLock);
+    commitBatch(&log->server->stats);
+    ioFlush();
+    pthread_mutex_lock(&log->lock);
+    ReplyBuffer backlog = log->pending;
+    memset(&log->pending, 0, sizeof(log->pending));
+    long sequence = log->sequence;
+    pthread_mutex_unlock(&log->lock);
+    atomic_store(&snapshotHold, true);
+    pthread_rwlock_unlock(&log->server->dataLock);
+
+    // Records up to the snapshot are already in its files
+    replicationShip(log, backlog.data, backlog.length);
+    log->shipped += backlog.records;
+    free(backlog.data);
+
+    char line[64];
+    int length = snprintf(line, sizeof(line), "S,%ld\n", sequence);
+    if (!sendFully(fd, line, (size_t)length)) {
+        close(fd);
+        atomic_store(&snapshotHold, false);
+        return;
+    }
+    log->loadingFd = fd;
+    log->loadingDeadlineNs = realtimeNs() + (int64_t)REPLICATION_LOAD_TIMEOUT_MS * 1000000;
+}
+
+void replicationEndLoading(ReplicationLog* log, bool loaded) {
+    if (loaded) {
+        log->followers[log->numFollowers++] = log->loadingFd;
+        log->snapshots++;
+    } else {
+        close(log->loadingFd);
+    }
+    log->loadingFd = -1;
+    free(log->loadingBacklog.data);
+    memset(&log->loadingBacklog, 0, sizeof(log->loadingBacklog));
+    atomic_store(&snapshotHold, false);
+}
+
+// Checks, without waiting, whether the loading follower has answered "L"
+void replicationPollLoading(ReplicationLog* log, int64_t now) {
+    char reply = 0;
+    ssize_t received = recv(log->loadingFd, &reply, 1, MSG_DONTWAIT);
+    if (received == 1) {
+        replicationEndLoading(log, reply == 'L' && sendFully(log->loadingFd, log->loadingBacklog.data,
+                                                              log->loadingBacklog.length));
+    } else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) ||
+               now >= log->loadingDeadlineNs) {
+        replicationEndLoading(log, false);
+    }
+}
+
+void* runReplicationSender(void* arg) {
+    ReplicationLog* log = (ReplicationLog*)arg;
+    int64_t lastSent = realtimeNs();
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        if (log->pending.length == 0 && !log->stopping) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 100000000;       // Also polls for new and loading followers
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&log->hasData, &log->lock, &deadline);
+        }
+        ReplyBuffer batch = log->pending;
+        memset(&log->pending, 0, sizeof(log->pending));
+        long sequence = log->sequence;
+        bool stopping = log->stopping;
+        pthread_mutex_unlock(&log->lock);
+
+        int64_t now = realtimeNs();
+        if (batch.length > 0) {
+            replicationShip(log, batch.data, batch.length);
+            log->shipped += batch.records;
+            lastSent = now;
+            if (log->loadingFd >= 0) {
+                replyAppendf(&log->loadingBacklog, "%.*s", (int)batch.length, batch.data);
+            }
+        } else if (now - lastSent >= (int64_t)REPLICATION_HEARTBEAT_MS * 1000000) {
+            char line[64];
+            int length = snprintf(line, sizeof(line), "H,%ld,%lld\n", sequence, (long long)now);
+            replicationShip(log, line, (size_t)length);
+            lastSent = now;
+        }
+        free(batch.data);
+        if (stopping) break;
+        if (log->loadingFd >= 0) {
+            replicationPollLoading(log, now);
+        } else {
+            // One follower loads at a time; the next one waits in the listen backlog
+            int fd = accept4(log->listenFd, NULL, NULL, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                replicationAddFollower(log, fd);
+            }
+        }
+        pthread_mutex_lock(&log->lock);
+    }
+    if (log->loadingFd >= 0) {
+        replicationEndLoading(log, false);
+    }
+    return NULL;
+}
+
+bool startReplication(Server* server, const char* socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        printf("Socket path %s is too long.\n", socketPath);
+        return false;
+    }
+    strcpy(address.sun_path, socketPath);
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(socketPath);
+    if (listenFd < 0 || bind(listenFd, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(listenFd, REPLICATION_MAX_FOLLOWERS) < 0) {
+        printf("Error listening on %s: %s\n", socketPath, strerror(errno));
+        if (listenFd >= 0) close(listenFd);
+        return false;
+    }
+
+    ReplicationLog* log = (ReplicationLog*)calloc(1, sizeof(ReplicationLog));
+    if (log == NULL) {
+        fprintf(stderr, "Memory allocation failed for replication log\n");
+        exit(EXIT_FAILURE);
+    }
+    log->listenFd = listenFd;
+    log->loadingFd = -1;
+    log->server = server;
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->hasData, NULL);
+    replicationLog = log;
+    if (pthread_create(&log->thread, NULL, runReplicationSender, log) != 0) {
+        fprintf(stderr, "Failed to start the replication sender\n");
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+// Ships what is left, disconnects the followers and prints a summary
+void stopReplication(const char* socketPath) {
+    ReplicationLog* log = replicationLog;
+    if (log == NULL) return;
+    pthread_mutex_lock(&log->lock);
+    log->stopping = true;
+    pthread_cond_signal(&log->hasData);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->thread, NULL);
+    replicationLog = NULL;
+
+    printf("Replication: %ld records shipped, %d followers joined, %d connected at shutdown\n",
+           log->shipped, log->snapshots, log->numFollowers);
+    for (int i = 0; i < log->numFollowers; i++) {
+        close(log->followers[i]);
+    }
+    close(log->listenFd);
+    unlink(socketPath);
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->hasData);
+    free(log->pending.data);
+    free(log);
+}
+
+// Connects to a primary and waits for it to save a snapshot. Must run before the data
+// files are loaded.
+bool replicaConnect(const char* socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        printf("Socket path %s is too long.\n", socketPath);
+        return false;
+    }
+    strcpy(address.sun_path, socketPath);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        printf("Error connecting to primary %s: %s\n", socketPath, strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    FILE* in = fdopen(fd, "r");
+    char line[64];
+    long sequence;
+    if (in == NULL || fgets(line, sizeof(line), in) == NULL || sscanf(line, "S,%ld", &sequence) != 1) {
+        printf("Primary %s did not send a snapshot.\n", socketPath);
+        if (in != NULL) fclose(in); else close(fd);
+        return false;
+    }
+
+    replica = (Replica*)calloc(1, sizeof(Replica));
+    if (replica == NULL) {
+        fprintf(stderr, "Memory allocation failed for replica\n");
+        exit(EXIT_FAILURE);
+    }
+    replica->in = in;
+    replica->fd = fd;
+    replica->primaryPath = socketPath;
+    replica->applied = sequence;
+    replica->primarySequence = sequence;
+    replica->connected = true;
+    pthread_mutex_init(&replica->lock, NULL);
+    return true;
+}
+
+void* runReplicaApplier(void* arg) {
+    (void)arg;
+    BatchStats stats;
+    memset(&stats, 0, sizeof(stats));
+    char line[2048];
+    char* fields[12];
+    while (fgets(line, sizeof(line), replica->in)) {
+        long sequence;
+        long long publishedNs;
+        int offset = 0;
+        if (sscanf(line, "H,%ld,%lld", &sequence, &publishedNs) == 2) {
+            pthread_mutex_lock(&replica->lock);
+            if (sequence > replica->primarySequence) replica->primarySequence = sequence;
+            pthread_mutex_unlock(&replica->lock);
+            continue;
+        }
+        if (sscanf(line, "M,%ld,%lld,%n", &sequence, &publishedNs, &offset) != 2 || offset == 0) {
+            continue;
+        }
+        int numFields = splitBatchFields(line + offset, '\t', fields, 12);
+        for (int i = 0; i < numFields && i < 12; i++) {
+            unescapeReplicationField(fields[i]);
+        }
+        int command = findBatchCommand(fields[0]);
+        // The sale is stamped with the primary's time, so both sides report it on the same day
+        long long saleTime = 0;
+        char extra;
+        if (command == BATCH_SELL) {
+            if (numFields > 12 || sscanf(fields[numFields - 1], "%lld%c", &saleTime, &extra) != 1) command = -1;
+            numFields--;
+        }
+        pthread_rwlock_wrlock(&replicaLock);
+        saleTimeOverride = (time_t)saleTime;
+        BatchResult result = command < 0 ? BATCH_INVALID
+                                         : executeBatchCommand((BatchCommand)command, fields, numFields, &stats, NULL);
+        saleTimeOverride = 0;
+        pthread_rwlock_unlock(&replicaLock);
+
+        pthread_mutex_lock(&replica->lock);
+        replica->applied = sequence;
+        replica->appliedTimeNs = publishedNs;
+        if (sequence > replica->primarySequence) replica->primarySequence = sequence;
+        if (result != BATCH_DONE) replica->rejected++;
+        pthread_mutex_unlock(&replica->lock);
+    }
+    pthread_mutex_lock(&replica->lock);
+    replica->connected = false;
+    pthread_mutex_unlock(&replica->lock);
+    return NULL;
+}
+
+// Tells the primary the snapshot is loaded and starts replaying its log
+void replicaStart() {
+    if (!sendFully(replica->fd, "L\n", 2)) {
+        replica->connected = false;
+    }
+    if (pthread_create(&replica->thread, NULL, runReplicaApplier, NULL) != 0) {
+        fprintf(stderr, "Failed to start the replica applier\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void replicaStop() {
+    if (replica == NULL) return;
+    shutdown(replica->fd, SHUT_RDWR);
+    pthread_join(replica->thread, NULL);
+    fclose(replica->in);
+    pthread_mutex_destroy(&replica->lock);
+    free(replica);
+    replica = NULL;
+}
+
+void printReplicaStatus() {
+    pthread_mutex_lock(&replica->lock);
+    long behind = replica->primarySequence - replica->applied;
+    double lagMs = 0;
+    if (behind > 0 && replica->appliedTimeNs > 0) {
+        lagMs = (realtimeNs() - replica->appliedTimeNs) / 1e6;
+    }
+    printf("Read-only replica of %s: applied record %ld, %ld behind, lag %.1f ms", replica->primaryPath,
+           replica->applied, behind, lagMs);
+    if (replica->rejected > 0) printf(", %ld records rejected", replica->rejected);
+    if (!replica->connected) printf(" (primary disconnected)");
+    printf("\n");
+    pthread_mutex_unlock(&replica->lock);
+}
+
+// On a follower, a menu report holds replicaLock shared so the applier waits for it.
+// Only the report itself holds the lock, never a prompt waiting for input.
+void beginReplicaRead() {
+    if (replica != NULL) pthread_rwlock_rdlock(&replicaLock);
+}
+
+void endReplicaRead() {
+    if (replica != NULL) pthread_rwlock_unlock(&replicaLock);
+}
+
+// Menu options that change data are refused on a follower
+bool replicaAllows(int choice) {
+    return choice != 1 && choice != 2 && choice != 6 && choice != 26;
+}
+
+// U. Change-data capture
+CdcLog* cdcLog = NULL;
+
+// Writes text as a quoted JSON string, truncating it to fit
+void jsonString(const char* text, char* out, size_t size) {
+    size_t length = 0;
+    out[length++] = '"';
+    for (const unsigned char* c = (const unsigned char*)text; *c != '\0' && length + 8 < size; c++) {
+        if (*c == '"' || *c == '\\') {
+            out[length++] = '\\';
+            out[length++] = (char)*c;
+        } else if (*c < 0x20) {
+            length += snprintf(out + length, size - length, "\\u%04x", *c);
+        } else {
+            out[length++] = (char)*c;
+        }
+    }
+    out[length++] = '"';
+    out[length] = '\0';
+}
+
+void cdcWritePending(CdcLog* log) {
+    if (log->pending.length > 0 && !writeFully(log->fd, log->pending.data, log->pending.length)) {
+        printf("Error writing change feed %s: %s\n", log->path, strerror(errno));
+    }
+    log->pending.length = 0;
+    log->writes++;
+}
+
+// Appends one event; data is a JSON object with the record's fields after the change
+void cdcEmit(const char* table, const char* op, const char* key, const char* data) {
+    CdcLog* log = cdcLog;
+    if (log == NULL) return;
+    char quotedKey[64];
+    jsonString(key, quotedKey, sizeof(quotedKey));
+    long long timestampMs = realtimeNs() / 1000000;
+    pthread_mutex_lock(&log->lock);
+    log->sequence++;
+    log->events++;
+    replyAppendf(&log->pending, "{\"seq\":%ld,\"ts\":%lld,\"table\":\"%s\",\"op\":\"%s\",\"key\":%s,\"data\":%s}\n",
+                 log->sequence, timestampMs, table, op, quotedKey, data);
+    if (log->pending.length >= CDC_FLUSH_BYTES) {
+        cdcWritePending(log);
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+void cdcCarEvent(const char* op, int row) {
+    if (cdcLog == NULL) return;
+    char name[2 * MAX_STRING], color[2 * MAX_STRING], price[32], data[640];
+    jsonString(carName(row), name, sizeof(name));
+    jsonString(carColor(row), color, sizeof(color));
+    formatMoney(carColumns.price[row], LAKH_DIGITS, price);
+    snprintf(data, sizeof(data),
+             "{\"showroomId\":%d,\"name\":%s,\"color\":%s,\"price\":%s,\"fuelType\":%d,\"carType\":%d,\"sold\":%s}",
+             carColumns.showroomId[row], name, color, price, carColumns.fuelType[row], carColumns.carType[row],
+             carColumns.isSold[row] ? "true" : "false");
+    cdcEmit("cars", op, carColumns.VIN[row], data);
+}
+
+// Writes a customer's fields as a JSON object without the closing brace
+void customerJsonFields(const Customer* customer, char* data, size_t size) {
+    char name[2 * MAX_STRING], address[2 * MAX_STRING], down[32], loan[32], emi[32];
+    jsonString(customerName(customer), name, sizeof(name));
+    jsonString(customer->address ? customer->address : "", address, sizeof(address));
+    formatMoney(customer->downPayment, LAKH_DIGITS, down);
+    formatMoney(customer->loanAmount, LAKH_DIGITS, loan);
+    formatMoney(customer->emiAmount, RUPEE_DIGITS, emi);
+    snprintf(data, size,
+             "{\"name\":%s,\"address\":%s,\"VIN\":\"%s\",\"registrationNo\":\"%s\",\"paymentType\":%d,"
+             "\"downPayment\":%s,\"loanAmount\":%s,\"emiRupees\":%s,\"emiMonths\":%d,\"saleTime\":%lld",
+             name, address, customer->VIN, customer->registrationNo, customer->paymentType, down, loan, emi,
+             customer->emiMonths, (long long)customer->saleTime);
+}
+
+void cdcCustomerEvent(const char* op, const Customer* customer) {
+    if (cdcLog == NULL) return;
+    char data[1024];
+    customerJsonFields(customer, data, sizeof(data) - 1);
+    strcat(data, "}");
+    cdcEmit("customers", op, customer->mobileNo, data);
+}
+
+// A re-quote leaves the signed contract alone; the event adds what the loan would cost today
+void cdcLoanRequoteEvent(const Customer* customer, int rateBasisPoints, Money quotedEmi) {
+    if (cdcLog == NULL) return;
+    char data[1024], quoted[32];
+    formatMoney(quotedEmi, RUPEE_DIGITS, quoted);
+    customerJsonFields(customer, data, sizeof(data) - 64);
+    size_t length = strlen(data);
+    snprintf(data + length, sizeof(data) - length, ",\"rateBasisPoints\":%d,\"quotedEmiRupees\":%s}",
+             rateBasisPoints, quoted);
+    cdcEmit("customers", "requote", customer->mobileNo, data);
+}
+
+void cdcSalesPersonEvent(const char* op, int showroomId, const SalesPerson* person) {
+    if (cdcLog == NULL) return;
+    char key[32], name[2 * MAX_STRING], target[32], achieved[32], commission[32], data[512];
+    snprintf(key, sizeof(key), "%d/%d", showroomId, person->id);
+    jsonString(person->name, name, sizeof(name));
+    formatMoney(person->salesTarget, LAKH_DIGITS, target);
+    formatMoney(person->salesAchieved, LAKH_DIGITS, achieved);
+    formatMoney(person->commission, LAKH_DIGITS, commission);
+    snprintf(data, sizeof(data),
+             "{\"showroomId\":%d,\"id\":%d,\"name\":%s,\"salesTarget\":%s,\"salesAchieved\":%s,"
+             "\"commission\":%s,\"numSales\":%d}",
+             showroomId, person->id, name, target, achieved, commission, person->numSales);
+    cdcEmit("salespersons", op, key, data);
+}
+
+void cdcShowroomEvent(const Showroom* showroom) {
+    if (cdcLog == NULL) return;
+    char key[20], totalSales[32], data[256];
+    snprintf(key, sizeof(key), "%d", showroom->id);
+    formatMoney(showroom->totalSales, LAKH_DIGITS, totalSales);
+    snprintf(data, sizeof(data),
+             "{\"numTotalCars\":%d,\"numAvailableCars\":%d,\"numSoldCars\":%d,\"totalSales\":%s}",
+             showroom->numTotalCars, showroom->numAvailableCars, showroom->numSoldCars, totalSales);
+    cdcEmit("showrooms", "update", key, data);
+}
+
+// Writes buffered events; called at every commit, after each menu command and after
+// each update a server client sends
+void cdcFlush() {
+    CdcLog* log = cdcLog;
+    if (log == NULL) return;
+    pthread_mutex_lock(&log->lock);
+    cdcWritePending(log);
+    pthread_mutex_unlock(&log->lock);
+}
+
+// Opens the feed for appending and continues its numbering. A line cut short by a
+// crash is ended so the next event starts on a line of its own.
+bool cdcOpen(const char* path) {
+    long sequence = 0;
+    bool endLine = false;
+    FILE* fp = fopen(path, "r");
+    if (fp != NULL) {
+        char tail[4096 + 1];
+        fseek(fp, 0, SEEK_END);
+        long size = ftell(fp);
+        long from = size > 4096 ? size - 4096 : 0;
+        fseek(fp, from, SEEK_SET);
+        size_t length = fread(tail, 1, sizeof(tail) - 1, fp);
+        tail[length] = '\0';
+        fclose(fp);
+        endLine = length > 0 && tail[length - 1] != '\n';
+        for (char* event = strstr(tail, "{\"seq\":"); event != NULL; event = strstr(event + 1, "{\"seq\":")) {
+            sequence = strtol(event + 7, NULL, 10);
+        }
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC | O_APPEND, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening change feed %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    if (endLine && !writeFully(fd, "\n", 1)) {
+        fprintf(stderr, "Error writing change feed %s: %s\n", path, strerror(errno));
+    }
+    CdcLog* log = (CdcLog*)calloc(1, sizeof(CdcLog));
+    if (log == NULL) {
+        fprintf(stderr, "Memory allocation failed for change feed\n");
+        exit(EXIT_FAILURE);
+    }
+    log->fd = fd;
+    snprintf(log->path, sizeof(log->path), "%s", path);
+    pthread_mutex_init(&log->lock, NULL);
+    log->sequence = sequence;
+    cdcLog = log;
+    return true;
+}
+
+void cdcClose() {
+    CdcLog* log = cdcLog;
+    if (log == NULL) return;
+    cdcFlush();
+    cdcLog = NULL;
+    printf("Change feed: %ld events (last sequence %ld) in %ld writes to %s\n", log->events, log->sequence,
+           log->writes, log->path);
+    close(log->fd);
+    pthread_mutex_destroy(&log->lock);
+    free(log->pending.data);
+    free(log);
+}
+
+// Prints the events a consumer has not seen yet, at most maxEvents of them (0 for all),
+// and moves its offset past them. Only complete lines are consumed.
+int readChangeFeed(const char* path, const char* consumer, long maxEvents) {
+    if (consumer[0] == '\0' || strpbrk(consumer, ",\n") != NULL) {
+        fprintf(stderr, "Consumer names may not be empty or contain commas.\n");
+        return EXIT_FAILURE;
+    }
+    char offsetsPath[300];
+    snprintf(offsetsPath, sizeof(offsetsPath), "%s.offsets", path);
+
+    // Offsets file: consumer,sequence,byteOffset per line
+    char names[MAX_CDC_CONSUMERS][MAX_STRING];
+    long sequences[MAX_CDC_CONSUMERS], offsets[MAX_CDC_CONSUMERS];
+    int numConsumers = 0, self = -1;
+    FILE* fp = fopen(offsetsPath, "r");
+    if (fp != NULL) {
+        char line[MAX_STRING + 64];
+        while (numConsumers < MAX_CDC_CONSUMERS && fgets(line, sizeof(line), fp)) {
+            if (sscanf(line, "%99[^,],%ld,%ld", names[numConsumers], &sequences[numConsumers],
+                       &offsets[numConsumers]) == 3) {
+                numConsumers++;
+            }
+        }
+        fclose(fp);
+    }
+    for (int i = 0; i < numConsumers; i++) {
+        if (strcmp(names[i], consumer) == 0) self = i;
+    }
+    if (self < 0) {
+        if (numConsumers == MAX_CDC_CONSUMERS) {
+            fprintf(stderr, "Too many consumers in %s.\n", offsetsPath);
+            return EXIT_FAILURE;
+        }
+        self = numConsumers++;
+        snprintf(names[self], MAX_STRING, "%s", consumer);
+        sequences[self] = 0;
+        offsets[self] = 0;
+    }
+
+    FILE* feed = fopen(path, "r");
+    if (feed == NULL) {
+        fprintf(stderr, "Error opening change feed %s: %s\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if (fseek(feed, offsets[self], SEEK_SET) != 0) {
+        fprintf(stderr, "Offset %ld is past the end of %s.\n", offsets[self], path);
+        fclose(feed);
+        return EXIT_FAILURE;
+    }
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    long consumed = 0;
+    while ((maxEvents == 0 || consumed < maxEvents) && (length = getline(&line, &capacity, feed)) > 0) {
+        if (line[length - 1] != '\n') break;       // Still being written
+        offsets[self] += length;
+        if (strncmp(line, "{\"seq\":", 7) != 0 || length < 3 || line[length - 2] != '}') {
+            continue;                                // Cut short by a crash
+        }
+        sequences[self] = strtol(line + 7, NULL, 10);
+        fputs(line, stdout);
+        consumed++;
+    }
+    free(line);
+    fclose(feed);
+
+    IoFile file;
+    fp = ioOpen(&file, offsetsPath, "w");
+    if (!fp) {
+        fprintf(stderr, "Error opening %s for writing.\n", offsetsPath);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < numConsumers; i++) {
+        fprintf(fp, "%s,%ld,%ld\n", names[i], sequences[i], offsets[i]);
+    }
+    ioClose(&file);
+    fprintf(stderr, "Consumer %s read %ld events and is at sequence %ld.\n", consumer, consumed, sequences[self]);
+    return EXIT_SUCCESS;
+}
+
+// V. Synthetic data and benchmarks
+#define BENCHMARK_REPORT_RUNS 5
+
+uint64_t monotonicNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// xorshift64*: cheap, and the same seed always generates the same dataset
+uint64_t nextRandom(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+// Spreads consecutive numbers over 8 digits so keys do not arrive in sorted order.
+// The multiplier is coprime to 10^8, so no two numbers below 10^8 collide.
+unsigned long long scatterKey(long i) {
+    return (unsigned long long)i * 2654435761ULL % 100000000ULL;
+}
+
+// Fills the empty trees with numCars cars, one salesperson per thousand cars (at least
+// ten per showroom), and sells 40% of the cars over the past year, 60% of them on loan
+void generateDataset(long numCars, uint64_t seed) {
+    static const char* vinPrefixes[MAX_SHOWROOMS] = {"MS", "HY", "TM"};
+    static const char* models[MAX_SHOWROOMS][6] = {
+        {"Swift", "Baleno", "Dzire", "Ciaz", "Brezza", "Grand Vitara"},
+        {"Grand i10", "i20", "Aura", "Verna", "Creta", "Tucson"},
+        {"Tiago", "Altroz", "Tigor", "Punch", "Nexon", "Harrier"}};
+    static const CarType modelTypes[6] = {HATCHBACK, HATCHBACK, SEDAN, SEDAN, SUV, SUV};
+    static const int basePrices[MAX_SHOWROOMS][6] = {   // Thousands of rupees
+        {650, 700, 720, 950, 1000, 1300}, {600, 800, 700, 1200, 1300, 3000}, {550, 700, 650, 650, 900, 1700}};
+    static const char* colors[] = {"White", "Black", "Silver", "Red", "Blue", "Grey"};
+    static const char* firstNames[] = {"Aarav", "Vivaan", "Aditya", "Ishaan", "Rohan", "Kabir", "Arjun", "Sai",
+                                       "Ananya", "Diya", "Asha", "Meera", "Priya", "Kavya", "Neha", "Riya"};
+    static const char* lastNames[] = {"Sharma", "Verma", "Patel", "Reddy", "Nair", "Iyer", "Gupta", "Singh",
+                                      "Kulkarni", "Joshi", "Mehta", "Rao", "Das", "Khan", "Bose", "Pillai"};
+    static const char* cities[] = {"Pune", "Mumbai", "Delhi", "Bengaluru", "Chennai", "Hyderabad", "Kolkata",
+                                   "Ahmedabad"};
+    static const int emiMonths[] = {36, 60, 84};
+    if (numCars > 99999999) numCars = 99999999;
+
+    uint64_t state = seed != 0 ? seed : 1;
+    uint64_t start = monotonicNs();
+    batchMode = true;
+    time_t now = time(NULL);
+    char name[MAX_STRING];
+
+    int perShowroom = (int)(numCars / (1000 * MAX_SHOWROOMS));
+    if (perShowroom < 10) perShowroom = 10;
+    for (int s = 0; s < MAX_SHOWROOMS; s++) {
+        for (int i = 0; i < perShowroom; i++) {
+            SalesPerson person;
+            person.id = 101 + i;
+            snprintf(person.name, sizeof(person.name), "%s %s", firstNames[nextRandom(&state) % 16],
+                     lastNames[nextRandom(&state) % 16]);
+            addSalesPerson(s + 1, &person);
+        }
+    }
+
+    long sales = 0, loans = 0;
+    for (long i = 0; i < numCars; i++) {
+        int s = (int)(nextRandom(&state) % MAX_SHOWROOMS);
+        int model = (int)(nextRandom(&state) % 6);
+        Car car;
+        snprintf(car.VIN, sizeof(car.VIN), "%s%08llu", vinPrefixes[s], scatterKey(i));
+        car.nameId = internString(models[s][model]);
+        car.colorId = internString(colors[nextRandom(&state) % 6]);
+        long thousands = basePrices[s][model] * (90 + (long)(nextRandom(&state) % 31)) / 100;
+        car.price = (Money)thousands * 1000 * PAISE_PER_RUPEE;
+        int fuel = (int)(nextRandom(&state) % 20);  // Petrol 50%, diesel 20%, CNG 15%, electric 10%, hybrid 5%
+        car.fuelType = fuel < 10 ? PETROL : fuel < 14 ? DIESEL : fuel < 17 ? CNG : fuel < 19 ? ELECTRIC : HYBRID;
+        car.carType = modelTypes[model];
+        if (!addCar(s + 1, &car) || nextRandom(&state) % 10 >= 4) {
+            continue;
+        }
+
+        Customer customer;
+        memset(&customer, 0, sizeof(customer));
+        snprintf(name, sizeof(name), "%s %s", firstNames[nextRandom(&state) % 16], lastNames[nextRandom(&state) % 16]);
+        customer.name = arenaStrdup(&stringArena, name);
+        snprintf(customer.mobileNo, sizeof(customer.mobileNo), "7%09ld", sales % 1000000000);
+        customer.address = arenaStrdup(&stringArena, cities[nextRandom(&state) % 8]);
+        snprintf(customer.registrationNo, sizeof(customer.registrationNo), "MH%02dX%06ld", (int)(sales % 50) + 1,
+                 sales % 1000000);
+        customer.paymentType = nextRandom(&state) % 10 < 6 ? LOAN : CASH;
+        if (customer.paymentType == LOAN) {
+            customer.downPayment = car.price * (20 + (Money)(nextRandom(&state) % 31)) / 100;
+            customer.emiMonths = emiMonths[nextRandom(&state) % 3];
+        }
+        char salesPersonId[50];
+        snprintf(salesPersonId, sizeof(salesPersonId), "%d_%d", s + 1, 101 + (int)(nextRandom(&state) % perShowroom));
+        saleTimeOverride = now - (time_t)(nextRandom(&state) % (365 * SECONDS_PER_DAY));
+        if (sellCar(salesPersonId, car.VIN, &customer)) {
+            sales++;
+            if (customer.paymentType == LOAN) loans++;
+        }
+    }
+    saleTimeOverride = 0;
+
+    BatchStats stats;
+    memset(&stats, 0, sizeof(stats));
+    commitBatch(&stats);
+    ioFlush();
+    printf("Generated %ld cars, %d salespersons and %ld sales (%ld on loan) in %.3f ms\n", numCars,
+           perShowroom * MAX_SHOWROOMS, sales, loans, (monotonicNs() - start) / 1e6);
+}
+
+// One CSV row: operation,count,total_ms,ops_per_sec,p50_us,p99_us. Sorts samples.
+void benchReport(FILE* out, const char* operation, uint64_t* samples, long count, uint64_t totalNs) {
+    qsort(samples, count, sizeof(uint64_t), compareLatencies);
+    fprintf(out, "%s,%ld,%.3f,%.0f,%.2f,%.2f\n", operation, count, totalNs / 1e6,
+            totalNs > 0 ? count / (totalNs / 1e9) : 0.0, samples[count / 2] / 1000.0,
+            samples[count * 99 / 100] / 1000.0);
+}
+
+void benchOnce(FILE* out, const char* operation, uint64_t startNs) {
+    uint64_t elapsed = monotonicNs() - startNs;
+    benchReport(out, operation, &elapsed, 1, elapsed);
+}
+
+// Times the loaders on the data files in the working directory, then the core tree and
+// business operations. Results go to stdout as CSV; what the operations print is discarded.
+int runBenchmark(long operations) {
+    if (operations < 1) operations = 1;
+    if (operations > 99999999) operations = 99999999;
+    fflush(stdout);
+    FILE* out = fdopen(dup(STDOUT_FILENO), "w");
+    int devNull = open("/dev/null", O_WRONLY);
+    if (out == NULL || devNull < 0) {
+        fprintf(stderr, "Failed to redirect benchmark output\n");
+        return EXIT_FAILURE;
+    }
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+    batchMode = true;
+    uint64_t* samples = (uint64_t*)malloc(operations * sizeof(uint64_t));
+    char (*keys)[20] = malloc(operations * sizeof(*keys));
+    if (samples == NULL || keys == NULL) {
+        fprintf(stderr, "Memory allocation failed for benchmark\n");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(out, "operation,count,total_ms,ops_per_sec,p50_us,p99_us\n");
+
+    uint64_t start = monotonicNs();
+    loadShowroomsFromFile();
+    benchOnce(out, "loadShowroomsFromFile", start);
+    start = monotonicNs();
+    loadCarsFromFile();
+    benchOnce(out, "loadCarsFromFile", start);
+    start = monotonicNs();
+    loadSalesPersonsFromFile();
+    benchOnce(out, "loadSalesPersonsFromFile", start);
+    start = monotonicNs();
+    loadCustomersFromFile();
+    benchOnce(out, "loadCustomersFromFile", start);
+    start = monotonicNs();
+    loadSalesRollupsFromFile();
+    benchOnce(out, "loadSalesRollupsFromFile", start);
+    start = monotonicNs();
+    if (!loadSalesLogFromFile()) {
+        backfillSalesLogFromCustomers();
+    }
+    benchOnce(out, "loadSalesLogFromFile", start);
+    fflush(out);
+
+    // Raw tree operations on a tree of their own
+    BPlusTree* tree = createBPlusTree(1);
+    for (long i = 0; i < operations; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "BK%08llu", scatterKey(i));
+    }
+    uint64_t total = 0;
+    for (long i = 0; i < operations; i++) {
+        uint64_t t = monotonicNs();
+        insertIntoBPlusTree(tree, keys[i], keys[i]);
+        samples[i] = monotonicNs() - t;
+        total += samples[i];
+    }
+    benchReport(out, "insertIntoBPlusTree", samples, operations, total);
+    total = 0;
+    for (long i = 0; i < operations; i++) {
+        char* key = keys[scatterKey(i) % operations];
+        uint64_t t = monotonicNs();
+        searchInBPlusTree(tree, key);
+        samples[i] = monotonicNs() - t;
+        total += samples[i];
+    }
+    benchReport(out, "searchInBPlusTree", samples, operations, total);
+    total = 0;
+    for (long i = 0; i < operations; i++) {
+        char missing[20];
+        snprintf(missing, sizeof(missing), "BK%08llu-", scatterKey(i));  // Falls between two keys
+        uint64_t t = monotonicNs();
+        searchInBPlusTree(tree, missing);
+        samples[i] = monotonicNs() - t;
+        total += samples[i];
+    }
+    benchReport(out, "searchInBPlusTree-miss", samples, operations, total);
+    total = 0;
+    for (long i = 0; i < operations; i++) {
+        uint64_t t = monotonicNs();
+        deleteFromBPlusTree(tree, keys[i]);
+        samples[i] = monotonicNs() - t;
+        total += samples[i];
+    }
+    benchReport(out, "deleteFromBPlusTree", samples, operations, total);
+    free(tree->root);
+    free(tree);
+    fflush(out);
+
+    // Business operations: add new cars, then sell them through the first salesperson
+    // of each showroom
+    SalesPerson* sellers[MAX_SHOWROOMS] = {NULL};
+    for (int s = 0; s < MAX_SHOWROOMS; s++) {
+        BPlusTreeNode* leaf = salesPersonTrees[s] != NULL ? findLeafForKey(salesPersonTrees[s], "") : NULL;
+        if (leaf != NULL && leaf->numKeys > 0) {
+            sellers[s] = (SalesPerson*)leaf->data[0];
+        }
+    }
+    total = 0;
+    for (long i = 0; i < operations; i++) {
+        Car car;
+        snprintf(keys[i], sizeof(keys[i]), "BN%08llu", scatterKey(i));
+        snprintf(car.VIN, sizeof(car.VIN), "%s", keys[i]);
+        car.nameId = internString("Bench");
+        car.colorId = internString("White");
+        car.price = (Money)(500 + i % 1000) * 1000 * PAISE_PER_RUPEE;
+        car.fuelType = (FuelType)(i % 5);
+        car.carType = (CarType)(i % 3);
+        uint64_t t = monotonicNs();
+        addCar((int)(i % MAX_SHOWROOMS) + 1, &car);
+        samples[i] = monotonicNs() - t;
+        total += samples[i];
+    }
+    benchReport(out, "addCar", samples, operations, total);
+    long sold = 0;
+    total = 0;
+    for (long i = 0; i < operations; i++) {
+        int s = (int)(i % MAX_SHOWROOMS);
+        if (sellers[s] == NULL) continue;
+        Customer customer;
+        memset(&customer, 0, sizeof(customer));
+        customer.name = "Bench Customer";
+        snprintf(customer.mobileNo, sizeof(customer.mobileNo), "6%09ld", i % 1000000000);
+        customer.address = "Pune";
+        snprintf(customer.registrationNo, sizeof(customer.registrationNo), "BN%08ld", i);
+        customer.paymentType = i % 10 < 6 ? LOAN : CASH;
+        customer.downPayment = (Money)(200 + i % 400) * 1000 * PAISE_PER_RUPEE;
+        customer.emiMonths = 60;
+        char salesPersonId[50];
+        snprintf(salesPersonId, sizeof(salesPersonId), "%d_%d", s + 1, sellers[s]->id);
+        uint64_t t = monotonicNs();
+        sellCar(salesPersonId, keys[i], &customer);
+        samples[sold] = monotonicNs() - t;
+        total += samples[sold++];
+    }
+    if (sold > 0) {
+        benchReport(out, "sellCar", samples, sold, total);
+    }
+    fflush(out);
+
+    // Reports, each run a few times over the whole dataset
+    time_t now = time(NULL);
+    CarQuery query = {.showroomId = 0, .fuelType = -1, .carType = SUV, .minPrice = 5 * PAISE_PER_LAKH,
+                      .maxPrice = 15 * PAISE_PER_LAKH, .includeSold = false};
+    for (int report = 0; report < 12; report++) {
+        static const char* names[] = {"findMostPopularCar", "findMostSuccessfulSalesPerson",
+                                      "predictNextMonthSales", "printCustomersWithEMIInRange",
+                                      "searchSalesPersonByRange", "displayAllCarsShowroomWise",
+                                      "displayCarSearchResults", "displayNameSearchResults",
+                                      "displayRecentSales", "displaySalesBetweenDates", "displayNetworkForecast",
+                                      "displayInventoryAnalytics"};
+        total = 0;
+        for (int run = 0; run < BENCHMARK_REPORT_RUNS; run++) {
+            uint64_t t = monotonicNs();
+            switch (report) {
+                case 0: findMostPopularCar(); break;
+                case 1: findMostSuccessfulSalesPerson(); break;
+                case 2: predictNextMonthSales(1); break;
+                case 3: printCustomersWithEMIInRange(); break;
+                case 4: searchSalesPersonByRange(salesPersonTrees[0], 0, 100 * PAISE_PER_LAKH); break;
+                case 5: displayAllCarsShowroomWise(); break;
+                case 6: displayCarSearchResults(&query); break;
+                case 7: displayNameSearchResults("Swi", false); break;
+                case 8: displayRecentSales(30); break;
+                case 9: displaySalesBetweenDates(now - 90 * SECONDS_PER_DAY, now); break;
+                case 10: displayNetworkForecast(); break;
+                case 11: displayInventoryAnalytics(); break;
+            }
+            fflush(stdout);
+            samples[run] = monotonicNs() - t;
+            total += samples[run];
+        }
+        benchReport(out, names[report], samples, BENCHMARK_REPORT_RUNS, total);
+    }
+
+    free(samples);
+    free(keys);
+    fclose(out);
+    return EXIT_SUCCESS;
+}
+
+// W. Operation metrics
+const char* counterNames[NUM_COUNTERS] = {"node visits", "key comparisons", "splits", "merges", "borrows"};
+const char* timerNames[NUM_TIMERS] = {
+    "sellCar", "addCar", "loadShowroomsFromFile", "loadCarsFromFile", "loadSalesPersonsFromFile",
+    "loadCustomersFromFile", "loadSalesRollupsFromFile", "loadSalesLogFromFile", "saveAllToFiles",
+    "saveShowroomsToFile", "saveCarsToFile", "saveSalesPersonsToFile", "saveCustomersToFile",
+    "saveSalesRollupsToFile"};
+
+// Totals over every thread that has recorded anything
+typedef struct {
+    int threads;
+    uint64_t counters[NUM_COUNTERS];
+    uint64_t calls[NUM_TIMERS];
+    uint64_t totalNs[NUM_TIMERS];
+    uint64_t maxNs[NUM_TIMERS];
+    uint64_t buckets[NUM_TIMERS][METRIC_BUCKETS];
+} MetricsTotals;
+
+#ifndef NO_METRICS
+ThreadMetrics* allThreadMetrics = NULL;
+pthread_mutex_t threadMetricsLock = PTHREAD_MUTEX_INITIALIZER;
+_Thread_local ThreadMetrics* threadMetrics = NULL;
+
+ThreadMetrics* metricsForThread() {
+    if (threadMetrics == NULL) {
+        ThreadMetrics* metrics = (ThreadMetrics*)calloc(1, sizeof(ThreadMetrics));
+        if (metrics == NULL) {
+            fprintf(stderr, "Memory allocation failed for thread metrics\n");
+            exit(EXIT_FAILURE);
+        }
+        // Blocks outlive their threads so the totals keep what finished workers recorded
+        pthread_mutex_lock(&threadMetricsLock);
+        metrics->next = allThreadMetrics;
+        allThreadMetrics = metrics;
+        pthread_mutex_unlock(&threadMetricsLock);
+        threadMetrics = metrics;
+    }
+    return threadMetrics;
+}
+
+// Only the owning thread writes its block, so a relaxed load and store is enough
+void metricAdd(_Atomic uint64_t* value, uint64_t n) {
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+void metricsCount(Counter counter, uint64_t n) {
+    metricAdd(&metricsForThread()->counters[counter], n);
+}
+
+void metricsStopTimer(ScopeTimer* scope) {
+    uint64_t elapsed = monotonicNs() - scope->startNs;
+    ThreadMetrics* metrics = metricsForThread();
+    int bucket = elapsed == 0 ? 0 : 64 - __builtin_clzll(elapsed);
+    if (bucket >= METRIC_BUCKETS) bucket = METRIC_BUCKETS - 1;
+    metricAdd(&metrics->calls[scope->timer], 1);
+    metricAdd(&metrics->totalNs[scope->timer], elapsed);
+    metricAdd(&metrics->buckets[scope->timer][bucket], 1);
+    if (elapsed > atomic_load_explicit(&metrics->maxNs[scope->timer], memory_order_relaxed)) {
+        atomic_store_explicit(&metrics->maxNs[scope->timer], elapsed, memory_order_relaxed);
+    }
+}
+#endif
+
+// Returns false when the metrics were compiled out
+bool collectMetrics(MetricsTotals* totals) {
+    memset(totals, 0, sizeof(MetricsTotals));
+#ifdef NO_METRICS
+    return false;
+#else
+    pthread_mutex_lock(&threadMetricsLock);
+    for (ThreadMetrics* metrics = allThreadMetrics; metrics != NULL; metrics = metrics->next) {
+        totals->threads++;
+        for (int c = 0; c < NUM_COUNTERS; c++) {
+            totals->counters[c] += atomic_load_explicit(&metrics->counters[c], memory_order_relaxed);
+        }
+        for (int t = 0; t < NUM_TIMERS; t++) {
+            totals->calls[t] += atomic_load_explicit(&metrics->calls[t], memory_order_relaxed);
+            totals->totalNs[t] += atomic_load_explicit(&metrics->totalNs[t], memory_order_relaxed);
+            uint64_t maxNs = atomic_load_explicit(&metrics->maxNs[t], memory_order_relaxed);
+            if (maxNs > totals->maxNs[t]) totals->maxNs[t] = maxNs;
+            for (int b = 0; b < METRIC_BUCKETS; b++) {
+                totals->buckets[t][b] += atomic_load_explicit(&metrics->buckets[t][b], memory_order_relaxed);
+            }
+        }
+    }
+    pthread_mutex_unlock(&threadMetricsLock);
+    return true;
+#endif
+}
+
+// Upper bound in ns of the bucket holding the given fraction of a timer's calls
+uint64_t metricsPercentileNs(const MetricsTotals* totals, int timer, double fraction) {
+    uint64_t rank = (uint64_t)ceil(totals->calls[timer] * fraction), seen = 0;
+    for (int b = 0; b < METRIC_BUCKETS; b++) {
+        seen += totals->buckets[timer][b];
+        if (seen >= rank && seen > 0) {
+            uint64_t bound = 1ULL << b;
+            return b == METRIC_BUCKETS - 1 || bound > totals->maxNs[timer] ? totals->maxNs[timer] : bound;
+        }
+    }
+    return totals->maxNs[timer];
+}
+
+void formatDuration(uint64_t ns, char* buffer, size_t size) {
+    if (ns < 1000) {
+        snprintf(buffer, size, "%lluns", (unsigned long long)ns);
+    } else if (ns < 1000000) {
+        snprintf(buffer, size, "%.1fus", ns / 1e3);
+    } else if (ns < 1000000000) {
+        snprintf(buffer, size, "%.1fms", ns / 1e6);
+    } else {
+        snprintf(buffer, size, "%.1fs", ns / 1e9);
+    }
+}
+
+void displayMetrics() {
+    MetricsTotals totals;
+    if (!collectMetrics(&totals)) {
+        printf("\nOperation metrics were compiled out (built with -DNO_METRICS).\n");
+        return;
+    }
+    printf("\n=== Operation Metrics (%d threads) ===\n", totals.threads);
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        printf("%-18s%llu\n", counterNames[c], (unsigned long long)totals.counters[c]);
+    }
+    printf("\n%-26s%-10s%-12s%-11s%-11s%-11s%s\n", "Operation", "Calls", "Total ms", "Mean us", "p50 us <=",
+           "p99 us <=", "Max us");
+    printf("-------------------------------------------------------------------------------------------\n");
+    for (int t = 0; t < NUM_TIMERS; t++) {
+        if (totals.calls[t] == 0) continue;
+        printf("%-26s%-10llu%-12.3f%-11.2f%-11.2f%-11.2f%.2f\n", timerNames[t], (unsigned long long)totals.calls[t],
+               totals.totalNs[t] / 1e6, totals.totalNs[t] / 1e3 / totals.calls[t],
+               metricsPercentileNs(&totals, t, 0.5) / 1e3, metricsPercentileNs(&totals, t, 0.99) / 1e3,
+               totals.maxNs[t] / 1e3);
+        printf("  Latency:");
+        for (int b = 0; b < METRIC_BUCKETS; b++) {
+            if (totals.buckets[t][b] == 0) continue;
+            char bound[16];
+            formatDuration(1ULL << b, bound, sizeof(bound));
+            printf(" <%s:%llu", bound, (unsigned long long)totals.buckets[t][b]);
+        }
+        printf("\n");
+    }
+    printf("Save times cover formatting the files; the background writer does the disk writes.\n");
+}
+
+// Records: counter,name,value and timer,name,calls,totalNs,maxNs,buckets where buckets
+// lists upperBoundNs:count pairs separated by spaces
+void replyMetrics(ReplyBuffer* reply) {
+    MetricsTotals totals;
+    if (!collectMetrics(&totals)) return;
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        replyAppendf(reply, "counter,%s,%llu\n", counterNames[c], (unsigned long long)totals.counters[c]);
+        reply->records++;
+    }
+    for (int t = 0; t < NUM_TIMERS; t++) {
+        replyAppendf(reply, "timer,%s,%llu,%llu,%llu,", timerNames[t], (unsigned long long)totals.calls[t],
+                     (unsigned long long)totals.totalNs[t], (unsigned long long)totals.maxNs[t]);
+        const char* separator = "";
+        for (int b = 0; b < METRIC_BUCKETS; b++) {
+            if (totals.buckets[t][b] == 0) continue;
+            replyAppendf(reply, "%s%llu:%llu", separator, 1ULL << b, (unsigned long long)totals.buckets[t][b]);
+            separator = " ";
+        }
+        replyAppendf(reply, "\n");
+        reply->records++;
+    }
 }
 
-// New functions
-void displayAllCarsShowroomWise() {
-    printf("\n=== Cars Organized by Showroom ===\n");
-    for (int i = 1; i <= MAX_SHOWROOMS; i++) {
-        char showroomIdStr[20];
-        sprintf(showroomIdStr, "%d", i);
-        Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
-        
-        if (showroom == NULL) {
-            printf("Showroom %d not found.\n", i);
-            continue;
+// X. Tree self-check
+// --self-check runs random operation rounds against a scratch tree and a shadow copy of
+// its contents, and checks the tree's invariants after every round. It runs once with
+// eager deletes and once with lazy ones, where rounds also revive and compact.
+#define SELF_CHECK_KEYS 4096
+#define SELF_CHECK_BATCH 256
+
+typedef struct {
+    BPlusTree* tree;
+    char (*keys)[20];          // Key pool in ascending order; slot i stores (void*)(i + 1)
+    bool* present;             // Shadow contents
+    bool* available;
+    uint64_t random;
+    const char* step;          // Operation the round ran, for failure messages
+    int errors;
+    // Walk state for checkSelfCheckNode
+    int leafDepth;
+    const char* previousKey;
+    BPlusTreeNode* nextLeaf;
+    int liveKeys, deadKeys, availableKeys;
+} SelfCheck;
+
+void selfCheckFail(SelfCheck* check, const char* what, const char* key) {
+    if (check->errors++ < 10) {
+        fprintf(stderr, "self-check: %s%s%s after %s\n", what, key ? " at key " : "", key ? key : "", check->step);
+    }
+}
+
+// Checks the subtree against the separator bounds (low, high] handed down by its parent
+void checkSelfCheckNode(SelfCheck* check, BPlusTreeNode* node, int depth, const char* low, const char* high,
+                        bool isRoot) {
+    if (node->numKeys < 0 || node->numKeys > B_PLUS_ORDER - 1) {
+        selfCheckFail(check, "numKeys out of range", NULL);
+        return;
+    }
+    if (!isRoot && !check->tree->lazyDeletes && node->numKeys == 0) {
+        selfCheckFail(check, "empty node", NULL);
+    }
+    for (int i = 0; i < node->numKeys; i++) {
+        if (i > 0 && strcmp(node->keys[i - 1], node->keys[i]) >= 0) {
+            selfCheckFail(check, "keys out of order", node->keys[i]);
         }
-        
-        printf("\nShowroom %d: %s (%s)\n", showroom->id, showroom->name, showroom->manufacturer);
-        printf("----------------------------------------\n");
-        printf("VIN\t\tName\t\tColor\tPrice\tStatus\n");
-        printf("----------------------------------------\n");
-        
-        int carCount = 0;
-        BPlusTreeNode* current = carTree->root;
-        while (current && !current->isLeaf) current = current->children[0];
-        
-        while (current != NULL) {
-            for (int j = 0; j < current->numKeys; j++) {
-                Car* car = (Car*)current->data[j];
-                if (car->showroomId == i) {
-                    printf("%-16s%-16s%-8s%-8.2f%s\n",
-                           car->VIN, car->name, car->color, car->price,
-                           car->isSold ? "Sold" : "Available");
-                    carCount++;
-                }
+        if ((low != NULL && strcmp(node->keys[i], low) <= 0) || (high != NULL && strcmp(node->keys[i], high) > 0)) {
+            selfCheckFail(check, "key outside its parent's bounds", node->keys[i]);
+        }
+    }
+    if (!node->isLeaf) {
+        if (node->numKeys == 0) {
+            selfCheckFail(check, "inner node without keys", NULL);
+        }
+        int availableCount = 0;
+        for (int i = 0; i <= node->numKeys; i++) {
+            if (node->children[i] == NULL) {
+                selfCheckFail(check, "missing child", NULL);
+                continue;
             }
-            current = current->next;
+            checkSelfCheckNode(check, node->children[i], depth + 1, i > 0 ? node->keys[i - 1] : low,
+                               i < node->numKeys ? node->keys[i] : high, false);
+            availableCount += node->children[i]->availableCount;
         }
-        
-        if (carCount == 0) {
-            printf("No cars found in this showroom.\n");
+        if (availableCount != node->availableCount) {
+            selfCheckFail(check, "inner availableCount differs from its children's sum", NULL);
         }
-        printf("Total cars: %d\n", carCount);
+        return;
     }
-}
 
-/*void displayAllSalesPersonsShowroomWise() {
-    printf("\n=== Salespersons Organized by Showroom ===\n");
-    for (int i = 0; i < MAX_SHOWROOMS; i++) {
-        char showroomIdStr[20];
-        sprintf(showroomIdStr, "%d", i + 1);
-        Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
-        
-        if (showroom == NULL || salesPersonTrees[i] == NULL) {
-            printf("Showroom %d not found or not initialized.\n", i + 1);
+    if (check->leafDepth < 0) {
+        check->leafDepth = depth;
+    } else if (check->leafDepth != depth) {
+        selfCheckFail(check, "leaves at different depths", NULL);
+    }
+    if (check->nextLeaf != NULL && check->nextLeaf != node) {
+        selfCheckFail(check, "leaf chain skips a leaf", NULL);
+    }
+    check->nextLeaf = node->next;
+    uint8_t slots = (uint8_t)((1u << node->numKeys) - 1);
+    if ((node->availableMask & ~slots) || (node->tombstoneMask & ~slots) ||
+        (node->availableMask & node->tombstoneMask)) {
+        selfCheckFail(check, "status bits on empty or dead slots", NULL);
+    }
+    if (node->availableCount != countBits(node->availableMask)) {
+        selfCheckFail(check, "leaf availableCount differs from its status bits", NULL);
+    }
+    for (int i = 0; i < node->numKeys; i++) {
+        if (check->previousKey != NULL && strcmp(check->previousKey, node->keys[i]) >= 0) {
+            selfCheckFail(check, "leaf chain out of order", node->keys[i]);
+        }
+        check->previousKey = node->keys[i];
+        if ((node->tombstoneMask >> i) & 1u) {
+            check->deadKeys++;
             continue;
         }
-        
-        printf("\nShowroom %d: %s\n", i + 1, showroom->name);
-        printf("----------------------------------------\n");
-        printf("ID\tName\t\tSales Achieved\tCommission\n");
-        printf("----------------------------------------\n");
-        
-        int personCount = 0;
-        BPlusTreeNode* current = salesPersonTrees[i]->root;
-        while (current && !current->isLeaf) current = current->children[0];
-        
-        while (current != NULL) {
-            for (int j = 0; j < current->numKeys; j++) {
-                SalesPerson* person = (SalesPerson*)current->data[j];
-                printf("%-8d%-16s%-16.2f%.2f\n",
-                       person->id, person->name, person->salesAchieved, Ascending(person->commission));
-                personCount++;
-            }
-            current = current->next;
+        check->liveKeys++;
+        int slot = (int)(intptr_t)node->data[i] - 1;
+        if (slot < 0 || slot >= SELF_CHECK_KEYS || strcmp(check->keys[slot], node->keys[i]) != 0) {
+            selfCheckFail(check, "wrong data for key", node->keys[i]);
+            continue;
         }
-        
-        if (personCount == 0) {
-            printf("No salespersons found in this showroom.\n");
+        bool available = (node->availableMask >> i) & 1u;
+        check->availableKeys += available ? 1 : 0;
+        if (!check->present[slot]) {
+            selfCheckFail(check, "deleted key still live", node->keys[i]);
+        } else if (available != check->available[slot]) {
+            selfCheckFail(check, "wrong status bit", node->keys[i]);
         }
-        printf("Total salespersons: %d\n", personCount);
     }
-}*/
-void displayAllSalesPersonsShowroomWise() {
-    printf("\n=== Salespersons Organized by Showroom ===\n");
-    for (int i = 0; i < MAX_SHOWROOMS; i++) {
-        char showroomIdStr[20];
-        sprintf(showroomIdStr, "%d", i + 1);
-        Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
-        
-        if (showroom == NULL || salesPersonTrees[i] == NULL) {
-            printf("Showroom %d not found or not initialized.\n", i + 1);
-            continue;
+}
+
+void validateSelfCheckTree(SelfCheck* check) {
+    check->leafDepth = -1;
+    check->previousKey = NULL;
+    check->nextLeaf = NULL;
+    check->liveKeys = check->deadKeys = check->availableKeys = 0;
+    if (check->tree->root != NULL) {
+        checkSelfCheckNode(check, check->tree->root, 0, NULL, NULL, true);
+    }
+    if (check->nextLeaf != NULL) {
+        selfCheckFail(check, "leaf chain runs past the last leaf", NULL);
+    }
+    int present = 0, available = 0;
+    for (int i = 0; i < SELF_CHECK_KEYS; i++) {
+        present += check->present[i] ? 1 : 0;
+        available += check->present[i] && check->available[i] ? 1 : 0;
+    }
+    if (check->liveKeys != present || check->tree->numKeys != present) {
+        selfCheckFail(check, "live key count differs from the shadow copy", NULL);
+    }
+    if (check->availableKeys != available) {
+        selfCheckFail(check, "available key count differs from the shadow copy", NULL);
+    }
+    if (check->tree->lazyDeletes && check->deadKeys != check->tree->tombstones) {
+        selfCheckFail(check, "tombstone count differs from the dead slots", NULL);
+    }
+}
+
+int selfCheckPick(SelfCheck* check, bool present) {
+    for (int attempt = 0; attempt < 64; attempt++) {
+        int slot = (int)(nextRandom(&check->random) % SELF_CHECK_KEYS);
+        if (check->present[slot] == present) return slot;
+    }
+    return -1;
+}
+
+void selfCheckBatchInsert(SelfCheck* check) {
+    BatchEntry entries[SELF_CHECK_BATCH];
+    int n = 0, want = (int)(nextRandom(&check->random) % SELF_CHECK_BATCH);
+    for (int i = 0; i < want; i++) {
+        int slot = selfCheckPick(check, false);
+        if (slot < 0) break;
+        check->present[slot] = true;
+        check->available[slot] = nextRandom(&check->random) & 1;
+        entries[n].key = check->keys[slot];
+        entries[n].data = (void*)(intptr_t)(slot + 1);
+        entries[n].available = check->available[slot];
+        n++;
+    }
+    batchInsertIntoBPlusTree(check->tree, entries, n);
+}
+
+void selfCheckBatchDelete(SelfCheck* check) {
+    const char* keys[SELF_CHECK_BATCH];
+    int n = 0, want = (int)(nextRandom(&check->random) % SELF_CHECK_BATCH);
+    for (int i = 0; i < want; i++) {
+        int slot = selfCheckPick(check, true);
+        if (slot < 0) break;
+        check->present[slot] = false;
+        keys[n++] = check->keys[slot];
+    }
+    if (batchDeleteFromBPlusTree(check->tree, keys, n) != n) {
+        selfCheckFail(check, "batch delete missed keys", NULL);
+    }
+}
+
+void selfCheckInsert(SelfCheck* check, int slot, bool available) {
+    check->present[slot] = true;
+    check->available[slot] = available;
+    insertWithStatus(check->tree, check->keys[slot], (void*)(intptr_t)(slot + 1), available);
+}
+
+// Toggles random keys one call at a time
+void selfCheckSingleOps(SelfCheck* check) {
+    for (int i = 0; i < 64; i++) {
+        int slot = (int)(nextRandom(&check->random) % SELF_CHECK_KEYS);
+        if (check->present[slot]) {
+            check->present[slot] = false;
+            deleteFromBPlusTree(check->tree, check->keys[slot]);
+        } else {
+            selfCheckInsert(check, slot, nextRandom(&check->random) & 1);
         }
-        
-        printf("\nShowroom %d: %s\n", i + 1, showroom->name);
-        printf("----------------------------------------\n");
-        printf("ID\tName\t\tSales Achieved\tCommission\n");
-        printf("----------------------------------------\n");
-        
-        int personCount = 0;
-        BPlusTreeNode* current = salesPersonTrees[i]->root;
-        while (current && !current->isLeaf) current = current->children[0];
-        
-        while (current != NULL) {
-            for (int j = 0; j < current->numKeys; j++) {
-                SalesPerson* person = (SalesPerson*)current->data[j];
-                printf("%-8d%-16s%-16.2f%.2f\n",
-                       person->id, person->name, person->salesAchieved, person->commission);
-                personCount++;
-            }
-            current = current->next;
+    }
+}
+
+// Inserts the absent keys of a run in ascending order, exercising the append split
+void selfCheckAscendingInserts(SelfCheck* check) {
+    int start = (int)(nextRandom(&check->random) % SELF_CHECK_KEYS);
+    for (int slot = start; slot < SELF_CHECK_KEYS && slot < start + SELF_CHECK_BATCH; slot++) {
+        if (!check->present[slot]) {
+            selfCheckInsert(check, slot, true);
         }
-        
-        if (personCount == 0) {
-            printf("No salespersons found in this showroom.\n");
+    }
+}
+
+void selfCheckFlipAvailability(SelfCheck* check) {
+    for (int i = 0; i < 32; i++) {
+        int slot = selfCheckPick(check, true);
+        if (slot < 0) break;
+        check->available[slot] = !check->available[slot];
+        setAvailability(check->tree, check->keys[slot], check->available[slot]);
+    }
+}
+
+// Deletes keys lazily and brings about half of them back, either through a plain insert
+// or reviveLazyKey; both reuse the dead slot while it has not been purged
+void selfCheckLazyDeletes(SelfCheck* check) {
+    for (int i = 0; i < 32; i++) {
+        int slot = selfCheckPick(check, true);
+        if (slot < 0) break;
+        check->present[slot] = false;
+        deleteFromBPlusTree(check->tree, check->keys[slot]);
+        uint64_t choice = nextRandom(&check->random) % 4;
+        bool available = nextRandom(&check->random) & 1;
+        if (choice == 0) {
+            selfCheckInsert(check, slot, available);
+        } else if (choice == 1 &&
+                   reviveLazyKey(check->tree, check->keys[slot], (void*)(intptr_t)(slot + 1), available)) {
+            check->present[slot] = true;
+            check->available[slot] = available;
         }
-        printf("Total salespersons: %d\n", personCount);
     }
 }
 
-void displayCustomersForSalesPerson(int showroomId, int salesPersonId) {
-    char salesPersonIdStr[50];
-    sprintf(salesPersonIdStr, "%d_%d", showroomId, salesPersonId);
-    
-    BPlusTree* customerTree = getCustomerTreeForSalesPerson(salesPersonIdStr);
-    if (customerTree == NULL || customerTree->root == NULL) {
-        printf("No customer tree found for salesperson %d in showroom %d.\n", 
-               salesPersonId, showroomId);
-        return;
+// Runs rounds of random operations on a fresh tree and validates it after each one.
+// Returns the number of failed checks.
+int runSelfCheckMode(const char* mode, bool lazyDeletes, int rounds, uint64_t seed) {
+    SelfCheck check = {0};
+    check.tree = createBPlusTree(0);
+    check.tree->lazyDeletes = lazyDeletes;
+    check.keys = (char (*)[20])malloc(SELF_CHECK_KEYS * sizeof(*check.keys));
+    check.present = (bool*)calloc(SELF_CHECK_KEYS, sizeof(bool));
+    check.available = (bool*)calloc(SELF_CHECK_KEYS, sizeof(bool));
+    if (check.keys == NULL || check.present == NULL || check.available == NULL) {
+        fprintf(stderr, "Memory allocation failed for self-check\n");
+        exit(EXIT_FAILURE);
     }
-    
-    printf("\n=== Customers for Salesperson %d in Showroom %d ===\n", 
-           salesPersonId, showroomId);
-    printf("----------------------------------------\n");
-    printf("Name\t\tMobile\t\tCar VIN\t\tPayment\n");
-    printf("----------------------------------------\n");
-    
-    int customerCount = 0;
-    BPlusTreeNode* current = customerTree->root;
-    while (current && !current->isLeaf) current = current->children[0];
-    
-    while (current != NULL) {
-        for (int i = 0; i < current->numKeys; i++) {
-            Customer* customer = (Customer*)current->data[i];
-            printf("%-16s%-16s%-16s%s\n",
-                   customer->name, customer->mobileNo, customer->VIN,
-                   paymentTypeToString(customer->paymentType));
-            customerCount++;
+    check.random = seed ? seed : 1;
+    for (int i = 0; i < SELF_CHECK_KEYS; i++) {
+        sprintf(check.keys[i], "K%06d", i * 7);
+    }
+
+    int kinds = lazyDeletes ? 7 : 5;
+    for (int round = 0; round < rounds && check.errors == 0; round++) {
+        switch (nextRandom(&check.random) % kinds) {
+            case 0: check.step = "batch insert"; selfCheckBatchInsert(&check); break;
+            case 1: check.step = "batch delete"; selfCheckBatchDelete(&check); break;
+            case 2: check.step = "single inserts and deletes"; selfCheckSingleOps(&check); break;
+            case 3: check.step = "ascending inserts"; selfCheckAscendingInserts(&check); break;
+            case 4: check.step = "availability flips"; selfCheckFlipAvailability(&check); break;
+            case 5: check.step = "lazy deletes and revives"; selfCheckLazyDeletes(&check); break;
+            default: check.step = "compaction"; compactBPlusTree(check.tree); break;
         }
-        current = current->next;
+        validateSelfCheckTree(&check);
     }
-    
-    if (customerCount == 0) {
-        printf("No customers found for this salesperson.\n");
+
+    TreeShape shape = {0};
+    shape.minKeys = -1;
+    measureTree(check.tree, &shape);
+    printf("%-14s %d rounds, %d keys, height %d, %ld nodes: %s\n", mode, rounds, check.tree->numKeys,
+           shape.height, shape.nodes, check.errors == 0 ? "ok" : "FAILED");
+    BPlusTreeNode* leaf = leftmostLeaf(check.tree->root);
+    freeInnerNodes(check.tree->root);
+    while (leaf != NULL) {
+        BPlusTreeNode* next = leaf->next;
+        free(leaf);
+        leaf = next;
     }
-    printf("Total customers: %d\n", customerCount);
+    free(check.tree);
+    free(check.keys);
+    free(check.present);
+    free(check.available);
+    return check.errors;
+}
+
+int runSelfCheck(int rounds, uint64_t seed) {
+    int errors = runSelfCheckMode("eager deletes", false, rounds, seed);
+    errors += runSelfCheckMode("lazy deletes", true, rounds, seed);
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 // Main function
-int main() {
+int main(int argc, char* argv[]) {
+    const char* batchFile = NULL;
+    const char* servePath = NULL;
+    const char* loadgenPath = NULL;
+    const char* replicatePath = NULL;
+    const char* followPath = NULL;
+    const char* cdcPath = NULL;
+    const char* cdcReadPath = NULL;
+    const char* consumer = NULL;
+    long cdcMaxEvents = 0;
+    long generateCars = 0, benchmarkOps = 0, selfCheckRounds = 0;
+    uint64_t generateSeed = 1;
+    bool metricsAtExit = false;
+    int commitEvery = 0;
+    bool syncIO = false;
+    int loadClients = 8, loadRequests = 10000;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    reportThreads = cpus > 0 ? (int)cpus : 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            reportThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--single-index") == 0) {
+            singleCarIndex = true;
+        } else if (strcmp(argv[i], "--lazy-delete") == 0 && i + 1 < argc) {
+            lazyDeleteThreshold = atoi(argv[++i]);
+            if (lazyDeleteThreshold < 0) lazyDeleteThreshold = 0;
+            if (lazyDeleteThreshold > B_PLUS_ORDER - 1) lazyDeleteThreshold = B_PLUS_ORDER - 1;
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            metricsAtExit = true;
+        } else if (strcmp(argv[i], "--sync-io") == 0) {
+            syncIO = true;
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchFile = argv[++i];
+        } else if (strcmp(argv[i], "--commit-every") == 0 && i + 1 < argc) {
+            commitEvery = atoi(argv[++i]);
+            if (commitEvery < 0) commitEvery = 0;
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            servePath = argv[++i];
+        } else if (strcmp(argv[i], "--replicate") == 0 && i + 1 < argc) {
+            replicatePath = argv[++i];
+        } else if (strcmp(argv[i], "--follow") == 0 && i + 1 < argc) {
+            followPath = argv[++i];
+        } else if (strcmp(argv[i], "--cdc") == 0 && i + 1 < argc) {
+            cdcPath = argv[++i];
+        } else if (strcmp(argv[i], "--cdc-read") == 0 && i + 1 < argc) {
+            cdcReadPath = argv[++i];
+        } else if (strcmp(argv[i], "--consumer") == 0 && i + 1 < argc) {
+            consumer = argv[++i];
+        } else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            cdcMaxEvents = atol(argv[++i]);
+            if (cdcMaxEvents < 0) cdcMaxEvents = 0;
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            generateCars = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            generateSeed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) {
+            benchmarkOps = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--self-check") == 0 && i + 1 < argc) {
+            selfCheckRounds = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--loadgen") == 0 && i + 1 < argc) {
+            loadgenPath = argv[++i];
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            loadClients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            loadRequests = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--threads N] [--single-index] [--lazy-delete N] [--sync-io] [--cdc FILE] [--metrics] "
+                    "[--batch FILE | --serve SOCKET [--replicate SOCKET]] [--commit-every N]\n"
+                    "       %s --follow SOCKET [--cdc FILE]\n"
+                    "       %s --cdc-read FILE --consumer NAME [--max N]\n"
+                    "       %s --generate CARS [--seed N] | --benchmark N | --self-check ROUNDS [--seed N]\n"
+                    "       %s --loadgen SOCKET [--clients N] [--requests N]\n",
+                    argv[0], argv[0], argv[0], argv[0], argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (loadgenPath != NULL) {
+        runLoadGenerator(loadgenPath, loadClients, loadRequests);
+        return EXIT_SUCCESS;
+    }
+    if (selfCheckRounds > 0) {
+        return runSelfCheck((int)selfCheckRounds, generateSeed);
+    }
+    if (cdcReadPath != NULL) {
+        if (consumer == NULL) {
+            fprintf(stderr, "--cdc-read needs --consumer NAME\n");
+            return EXIT_FAILURE;
+        }
+        return readChangeFeed(cdcReadPath, consumer, cdcMaxEvents);
+    }
+    if (generateCars > 0 && access("cars.txt", F_OK) == 0) {
+        fprintf(stderr, "cars.txt already exists; run --generate in an empty directory.\n");
+        return EXIT_FAILURE;
+    }
+    if (followPath != NULL) {
+        if (batchFile != NULL || servePath != NULL) {
+            fprintf(stderr, "--follow cannot be combined with --batch or --serve\n");
+            return EXIT_FAILURE;
+        }
+        // The primary saves a snapshot into the shared data files before this returns
+        if (!replicaConnect(followPath)) {
+            return EXIT_FAILURE;
+        }
+        batchMode = true;      // Replayed operations print nothing and never save
+        syncIO = true;
+    }
+    if (reportThreads < 1) reportThreads = 1;
+    if (reportThreads > MAX_WORKER_THREADS) reportThreads = MAX_WORKER_THREADS;
+    if (reportThreads > 1) {
+        reportPool = threadPoolCreate(reportThreads);
+    }
+
     carTree = createBPlusTree(1);
-    availableCarTree = createBPlusTree(1);
-    soldCarTree = createBPlusTree(1);
+    enableBloomFilter(carTree);
+    if (!singleCarIndex) {
+        availableCarTree = createBPlusTree(1);
+        soldCarTree = createBPlusTree(1);
+        if (lazyDeleteThreshold >= 0) {
+            availableCarTree->lazyDeletes = true;
+            availableCarTree->minLiveKeys = lazyDeleteThreshold;
+        }
+    }
     showroomTree = createBPlusTree(4);
+    carPriceTree = createBPlusTree(1);
+    salesTimeTree = createBPlusTree(5);
+    customerVinTree = createBPlusTree(2);
+    enableBloomFilter(customerVinTree);
 
     for (int i = 0; i < MAX_SHOWROOMS; i++) {
         salesPersonTrees[i] = createBPlusTree(3);
     }
 
-    loadShowroomsFromFile();
-    loadCarsFromFile();
-    loadSalesPersonsFromFile();
-    loadCustomersFromFile();
+    if (benchmarkOps > 0) {
+        return runBenchmark(benchmarkOps);
+    }
+    if (generateCars == 0) {
+        loadShowroomsFromFile();
+        loadCarsFromFile();
+        loadSalesPersonsFromFile();
+        loadCustomersFromFile();
+        loadSalesRollupsFromFile();
+        if (!loadSalesLogFromFile()) {
+            backfillSalesLogFromCustomers();
+        }
+    }
 
     if (showroomTree->root == NULL) {
-        Showroom showroom1 = {1, "Maruti Suzuki Showroom", "Maruti Suzuki", 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0, 0, 0};
-        Showroom showroom2 = {2, "Hyundai Showroom", "Hyundai", 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0, 0, 0};
-        Showroom showroom3 = {3, "Tata Motors Showroom", "Tata Motors", 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0, 0, 0};
+        Showroom showroom1 = {.id = 1, .name = "Maruti Suzuki Showroom", .manufacturer = "Maruti Suzuki"};
+        Showroom showroom2 = {.id = 2, .name = "Hyundai Showroom", .manufacturer = "Hyundai"};
+        Showroom showroom3 = {.id = 3, .name = "Tata Motors Showroom", .manufacturer = "Tata Motors"};
 
         char showroomId1[20], showroomId2[20], showroomId3[20];
         sprintf(showroomId1, "%d", showroom1.id);
@@ -1485,10 +8490,32 @@ int main() {
 
         saveShowroomsToFile();
     }
+    if (cdcPath != NULL && !cdcOpen(cdcPath)) {
+        return EXIT_FAILURE;
+    }
+    if (!syncIO) {
+        ioStart();
+    }
+    if (replica != NULL) {
+        replicaStart();
+    }
 
     int choice = 0;
-    while (choice != 17) {
+    if (batchFile != NULL) {
+        runBatchFile(batchFile, commitEvery);
+        choice = 27;           // No menu in batch or server mode
+    } else if (servePath != NULL) {
+        runServer(servePath, reportThreads, commitEvery, replicatePath);
+        choice = 27;
+    } else if (generateCars > 0) {
+        generateDataset(generateCars, generateSeed);
+        choice = 27;
+    }
+    while (choice != 27) {
         printf("\n===== Car Showroom Management System =====\n");
+        if (replica != NULL) {
+            printReplicaStatus();
+        }
         printf("1. Add New Car\n");
         printf("2. Add Sales Person\n");
         printf("3. Display Showroom Details\n");
@@ -1505,24 +8532,46 @@ int main() {
         printf("14. Display All Cars Showroom-wise\n");
         printf("15. Display All Salespersons Showroom-wise\n");
         printf("16. Display Customers for Specific Salesperson\n");
-        printf("17. Exit\n");
+        printf("17. Search Cars by Price, Fuel and Body Type\n");
+        printf("18. Search Cars and Customers by Name\n");
+        printf("19. Show Sales for a Recent Period\n");
+        printf("20. Sales Report Between Two Dates\n");
+        printf("21. Forecast Next Month for All Showrooms\n");
+        printf("22. Inventory Value and Sold Ratio Analytics\n");
+        printf("23. List Available Cars\n");
+        printf("24. Loan Quotes, Repayment Schedules and Re-quotes\n");
+        printf("25. Index Statistics and Operation Metrics\n");
+        printf("26. Dealer Feed: Import Cars or Mark Cars Sold\n");
+        printf("27. Exit\n");
         printf("Enter your choice: ");
         scanf("%d", &choice);
 
+        if (replica != NULL) {
+            if (!replicaAllows(choice)) {
+                printf("This is a read-only replica; make changes on the primary.\n");
+                continue;
+            }
+        }
         switch (choice) {
             case 1: {
                 Car newCar;
+                char name[MAX_STRING], color[MAX_STRING];
                 int showroomId;
                 printf("Enter Showroom ID (1-3): ");
                 scanf("%d", &showroomId);
                 printf("Enter Car VIN: ");
                 scanf("%s", newCar.VIN);
                 printf("Enter Car Name: ");
-                scanf(" %[^\n]", newCar.name);
+                scanf(" %99[^\n]", name);
                 printf("Enter Car Color: ");
-                scanf(" %[^\n]", newCar.color);
+                scanf(" %99[^\n]", color);
+                newCar.nameId = internString(name);
+                newCar.colorId = internString(color);
                 printf("Enter Car Price (in lakhs): ");
-                scanf("%lf", &newCar.price);
+                if (!scanLakhs(&newCar.price)) {
+                    printf("Invalid price.\n");
+                    break;
+                }
                 printf("Enter Fuel Type (0-Petrol, 1-Diesel, 2-CNG, 3-Electric, 4-Hybrid): ");
                 int fuelType;
                 scanf("%d", &fuelType);
@@ -1562,15 +8611,19 @@ int main() {
                 scanf("%d", &showroomId);
                 char showroomIdStr[20];
                 sprintf(showroomIdStr, "%d", showroomId);
+                beginReplicaRead();
                 Showroom* showroom = (Showroom*)searchInBPlusTree(showroomTree, showroomIdStr);
                 displayShowroomDetails(showroom);
+                endReplicaRead();
                 break;
             }
             case 4: {
                 char VIN[20];
                 printf("Enter Car VIN: ");
                 scanf("%s", VIN);
+                beginReplicaRead();
                 displayCarByVIN(VIN);
+                endReplicaRead();
                 break;
             }
             case 5: {
@@ -1581,14 +8634,17 @@ int main() {
                 scanf("%d", &personId);
                 char personIdStr[20];
                 sprintf(personIdStr, "%d", personId);
+                beginReplicaRead();
                 SalesPerson* person = (SalesPerson*)searchInBPlusTree(salesPersonTrees[showroomId - 1], personIdStr);
                 displaySalesPersonDetails(person);
+                endReplicaRead();
                 break;
             }
             case 6: {
                 char salesPersonId[50];
                 char VIN[20];
                 Customer newCustomer;
+                char name[MAX_STRING], address[MAX_STRING];
                 int showroomId, personId;
                 printf("Enter Showroom ID (1-3): ");
                 scanf("%d", &showroomId);
@@ -1598,11 +8654,13 @@ int main() {
                 printf("Enter Car VIN: ");
                 scanf("%s", VIN);
                 printf("Enter Customer Name: ");
-                scanf(" %[^\n]", newCustomer.name);
+                scanf(" %99[^\n]", name);
+                newCustomer.name = arenaStrdup(&stringArena, name);
                 printf("Enter Customer Mobile: ");
                 scanf("%s", newCustomer.mobileNo);
                 printf("Enter Customer Address: ");
-                scanf(" %[^\n]", newCustomer.address);
+                scanf(" %99[^\n]", address);
+                newCustomer.address = arenaStrdup(&stringArena, address);
                 printf("Enter Car Registration Number: ");
                 scanf("%s", newCustomer.registrationNo);
                 int paymentType;
@@ -1611,7 +8669,10 @@ int main() {
                 newCustomer.paymentType = (PaymentType)paymentType;
                 if (newCustomer.paymentType == LOAN) {
                     printf("Enter Down Payment (in lakhs): ");
-                    scanf("%lf", &newCustomer.downPayment);
+                    if (!scanLakhs(&newCustomer.downPayment)) {
+                        printf("Invalid down payment.\n");
+                        break;
+                    }
                     printf("Enter EMI Duration (36, 60, or 84 months): ");
                     scanf("%d", &newCustomer.emiMonths);
                 }
@@ -1619,31 +8680,39 @@ int main() {
                 break;
             }
             case 7: {
-                Car* popularCar = findMostPopularCar();
-                if (popularCar != NULL) {
+                beginReplicaRead();
+                int popularCar = findMostPopularCar();
+                if (popularCar >= 0) {
                     printf("\nMost Popular Car Details:\n");
                     displayCarDetails(popularCar);
                 }
+                endReplicaRead();
                 break;
             }
             case 8: {
+                beginReplicaRead();
                 findMostSuccessfulSalesPerson();
+                endReplicaRead();
                 break;
             }
             case 9: {
                 int showroomId;
                 printf("Enter Showroom ID (1-3): ");
                 scanf("%d", &showroomId);
+                beginReplicaRead();
                 predictNextMonthSales(showroomId);
+                endReplicaRead();
                 break;
             }
             case 10: {
+                beginReplicaRead();
                 printCustomersWithEMIInRange();
+                endReplicaRead();
                 break;
             }
             case 11: {
                 int showroomId;
-                double minSales, maxSales;
+                Money minSales, maxSales;
                 printf("Enter Showroom ID (1-3): ");
                 scanf("%d", &showroomId);
                 if (showroomId < 1 || showroomId > MAX_SHOWROOMS || salesPersonTrees[showroomId - 1] == NULL) {
@@ -1651,30 +8720,44 @@ int main() {
                     break;
                 }
                 printf("Enter minimum sales value (in lakhs): ");
-                scanf("%lf", &minSales);
+                bool validRange = scanLakhs(&minSales);
                 printf("Enter maximum sales value (in lakhs): ");
-                scanf("%lf", &maxSales);
+                validRange = scanLakhs(&maxSales) && validRange;
+                if (!validRange) {
+                    printf("Invalid amount.\n");
+                    break;
+                }
+                beginReplicaRead();
                 searchSalesPersonByRange(salesPersonTrees[showroomId - 1], minSales, maxSales);
+                endReplicaRead();
                 break;
             }
             case 12: {
                 BPlusTree* mergedTree = createBPlusTree(4);
+                beginReplicaRead();
                 mergeShowroomTrees(mergedTree, salesPersonTrees[0], salesPersonTrees[1], salesPersonTrees[2]);
+                endReplicaRead();
                 break;
             }
             case 13: {
                 char outputName[MAX_STRING];
                 printf("Enter output filename for merged data (e.g., merged_cars.txt): ");
                 scanf("%s", outputName);
+                beginReplicaRead();
                 mergeAndSortShowroomsByVIN(outputName);
+                endReplicaRead();
                 break;
             }
             case 14: {
+                beginReplicaRead();
                 displayAllCarsShowroomWise();
+                endReplicaRead();
                 break;
             }
             case 15: {
+                beginReplicaRead();
                 displayAllSalesPersonsShowroomWise();
+                endReplicaRead();
                 break;
             }
             case 16: {
@@ -1683,15 +8766,172 @@ int main() {
                 scanf("%d", &showroomId);
                 printf("Enter Sales Person ID: ");
                 scanf("%d", &salesPersonId);
+                beginReplicaRead();
                 displayCustomersForSalesPerson(showroomId, salesPersonId);
+                endReplicaRead();
                 break;
             }
             case 17: {
-                printf("Saving data and exiting...\n");
-                saveCarsToFile();
-                saveCustomersToFile();
-                saveSalesPersonsToFile();
-                saveShowroomsToFile();
+                CarQuery query;
+                int includeSold;
+                printf("Enter Showroom ID (1-3, 0 for all): ");
+                scanf("%d", &query.showroomId);
+                printf("Enter Fuel Type (0-Petrol, 1-Diesel, 2-CNG, 3-Electric, 4-Hybrid, -1 for any): ");
+                scanf("%d", &query.fuelType);
+                printf("Enter Car Type (0-Hatchback, 1-Sedan, 2-SUV, -1 for any): ");
+                scanf("%d", &query.carType);
+                printf("Enter minimum price (in lakhs): ");
+                bool validRange = scanLakhs(&query.minPrice);
+                printf("Enter maximum price (in lakhs): ");
+                validRange = scanLakhs(&query.maxPrice) && validRange;
+                printf("Include sold cars? (0 for No, 1 for Yes): ");
+                scanf("%d", &includeSold);
+                query.includeSold = includeSold != 0;
+                if (!validRange) {
+                    printf("Invalid amount.\n");
+                    break;
+                }
+                beginReplicaRead();
+                displayCarSearchResults(&query);
+                endReplicaRead();
+                break;
+            }
+            case 18: {
+                char text[MAX_STRING];
+                int fuzzy;
+                printf("Enter name or partial name: ");
+                scanf(" %99[^\n]", text);
+                printf("Match type (0 for prefix, 1 for approximate): ");
+                scanf("%d", &fuzzy);
+                beginReplicaRead();
+                displayNameSearchResults(text, fuzzy != 0);
+                endReplicaRead();
+                break;
+            }
+            case 19: {
+                int days;
+                printf("Enter number of days: ");
+                scanf("%d", &days);
+                if (days < 1) {
+                    printf("Number of days must be at least 1.\n");
+                    break;
+                }
+                beginReplicaRead();
+                displayRecentSales(days);
+                endReplicaRead();
+                break;
+            }
+            case 20: {
+                char fromStr[20], toStr[20];
+                time_t from, to;
+                printf("Enter start date (YYYY-MM-DD): ");
+                scanf("%19s", fromStr);
+                printf("Enter end date (YYYY-MM-DD): ");
+                scanf("%19s", toStr);
+                if (!parseDate(fromStr, &from) || !parseDate(toStr, &to)) {
+                    printf("Invalid date. Use YYYY-MM-DD.\n");
+                    break;
+                }
+                beginReplicaRead();
+                displaySalesBetweenDates(from, to + SECONDS_PER_DAY - 1);
+                endReplicaRead();
+                break;
+            }
+            case 21: {
+                beginReplicaRead();
+                displayNetworkForecast();
+                endReplicaRead();
+                break;
+            }
+            case 22: {
+                beginReplicaRead();
+                displayInventoryAnalytics();
+                endReplicaRead();
+                break;
+            }
+            case 23: {
+                beginReplicaRead();
+                displayAvailableCars();
+                endReplicaRead();
+                break;
+            }
+            case 24: {
+                int loanChoice, months;
+                Money principal;
+                double rate;
+                printf("1. Quote all loan products\n2. Repayment schedule\n3. Change a rate and re-quote existing loans\n");
+                printf("Enter your choice: ");
+                scanf("%d", &loanChoice);
+                if (loanChoice == 1) {
+                    printf("Enter Loan Amount (in lakhs): ");
+                    if (!scanLakhs(&principal) || principal <= 0) {
+                        printf("Invalid loan amount.\n");
+                        break;
+                    }
+                    beginReplicaRead();
+                    displayLoanQuotes(principal);
+                    endReplicaRead();
+                } else if (loanChoice == 2) {
+                    printf("Enter Loan Amount (in lakhs): ");
+                    if (!scanLakhs(&principal) || principal <= 0) {
+                        printf("Invalid loan amount.\n");
+                        break;
+                    }
+                    printf("Enter EMI Duration (36, 60, or 84 months): ");
+                    scanf("%d", &months);
+                    beginReplicaRead();
+                    displayAmortizationSchedule(principal, months);
+                    endReplicaRead();
+                } else if (loanChoice == 3) {
+                    printf("Enter EMI Duration (36, 60, or 84 months): ");
+                    scanf("%d", &months);
+                    printf("Enter New Annual Rate (%%): ");
+                    if (scanf("%lf", &rate) != 1 || rate < 0 || rate > 50) {
+                        printf("Invalid rate.\n");
+                        break;
+                    }
+                    if (replica != NULL) {
+                        printf("This is a read-only replica; make changes on the primary.\n");
+                        break;
+                    }
+                    requoteLoans(months, (int)lround(rate * 100));
+                } else {
+                    printf("Invalid choice.\n");
+                }
+                break;
+            }
+            case 25: {
+                beginReplicaRead();
+                displayIndexStatistics();
+                displayMetrics();
+                endReplicaRead();
+                break;
+            }
+            case 26: {
+                int feedChoice;
+                char fileName[256];
+                printf("1. Import cars (VIN,name,color,price,fuel,type,showroom per line)\n");
+                printf("2. Mark cars sold (one VIN per line)\n");
+                printf("Enter your choice: ");
+                scanf("%d", &feedChoice);
+                printf("Enter Feed File Name: ");
+                scanf("%255s", fileName);
+                if (feedChoice == 1) {
+                    importDealerFeed(fileName);
+                } else if (feedChoice == 2) {
+                    bulkMarkCarsSold(fileName);
+                } else {
+                    printf("Invalid choice.\n");
+                }
+                break;
+            }
+            case 27: {
+                if (replica != NULL) {
+                    replicaStop();     // The primary owns the data files
+                } else {
+                    printf("Saving data and exiting...\n");
+                    saveAllToFiles();
+                }
                 printf("Exiting the system. Thank you!\n");
                 break;
             }
@@ -1700,21 +8940,56 @@ int main() {
                 break;
             }
         }
+        // Deferred rebalancing runs here, between commands, rather than inside a sale
+        beginReplicaRead();
+        if (compactionDue(availableCarTree)) {
+            compactBPlusTree(availableCarTree);
+        }
+        endReplicaRead();
+        cdcFlush();
+    }
+    cdcClose();
+    ioStop();
+    if (metricsAtExit) {
+        displayMetrics();
     }
 
+    freeBloomFilter(carTree);
     free(carTree);
     free(availableCarTree);
     free(soldCarTree);
+    free(carPriceTree);
+    for (int i = 0; i < numSaleRecords; i++) {
+        free(salesLog[i]);
+    }
+    free(salesLog);
+    free(salesTimeTree);
+    freeBloomFilter(customerVinTree);
+    free(customerVinTree);
+    for (int i = 0; i <= HYBRID; i++) bitmapFree(&fuelTypeBitmaps[i]);
+    for (int i = 0; i <= SUV; i++) bitmapFree(&carTypeBitmaps[i]);
+    for (int i = 0; i < MAX_SHOWROOMS; i++) bitmapFree(&showroomBitmaps[i]);
+    bitmapFree(&soldCarBitmap);
+    freeCarColumns();
+    freeLoanRateTables();
+    textIndexFree(&carNameIndex);
+    textIndexFree(&customerNameIndex);
     for (int i = 0; i < numSalesPersonTrees; i++) {
+        freeBloomFilter(salesPersonCustomerTrees[i].customerTree);
         free(salesPersonCustomerTrees[i].customerTree);
     }
     free(salesPersonCustomerTrees);
+    free(modelRollups);
+    free(stringDictionary.strings);
+    free(stringDictionary.slots);
+    freeStringArena(&stringArena);
     for (int i = 0; i < MAX_SHOWROOMS; i++) {
         if (salesPersonTrees[i] != NULL) {
             free(salesPersonTrees[i]);
         }
     }
     free(showroomTree);
+    threadPoolDestroy(reportPool);
 
     return 0;
 }
\ No newline at end of file